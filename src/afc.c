@@ -0,0 +1,355 @@
+/*
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License as
+ *  published by the Free Software Foundation; either version 2 of
+ *  the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details:
+ *
+ *  http://www.gnu.org/copyleft/gpl.txt
+ */
+
+#include "afc.h"
+#include "shared.h"
+
+/* State of the automatic frequency control */
+static struct
+{
+  /* Set to restart the AFC at the next sample. It also
+   * restarts on the first sample, as dsp_rate is not set */
+  gboolean reset;
+
+  /* DSP rate and black and white frequencies it is set up for */
+  int dsp_rate, black_freq, white_freq;
+
+  /* Oscillators that mix the signal down to base band
+   * from its center frequency and back up to it, less
+   * the offset, as phasors and their rotation per sample */
+  double
+    down_re, down_im, down_rot_re, down_rot_im,
+    up_re,   up_im,   up_rot_re,   up_rot_im;
+
+  /* Low pass filters of the base band I and Q */
+  afc_biquad_t filter[ 2 ];
+
+  /* Base band sample of the last frequency measurement */
+  double last_i, last_q;
+
+  /* Samples between frequency measurements and count of them */
+  int measure_len, measure_cnt;
+
+  /* Histogram of measured frequencies, its count of
+   * measurements and the count at which it is evaluated */
+  uint32_t histogram[ AFC_NUM_BINS ];
+  int hist_cnt, window_cnt, window_len;
+
+  /* Estimated frequency offset of the signal, Hz */
+  double offset;
+
+} afc;
+
+/*------------------------------------------------------------------------*/
+
+/* Afc_Biquad_Init()
+ *
+ * Sets up a biquad low pass section by the bilinear transform
+ */
+  static void
+Afc_Biquad_Init( afc_biquad_t *biquad, double cutoff, double q )
+{
+  double w0, alpha, a0;
+
+  w0    = M_2PI * cutoff / (double)rc_data.dsp_rate;
+  alpha = sin( w0 ) / ( 2.0 * q );
+  a0    = 1.0 + alpha;
+
+  biquad->b0 = ( 1.0 - cos(w0) ) / 2.0 / a0;
+  biquad->b1 = ( 1.0 - cos(w0) ) / a0;
+  biquad->b2 = biquad->b0;
+  biquad->a1 = -2.0 * cos( w0 ) / a0;
+  biquad->a2 = ( 1.0 - alpha ) / a0;
+  biquad->i1 = biquad->i2 = 0.0;
+  biquad->q1 = biquad->q2 = 0.0;
+
+} /* Afc_Biquad_Init() */
+
+/*------------------------------------------------------------------------*/
+
+/* Afc_Biquad()
+ *
+ * Filters a complex base band sample through a biquad section
+ */
+  static inline void
+Afc_Biquad( afc_biquad_t *biquad, double *i, double *q )
+{
+  double wi, wq;
+
+  wi = *i - biquad->a1 * biquad->i1 - biquad->a2 * biquad->i2;
+  wq = *q - biquad->a1 * biquad->q1 - biquad->a2 * biquad->q2;
+  *i = biquad->b0 * wi +
+    biquad->b1 * biquad->i1 + biquad->b2 * biquad->i2;
+  *q = biquad->b0 * wq +
+    biquad->b1 * biquad->q1 + biquad->b2 * biquad->q2;
+  biquad->i2 = biquad->i1;
+  biquad->i1 = wi;
+  biquad->q2 = biquad->q1;
+  biquad->q1 = wq;
+
+} /* Afc_Biquad() */
+
+/*------------------------------------------------------------------------*/
+
+/* Afc_Set_Offset()
+ *
+ * Sets the rotation of the oscillator that mixes the
+ * base band back up to the center frequency, less offset
+ */
+  static void
+Afc_Set_Offset( double offset )
+{
+  double dphi;
+
+  afc.offset = offset;
+  dphi = M_2PI *
+    ( (double)(afc.black_freq + afc.white_freq) / 2.0 - offset ) /
+    (double)afc.dsp_rate;
+  afc.up_rot_re = cos( dphi );
+  afc.up_rot_im = sin( dphi );
+
+} /* Afc_Set_Offset() */
+
+/*------------------------------------------------------------------------*/
+
+/* Afc_Init()
+ *
+ * Sets up the AFC for the current DSP rate and
+ * black and white frequencies, with no offset
+ */
+  static void
+Afc_Init( void )
+{
+  double dphi;
+
+  afc.dsp_rate   = rc_data.dsp_rate;
+  afc.black_freq = rc_data.black_freq;
+  afc.white_freq = rc_data.white_freq;
+
+  /* Down mixing oscillator at the center frequency */
+  dphi = M_2PI * (double)( afc.black_freq + afc.white_freq ) /
+    2.0 / (double)afc.dsp_rate;
+  afc.down_re     = 1.0;
+  afc.down_im     = 0.0;
+  afc.down_rot_re = cos( dphi );
+  afc.down_rot_im = sin( dphi );
+  afc.up_re       = 1.0;
+  afc.up_im       = 0.0;
+  Afc_Set_Offset( 0.0 );
+
+  /* 4th order Butterworth low pass filters */
+  Afc_Biquad_Init( &afc.filter[0], AFC_CUTOFF, AFC_FILTER_Q1 );
+  Afc_Biquad_Init( &afc.filter[1], AFC_CUTOFF, AFC_FILTER_Q2 );
+
+  afc.measure_len = afc.dsp_rate / AFC_MEASURE_RATE;
+  if( afc.measure_len < 1 ) afc.measure_len = 1;
+  afc.measure_cnt = 0;
+  afc.window_len  = (int)( AFC_WINDOW_SECS *
+      (double)afc.dsp_rate / (double)afc.measure_len );
+  afc.window_cnt  = 0;
+  afc.hist_cnt    = 0;
+  afc.last_i      = 0.0;
+  afc.last_q      = 0.0;
+  memset( afc.histogram, 0, sizeof(afc.histogram) );
+
+  afc.reset = FALSE;
+
+} /* Afc_Init() */
+
+/*------------------------------------------------------------------------*/
+
+/* Afc_Percentile()
+ *
+ * Returns the frequency below which a percentage of the
+ * measurements in the histogram lie, interpolated in its bin
+ */
+  static double
+Afc_Percentile( int percent )
+{
+  double limit, cum = 0.0;
+  int idx;
+
+  limit = (double)( afc.hist_cnt * percent ) / 100.0;
+  for( idx = 0; idx < AFC_NUM_BINS - 1; idx++ )
+  {
+    if( cum + (double)afc.histogram[idx] >= limit ) break;
+    cum += (double)afc.histogram[idx];
+  }
+
+  return( ((double)idx - 0.5 + (limit - cum) /
+        (double)( afc.histogram[idx] ? afc.histogram[idx] : 1 )) *
+      AFC_BIN_HZ - AFC_SPAN_HZ );
+} /* Afc_Percentile() */
+
+/*------------------------------------------------------------------------*/
+
+/* Afc_Estimate()
+ *
+ * Estimates the frequency offset of the signal from the
+ * black and white levels in the histogram of its base band
+ * frequency, if their span is that of a WEFAX signal
+ */
+  static void
+Afc_Estimate( void )
+{
+  double low, high, span, offset;
+
+  /* Too few measurements above the noise */
+  if( afc.hist_cnt < afc.window_len / 2 ) return;
+
+  /* Their span must be about that of black to white,
+   * or the signal is noise, a tone or a flat image */
+  low  = Afc_Percentile( AFC_LOW_PERCENT );
+  high = Afc_Percentile( AFC_HIGH_PERCENT );
+  span = (double)abs( afc.white_freq - afc.black_freq );
+  if( (high - low < AFC_SPAN_MIN * span) ||
+      (high - low > AFC_SPAN_MAX * span) )
+    return;
+
+  /* The center of the span is the offset of the signal */
+  offset = afc.offset + AFC_LOOP_GAIN * ( (high + low) / 2.0 - afc.offset );
+  if( offset >  AFC_MAX_OFFSET ) offset =  AFC_MAX_OFFSET;
+  if( offset < -AFC_MAX_OFFSET ) offset = -AFC_MAX_OFFSET;
+  Afc_Set_Offset( offset );
+
+} /* Afc_Estimate() */
+
+/*------------------------------------------------------------------------*/
+
+/* Afc_Measure()
+ *
+ * Measures the mean frequency of the base band since the
+ * last measurement, from the change in its phase angle,
+ * and adds it to the histogram of the offset estimate
+ */
+  static void
+Afc_Measure( double i, double q )
+{
+  double re, im, freq, mag;
+  int bin;
+
+  /* Base band sample times conjugate of last one */
+  re = i * afc.last_i + q * afc.last_q;
+  im = q * afc.last_i - i * afc.last_q;
+  mag = sqrt( (i * i + q * q) * (afc.last_i * afc.last_i +
+        afc.last_q * afc.last_q) );
+  afc.last_i = i;
+  afc.last_q = q;
+
+  if( mag > AFC_MIN_LEVEL * AFC_MIN_LEVEL )
+  {
+    freq = atan2( im, re ) * (double)afc.dsp_rate /
+      ( M_2PI * (double)afc.measure_len );
+    bin = (int)lround( freq / AFC_BIN_HZ ) + AFC_SPAN_HZ / AFC_BIN_HZ;
+    if( (bin >= 0) && (bin < AFC_NUM_BINS) )
+    {
+      afc.histogram[bin]++;
+      afc.hist_cnt++;
+    }
+  }
+
+  /* Estimate the offset over each window */
+  if( ++afc.window_cnt >= afc.window_len )
+  {
+    Afc_Estimate();
+    memset( afc.histogram, 0, sizeof(afc.histogram) );
+    afc.hist_cnt   = 0;
+    afc.window_cnt = 0;
+  }
+
+} /* Afc_Measure() */
+
+/*------------------------------------------------------------------------*/
+
+/* Afc_Shift()
+ *
+ * Shifts a signal sample by the estimated frequency offset,
+ * so that the black and white levels are at their set
+ * frequencies. The signal is mixed down to a complex base
+ * band, where its frequency is measured, and back up to the
+ * center frequency less the offset. The offset is estimated
+ * from the signal before its correction, so that the loop
+ * is not affected by the correction it makes
+ */
+  void
+Afc_Shift( short *sample )
+{
+  double x, i, q, y, re, mag;
+
+  PERF_BEGIN( PERF_AFC );
+
+  /* Restart on request or change of signal parameters */
+  if( afc.reset ||
+      (afc.dsp_rate   != rc_data.dsp_rate)   ||
+      (afc.black_freq != rc_data.black_freq) ||
+      (afc.white_freq != rc_data.white_freq) )
+    Afc_Init();
+
+  /* Mix signal down to complex base band */
+  x = (double)*sample;
+  i =  x * afc.down_re;
+  q = -x * afc.down_im;
+  re = afc.down_re * afc.down_rot_re - afc.down_im * afc.down_rot_im;
+  afc.down_im =
+    afc.down_re * afc.down_rot_im + afc.down_im * afc.down_rot_re;
+  afc.down_re = re;
+
+  /* Remove the image of the signal at twice its frequency */
+  Afc_Biquad( &afc.filter[0], &i, &q );
+  Afc_Biquad( &afc.filter[1], &i, &q );
+
+  /* Measure the base band frequency and keep the
+   * amplitude of the oscillators from drifting */
+  if( ++afc.measure_cnt >= afc.measure_len )
+  {
+    afc.measure_cnt = 0;
+    Afc_Measure( i, q );
+
+    mag = sqrt( afc.down_re * afc.down_re + afc.down_im * afc.down_im );
+    afc.down_re /= mag;
+    afc.down_im /= mag;
+    mag = sqrt( afc.up_re * afc.up_re + afc.up_im * afc.up_im );
+    afc.up_re /= mag;
+    afc.up_im /= mag;
+  }
+
+  /* Mix base band back up, less the offset. The
+   * real part is doubled for the removed image */
+  y = 2.0 * ( i * afc.up_re - q * afc.up_im );
+  re = afc.up_re * afc.up_rot_re - afc.up_im * afc.up_rot_im;
+  afc.up_im = afc.up_re * afc.up_rot_im + afc.up_im * afc.up_rot_re;
+  afc.up_re = re;
+
+  if( y > SHRT_MAX ) y = SHRT_MAX;
+  if( y < SHRT_MIN ) y = SHRT_MIN;
+  *sample = (short)y;
+
+  PERF_END( PERF_AFC );
+
+} /* Afc_Shift() */
+
+/*------------------------------------------------------------------------*/
+
+/* Afc_Reset()
+ *
+ * Restarts the AFC with no offset, as after retuning
+ */
+  void
+Afc_Reset( void )
+{
+  afc.reset = TRUE;
+} /* Afc_Reset() */
+
+/*------------------------------------------------------------------------*/
+
@@ -0,0 +1,63 @@
+/*
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License as
+ *  published by the Free Software Foundation; either version 2 of
+ *  the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details:
+ *
+ *  http://www.gnu.org/copyleft/gpl.txt
+ */
+
+#ifndef AFC_H
+#define AFC_H   1
+
+#include "common.h"
+
+/* Cutoff of the low pass filters of the
+ * complex base band of the signal, in Hz */
+#define AFC_CUTOFF        900.0
+
+/* Q of the two sections of the 4th order Butterworth filters */
+#define AFC_FILTER_Q1     0.54119610
+#define AFC_FILTER_Q2     1.30656296
+
+/* Rate of instantaneous frequency measurements, per sec */
+#define AFC_MEASURE_RATE  2000
+
+/* Width and range of the frequency histogram bins, in Hz */
+#define AFC_BIN_HZ        10
+#define AFC_SPAN_HZ       1000
+#define AFC_NUM_BINS      ( 2 * AFC_SPAN_HZ / AFC_BIN_HZ + 1 )
+
+/* Duration of each offset estimate, in sec */
+#define AFC_WINDOW_SECS   1.0
+
+/* Percentiles of the histogram taken as the black and white levels */
+#define AFC_LOW_PERCENT   2
+#define AFC_HIGH_PERCENT  98
+
+/* Range of black to white span, as a fraction of the expected
+ * one, for which the histogram is taken to be of a WEFAX signal */
+#define AFC_SPAN_MIN      0.75
+#define AFC_SPAN_MAX      1.25
+
+/* Gain of the offset correction loop and its maximum, in Hz */
+#define AFC_LOOP_GAIN     0.5
+#define AFC_MAX_OFFSET    250.0
+
+/* Samples below this magnitude in the base band are not measured */
+#define AFC_MIN_LEVEL     64.0
+
+/* A biquad section of the base band low pass filters */
+typedef struct
+{
+  double b0, b1, b2, a1, a2; /* Coefficients, normalized to a0 */
+  double i1, i2, q1, q2;     /* I and Q delay lines, direct form II */
+} afc_biquad_t;
+
+#endif
+
@@ -0,0 +1,467 @@
+/*
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License as
+ *  published by the Free Software Foundation; either version 2 of
+ *  the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details:
+ *
+ *  http://www.gnu.org/copyleft/gpl.txt
+ */
+#include "bench.h"
+#include "shared.h"
+#include <time.h>
+
+/* Image for the pixel processing benchmarks */
+static unsigned char *bench_image = NULL;
+
+/*------------------------------------------------------------------------*/
+
+/* Bench_Clock()
+ *
+ * Returns a monotonic time stamp in seconds
+ */
+  static double
+Bench_Clock( void )
+{
+  struct timespec ts;
+
+  clock_gettime( CLOCK_MONOTONIC, &ts );
+  return( (double)ts.tv_sec + (double)ts.tv_nsec / 1.0E9 );
+} /* Bench_Clock() */
+
+/*------------------------------------------------------------------------*/
+
+/* Bench_Synth()
+ *
+ * Starts a benchmark transmission, clean or noisy
+ */
+  static void
+Bench_Synth( int pattern, gboolean noisy )
+{
+  synth_params_t params;
+
+  params.sample_rate     = rc_data.dsp_rate;
+  params.pixels_per_line = rc_data.pixels_per_line;
+  params.ioc_value       = rc_data.ioc_value;
+  params.black_freq      = rc_data.black_freq;
+  params.white_freq      = rc_data.white_freq;
+  params.phasing_lines   = rc_data.phasing_lines;
+  params.image_lines     = rc_data.image_lines;
+  params.lines_per_min   = rc_data.lines_per_min;
+  params.pattern         = pattern;
+  params.snr         = noisy ? BENCH_NOISY_SNR    : SYNTH_NO_NOISE;
+  params.fade_freq   = noisy ? BENCH_NOISY_FADE   : 0.0;
+  params.freq_offset = noisy ? BENCH_NOISY_OFFSET : 0.0;
+  params.clock_error = 0.0;
+
+  Synth_Init( &params );
+} /* Bench_Synth() */
+
+/*------------------------------------------------------------------------*/
+
+/* Benchmarked functions, each runs over a full
+ * transmission or image and returns the units processed */
+
+  static long
+Bench_Synthesizer( void )
+{
+  short sample;
+
+  Bench_Synth( PATTERN_CHECKER, TRUE );
+  while( Synth_Sample(&sample) );
+  return( Synth_Length() );
+}
+
+  static long
+Bench_Zero_Crossing( void )
+{
+  unsigned char level;
+
+  Bench_Synth( PATTERN_CHECKER, FALSE );
+  while( FM_Detect_Zero_Crossing(&level) );
+  return( Synth_Length() );
+}
+
+  static long
+Bench_Zero_Crossing_Noisy( void )
+{
+  unsigned char level;
+
+  Bench_Synth( PATTERN_CHECKER, TRUE );
+  while( FM_Detect_Zero_Crossing(&level) );
+  return( Synth_Length() );
+}
+
+  static long
+Bench_Zero_Crossing_Generic( void )
+{
+  long units;
+
+  /* Detector instance for custom modes */
+  Detect_Specialize( FALSE );
+  units = Bench_Zero_Crossing();
+  Detect_Specialize( TRUE );
+  return( units );
+}
+
+  static long
+Bench_Bilevel( void )
+{
+  unsigned char level;
+
+  Bench_Synth( PATTERN_CHECKER, FALSE );
+  while( FM_Detect_Bilevel(&level) );
+  return( Synth_Length() );
+}
+
+  static long
+Bench_Bilevel_Noisy( void )
+{
+  unsigned char level;
+
+  Bench_Synth( PATTERN_CHECKER, TRUE );
+  while( FM_Detect_Bilevel(&level) );
+  return( Synth_Length() );
+}
+
+  static long
+Bench_Bilevel_Generic( void )
+{
+  long units;
+
+  Detect_Specialize( FALSE );
+  units = Bench_Bilevel();
+  Detect_Specialize( TRUE );
+  return( units );
+}
+
+  static long
+Bench_Zero_Crossing_Fixed( void )
+{
+  long units;
+
+  /* Integer arithmetic detector */
+  SetFlag( FIXED_POINT );
+  units = Bench_Zero_Crossing();
+  ClearFlag( FIXED_POINT );
+  return( units );
+}
+
+  static long
+Bench_Bilevel_Fixed( void )
+{
+  long units;
+
+  SetFlag( FIXED_POINT );
+  units = Bench_Bilevel();
+  ClearFlag( FIXED_POINT );
+  return( units );
+}
+
+  static long
+Bench_Start_Tone( void )
+{
+  /* Full decoder listening for the start tone */
+  FM_Detector = FM_Detect_Zero_Crossing;
+  Bench_Synth( PATTERN_CHECKER, TRUE );
+  while( Start_Tone_Detect() );
+  return( Synth_Length() );
+}
+
+  static long
+Bench_Start_Tone_Standby( void )
+{
+  /* Decimated listener of low power standby */
+  Bench_Synth( PATTERN_CHECKER, TRUE );
+  while( Standby_Listen() );
+  Standby_Reset();
+  return( Synth_Length() );
+}
+
+  static long
+Bench_Zero_Crossing_AFC( void )
+{
+  long units;
+
+  /* Frequency offset corrected in the sample path */
+  Afc_Reset();
+  SetFlag( AFC_ENABLE );
+  units = Bench_Zero_Crossing_Noisy();
+  ClearFlag( AFC_ENABLE );
+  return( units );
+}
+
+#ifdef HAVE_LIBPERSEUS_SDR
+  static long
+Bench_DSP_Filter( void )
+{
+  static filter_data_t filter_data;
+  static double *samples = NULL;
+  short sample;
+  int idx;
+
+  /* Filter a buffer of noisy signal repeatedly */
+  if( samples == NULL )
+  {
+    if( !mem_alloc((void **)&samples, sizeof(double) * BENCH_FILTER_LEN) )
+      return( 0 );
+    Bench_Synth( PATTERN_CHECKER, TRUE );
+    for( idx = 0; idx < BENCH_FILTER_LEN; idx++ )
+    {
+      Synth_Sample( &sample );
+      samples[idx] = (double)sample;
+    }
+
+    filter_data.cutoff   = BENCH_FILTER_CUTOFF;
+    filter_data.ripple   = BENCH_FILTER_RIPPLE;
+    filter_data.npoles   = BENCH_FILTER_POLES;
+    filter_data.type     = FILTER_LOWPASS;
+    filter_data.ring_idx = 0;
+    filter_data.samples_buf     = samples;
+    filter_data.samples_buf_len = BENCH_FILTER_LEN;
+    Init_Chebyshev_Filter( &filter_data );
+  }
+
+  for( idx = 0; idx < BENCH_FILTER_BLOCKS; idx++ )
+    DSP_Filter( &filter_data );
+
+  return( (long)BENCH_FILTER_LEN * BENCH_FILTER_BLOCKS );
+}
+
+  static long
+Bench_DSP_Filter_Fixed( void )
+{
+  static filter_data_t filter_data;
+  static filter_fixed_t filter_fixed;
+  static int32_t *samples = NULL;
+  short sample;
+  int idx;
+
+  /* Filter a buffer of noisy signal repeatedly */
+  if( samples == NULL )
+  {
+    if( !mem_alloc((void **)&samples, sizeof(int32_t) * BENCH_FILTER_LEN) )
+      return( 0 );
+    Bench_Synth( PATTERN_CHECKER, TRUE );
+    for( idx = 0; idx < BENCH_FILTER_LEN; idx++ )
+    {
+      Synth_Sample( &sample );
+      samples[idx] = sample;
+    }
+
+    filter_data.cutoff = BENCH_FILTER_CUTOFF;
+    filter_data.ripple = BENCH_FILTER_RIPPLE;
+    filter_data.npoles = BENCH_FILTER_POLES;
+    filter_data.type   = FILTER_LOWPASS;
+    Init_Chebyshev_Fixed( &filter_data, &filter_fixed );
+    filter_fixed.samples_buf     = samples;
+    filter_fixed.samples_buf_len = BENCH_FILTER_LEN;
+  }
+
+  for( idx = 0; idx < BENCH_FILTER_BLOCKS; idx++ )
+    DSP_Filter_Fixed( &filter_fixed );
+
+  return( (long)BENCH_FILTER_LEN * BENCH_FILTER_BLOCKS );
+}
+#endif
+
+  static long
+Bench_Resampler( void )
+{
+  static resampler_t resampler;
+  static short *samples = NULL, *out = NULL;
+  static long len = 0;
+  long idx;
+
+  /* Resample a noisy transmission block by block */
+  if( samples == NULL )
+  {
+    Bench_Synth( PATTERN_CHECKER, TRUE );
+    len = Synth_Length();
+    if( !mem_alloc((void **)&samples, sizeof(short) * (size_t)len) ||
+        !mem_alloc((void **)&out, sizeof(short) * BENCH_RESAMPLE_LEN) )
+      return( 0 );
+    for( idx = 0; idx < len; idx++ )
+      Synth_Sample( &samples[idx] );
+  }
+
+  if( !Resample_Init(&resampler,
+        BENCH_RATE, BENCH_RESAMPLE_RATE, BENCH_RESAMPLE_LEN) )
+    return( 0 );
+  for( idx = 0; idx + BENCH_RESAMPLE_LEN <= len; idx += BENCH_RESAMPLE_LEN )
+    Resample( &resampler, &samples[idx], BENCH_RESAMPLE_LEN, out );
+
+  return( idx );
+}
+
+  static long
+Bench_Zero_Crossing_Resampled( void )
+{
+  long units;
+
+  /* Detector at the lower DSP rate of resampling */
+  rc_data.dsp_rate = BENCH_RESAMPLE_RATE;
+  Set_Pixel_Len();
+  units = Bench_Zero_Crossing_Noisy();
+  rc_data.dsp_rate = BENCH_RATE;
+  Set_Pixel_Len();
+  return( units );
+}
+
+  static long
+Bench_Normalize( void )
+{
+  static unsigned char *line = NULL;
+  int idx, len = rc_data.pixels_per_line;
+
+  if( (line == NULL) && !mem_alloc((void **)&line, (size_t)len) )
+    return( 0 );
+
+  for( idx = 0; idx < rc_data.image_lines; idx++ )
+  {
+    memcpy( line, &bench_image[idx * len], (size_t)len );
+    Normalize( line, len );
+  }
+
+  return( (long)rc_data.image_lines * len );
+}
+
+  static long
+Bench_JPEG_Encoder( void )
+{
+  FILE *fp = fopen( "/dev/null", "w" );
+
+  if( (fp == NULL) || !Save_Image_JPEG(fp,
+        rc_data.pixels_per_line, rc_data.image_lines, bench_image) )
+    return( 0 );
+
+  return( (long)rc_data.image_lines * rc_data.pixels_per_line );
+}
+
+/*------------------------------------------------------------------------*/
+
+/* Bench_Configure()
+ *
+ * Sets up runtime data for the benchmarks
+ */
+  static gboolean
+Bench_Configure( void )
+{
+  int line, pix;
+
+  rc_data.dsp_rate        = BENCH_RATE;
+  rc_data.num_chn         = 1;
+  rc_data.use_chn         = 0;
+  rc_data.tcvr_type       = NONE;
+  rc_data.lines_per_min   = BENCH_RPM;
+  rc_data.pixels_per_line = BENCH_PIXELS;
+  rc_data.ioc_value       = BENCH_IOC;
+  rc_data.start_tone      = IOC576_START_TONE;
+  rc_data.black_freq      = 1500;
+  rc_data.white_freq      = 2300;
+  rc_data.phasing_lines   = BENCH_PHASING;
+  rc_data.image_lines     = BENCH_LINES;
+  rc_data.sync_slant      = 0.0;
+
+  /* Take samples from synthesizer, without the GUI */
+  SetFlag( HEADLESS );
+  SetFlag( SYNTH_SOURCE );
+  SetFlag( DISPLAY_SIGNAL );
+  Configure();
+
+  /* Image of the pixel processing benchmarks */
+  if( !mem_alloc((void **)&bench_image,
+        (size_t)(BENCH_LINES * BENCH_PIXELS)) )
+    return( FALSE );
+  Bench_Synth( PATTERN_GRADIENT, FALSE );
+  for( line = 0; line < BENCH_LINES; line++ )
+    for( pix = 0; pix < BENCH_PIXELS; pix++ )
+      bench_image[line * BENCH_PIXELS + pix] = Synth_Pixel( line, pix );
+
+  return( TRUE );
+} /* Bench_Configure() */
+
+/*------------------------------------------------------------------------*/
+
+/* Bench_Run()
+ *
+ * Times the signal detectors, filter and encoders on
+ * synthetic transmissions and prints their throughput
+ */
+  int
+Bench_Run( void )
+{
+  static const bench_case_t cases[] =
+  {
+    { "Signal Synthesizer",           "samples", Bench_Synthesizer },
+    { "Zero Crossing Detector",       "samples", Bench_Zero_Crossing },
+    { "Zero Crossing Detector noisy", "samples", Bench_Zero_Crossing_Noisy },
+    { "Zero Crossing Detector generic", "samples", Bench_Zero_Crossing_Generic },
+    { "Bilevel Detector",             "samples", Bench_Bilevel },
+    { "Bilevel Detector noisy",       "samples", Bench_Bilevel_Noisy },
+    { "Bilevel Detector generic",     "samples", Bench_Bilevel_Generic },
+    { "Zero Crossing Detector fixed", "samples", Bench_Zero_Crossing_Fixed },
+    { "Bilevel Detector fixed",       "samples", Bench_Bilevel_Fixed },
+    { "Zero Crossing Detector AFC",   "samples", Bench_Zero_Crossing_AFC },
+    { "Start Tone Detector",          "samples", Bench_Start_Tone },
+    { "Start Tone Standby",           "samples", Bench_Start_Tone_Standby },
+    { "Resampler 48 to 12 kHz",       "samples", Bench_Resampler },
+    { "Zero Crossing Detector 12 kHz", "samples",
+      Bench_Zero_Crossing_Resampled },
+#ifdef HAVE_LIBPERSEUS_SDR
+    { "DSP Filter",                   "samples", Bench_DSP_Filter },
+    { "DSP Filter fixed",             "samples", Bench_DSP_Filter_Fixed },
+#endif
+    { "Normalize",                    "pixels",  Bench_Normalize },
+    { "JPEG Encoder",                 "pixels",  Bench_JPEG_Encoder },
+  };
+
+  double start, secs, best, rate;
+  long units = 0;
+  size_t cas;
+  int run;
+
+  if( !Bench_Configure() ) return( -1 );
+
+  printf( "%s DSP benchmark: %d samples/sec, %.0f RPM, "
+      "%d pixels/line, %d lines\n", PACKAGE_STRING,
+      BENCH_RATE, BENCH_RPM, BENCH_PIXELS, BENCH_LINES );
+  printf( "Noisy signal: SNR %.0f dB, fading %.1f Hz, offset %.0f Hz\n",
+      BENCH_NOISY_SNR, BENCH_NOISY_FADE, BENCH_NOISY_OFFSET );
+  printf( "DSP kernels: %s\n\n", DSP_Kernels->name );
+
+  for( cas = 0; cas < sizeof(cases) / sizeof(cases[0]); cas++ )
+  {
+    /* Best of several runs */
+    best = 0.0;
+    for( run = 0; run < BENCH_RUNS; run++ )
+    {
+      start = Bench_Clock();
+      units = cases[cas].run();
+      secs  = Bench_Clock() - start;
+      if( (units <= 0) || (secs <= 0.0) ) break;
+
+      rate = (double)units / secs;
+      if( best < rate ) best = rate;
+    }
+
+    if( best == 0.0 )
+    {
+      printf( "%-30s failed\n", cases[cas].name );
+      return( -1 );
+    }
+
+    printf( "%-30s %10ld %-7s %9.3f M%s/sec\n", cases[cas].name,
+        units, cases[cas].unit, best / 1.0E6, cases[cas].unit );
+  }
+
+  free_ptr( (void **)&bench_image );
+  return( 0 );
+} /* Bench_Run() */
+
+/*------------------------------------------------------------------------*/
+
@@ -0,0 +1,56 @@
+/*
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License as
+ *  published by the Free Software Foundation; either version 2 of
+ *  the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details:
+ *
+ *  http://www.gnu.org/copyleft/gpl.txt
+ */
+#ifndef BENCH_H
+#define BENCH_H     1
+
+#include "common.h"
+
+/* Parameters of benchmark transmissions */
+#define BENCH_RATE          48000
+#define BENCH_RPM           120.0
+#define BENCH_PIXELS        1200
+#define BENCH_IOC           576
+#define BENCH_PHASING       20
+#define BENCH_LINES         200
+
+/* Impairments of the noisy benchmark transmission */
+#define BENCH_NOISY_SNR     10.0
+#define BENCH_NOISY_FADE    0.2
+#define BENCH_NOISY_OFFSET  30.0
+
+/* Number of runs of each benchmark, the fastest is reported */
+#define BENCH_RUNS          3
+
+/* Parameters of the recursive filter benchmark */
+#define BENCH_FILTER_POLES  8
+#define BENCH_FILTER_RIPPLE 10.0
+#define BENCH_FILTER_CUTOFF 0.05
+#define BENCH_FILTER_LEN    32768
+#define BENCH_FILTER_BLOCKS 64
+
+/* Parameters of the resampler benchmark, from the
+ * benchmark rate to a lower DSP rate, in blocks */
+#define BENCH_RESAMPLE_RATE   12000
+#define BENCH_RESAMPLE_LEN    4096
+
+/* A benchmark case, returns the number of units processed */
+typedef struct
+{
+  const char *name; /* Name of benchmarked function */
+  const char *unit; /* Units processed, samples or pixels */
+  long ( *run )( void );
+} bench_case_t;
+
+#endif
+
@@ -30,6 +30,7 @@ static GtkWidget
 Error_Dialog( char *mesg, gboolean hide )
 {
   GtkBuilder *builder;
+  if( isFlagSet(HEADLESS) ) return;
   if( !error_dialog )
   {
     error_dialog = create_error_dialog( &builder );
@@ -68,6 +69,8 @@ on_main_window_destroy(
 {
   SetFlag( RECEIVE_STOP );
   SetFlag( XWEFAX_QUIT );
+  if( isFlagSet(SAVE_SPECTRUM) )
+    Save_Spectrum_Settings();
   Cleanup();
   gtk_main_quit();
 }
@@ -284,6 +287,15 @@ on_enhance_activate(
 }
 
 
+  void
+on_spectrum_activate(
+    GtkMenuItem *menuitem,
+    gpointer     user_data)
+{
+  New_Spectrum_Settings();
+}
+
+
   void
 on_deslant_spinbutton_value_changed(
     GtkSpinButton *spinbutton,
@@ -306,6 +318,60 @@ on_in_image_phasing_activate(
 }
 
 
+  void
+on_auto_deslant_activate(
+    GtkMenuItem *menuitem,
+    gpointer     user_data)
+{
+  if( gtk_check_menu_item_get_active(GTK_CHECK_MENU_ITEM(menuitem)) )
+    SetFlag( AUTO_DESLANT );
+  else
+    ClearFlag( AUTO_DESLANT );
+}
+
+
+  void
+on_auto_ioc_rpm_activate(
+    GtkMenuItem *menuitem,
+    gpointer     user_data)
+{
+  if( gtk_check_menu_item_get_active(GTK_CHECK_MENU_ITEM(menuitem)) )
+    SetFlag( AUTO_IOC_RPM );
+  else
+    ClearFlag( AUTO_IOC_RPM );
+}
+
+
+  void
+on_afc_activate(
+    GtkMenuItem *menuitem,
+    gpointer     user_data)
+{
+  if( gtk_check_menu_item_get_active(GTK_CHECK_MENU_ITEM(menuitem)) )
+  {
+    Afc_Reset();
+    SetFlag( AFC_ENABLE );
+  }
+  else
+    ClearFlag( AFC_ENABLE );
+}
+
+
+  void
+on_low_power_standby_activate(
+    GtkMenuItem *menuitem,
+    gpointer     user_data)
+{
+  if( gtk_check_menu_item_get_active(GTK_CHECK_MENU_ITEM(menuitem)) )
+    SetFlag( LOW_POWER_STANDBY );
+  else
+  {
+    ClearFlag( LOW_POWER_STANDBY );
+    Standby_Reset();
+  }
+}
+
+
   gboolean
 on_wefax_drawingarea_button_press_event(
     GtkWidget      *widget,
@@ -322,13 +388,26 @@ on_wefax_drawingarea_draw(
     cairo_t   *cr,
     gpointer   user_data)
 {
-  if( wefax_pixbuf != NULL )
-  {
-    gdk_cairo_set_source_pixbuf( cr, wefax_pixbuf, 0.0, 0.0 );
-    cairo_paint( cr );
-    return( TRUE );
-  }
-  return( FALSE );
+  return( Viewer_Draw(cr) );
+}
+
+
+  gboolean
+on_wefax_drawingarea_scroll_event(
+    GtkWidget      *widget,
+    GdkEventScroll *event,
+    gpointer        user_data)
+{
+  return( Viewer_Scroll(event) );
+}
+
+
+  void
+on_zoom_activate(
+    GtkMenuItem *menuitem,
+    gpointer     user_data)
+{
+  New_Image_Zoom();
 }
 
 
@@ -484,6 +563,27 @@ on_both_activate(
 }
 
 
+  void
+on_save_raw_activate(
+    GtkMenuItem *menuitem,
+    gpointer     user_data)
+{
+  if( gtk_check_menu_item_get_active(GTK_CHECK_MENU_ITEM(menuitem)) )
+    SetFlag( SAVE_IMAGE_RAW );
+  else
+    ClearFlag( SAVE_IMAGE_RAW );
+}
+
+
+  void
+on_record_activate(
+    GtkMenuItem *menuitem,
+    gpointer     user_data)
+{
+  New_Record_Settings();
+}
+
+
   void
 on_zerocrossing_activate(
     GtkMenuItem *menuitem,
@@ -530,3 +630,30 @@ on_save_checkbutton_toggled(
   }
 }
 
+
+  void
+on_performance_activate(
+    GtkMenuItem *menuitem,
+    gpointer     user_data)
+{
+  Perf_Window();
+}
+
+
+  void
+on_perf_window_destroy(
+    GObject  *object,
+    gpointer  user_data)
+{
+  perf_window = NULL;
+}
+
+
+  void
+on_perf_reset_button_clicked(
+    GtkButton *button,
+    gpointer   user_data)
+{
+  Perf_Reset();
+}
+
@@ -668,6 +668,9 @@ Tune_Tcvr( double x )
     if( !Write_Rx_Freq(tcvr_freq) ) return( FALSE );
   }
 
+  /* The retuning replaces the correction of the AFC */
+  Afc_Reset();
+
   return( TRUE );
 } /* Tune_Tcvr() */
 
@@ -0,0 +1,331 @@
+/*
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License as
+ *  published by the Free Software Foundation; either version 2 of
+ *  the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details:
+ *
+ *  http://www.gnu.org/copyleft/gpl.txt
+ */
+
+#include "channel.h"
+#include "shared.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <time.h>
+
+/* Shared samples of the channels served to other instances */
+static channel_shm_t *served_shm[ CHANNEL_MAX ];
+
+/* Shared samples of the channel taken from another instance */
+static channel_shm_t *client_shm = NULL;
+
+/* Channel decoded from another instance, -1 if none */
+static int client_chn = -1;
+
+/* Count of samples read by the client */
+static unsigned int read_idx = 0;
+
+/*------------------------------------------------------------------------*/
+
+/* Channel_Map()
+ *
+ * Opens and maps the shared memory object of a channel,
+ * creating it if requested. Returns NULL on failure
+ */
+  static channel_shm_t *
+Channel_Map( int chn, gboolean create )
+{
+  channel_shm_t *shm;
+  char name[32];
+  int fd;
+
+  snprintf( name, sizeof(name), CHANNEL_SHM_NAME, chn );
+
+  /* A new object replaces any left by an instance that died */
+  if( create )
+  {
+    shm_unlink( name );
+    fd = shm_open( name, O_CREAT | O_EXCL | O_RDWR, 0600 );
+    if( (fd >= 0) && (ftruncate(fd, sizeof(channel_shm_t)) < 0) )
+    {
+      close( fd );
+      shm_unlink( name );
+      fd = -1;
+    }
+  }
+  else fd = shm_open( name, O_RDWR, 0 );
+  if( fd < 0 ) return( NULL );
+
+  shm = mmap( NULL, sizeof(channel_shm_t),
+      PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+  close( fd );
+  if( shm == MAP_FAILED )
+  {
+    if( create ) shm_unlink( name );
+    return( NULL );
+  }
+
+  return( shm );
+} /* Channel_Map() */
+
+/*------------------------------------------------------------------------*/
+
+/* Channel_Unmap()
+ *
+ * Unmaps the shared memory object of a channel
+ * and removes it if it is served by this instance
+ */
+  static void
+Channel_Unmap( channel_shm_t *shm, int chn, gboolean served )
+{
+  char name[32];
+
+  munmap( shm, sizeof(channel_shm_t) );
+  if( served )
+  {
+    snprintf( name, sizeof(name), CHANNEL_SHM_NAME, chn );
+    shm_unlink( name );
+  }
+
+} /* Channel_Unmap() */
+
+/*------------------------------------------------------------------------*/
+
+/* Channel_Serve_Open()
+ *
+ * Creates the shared samples ring of a channel not
+ * decoded here, for another instance to decode, with
+ * the DSP rate its samples are served at
+ */
+  gboolean
+Channel_Serve_Open( int chn, int dsp_rate )
+{
+  channel_shm_t *shm;
+
+  if( (chn < 0) || (chn >= CHANNEL_MAX) ) return( FALSE );
+  if( served_shm[chn] != NULL )
+  {
+    served_shm[chn]->dsp_rate = dsp_rate;
+    return( TRUE );
+  }
+
+  shm = Channel_Map( chn, TRUE );
+  if( shm == NULL )
+  {
+    perror( "xwefax: Channel_Serve_Open()" );
+    return( FALSE );
+  }
+
+  shm->dsp_rate = dsp_rate;
+  atomic_init( &shm->write_idx, 0 );
+  atomic_init( &shm->write_end, 0 );
+  if( sem_init(&shm->data_ready, 1, 0) < 0 )
+  {
+    perror( "xwefax: Channel_Serve_Open()" );
+    Channel_Unmap( shm, chn, TRUE );
+    return( FALSE );
+  }
+  served_shm[chn] = shm;
+
+  return( TRUE );
+} /* Channel_Serve_Open() */
+
+/*------------------------------------------------------------------------*/
+
+/* Channel_Serve()
+ *
+ * Writes samples of a served channel to its shared ring,
+ * the client drops behind if it is not keeping up
+ */
+  void
+Channel_Serve( int chn, const short *samples, int len )
+{
+  channel_shm_t *shm = served_shm[chn];
+  unsigned int widx;
+  int idx, sval;
+
+  if( shm == NULL ) return;
+
+  /* Publish the end of the block before writing it, so that
+   * a client copying slots the block overwrites sees it */
+  widx = atomic_load_explicit( &shm->write_idx, memory_order_relaxed );
+  atomic_store_explicit( &shm->write_end,
+      widx + (unsigned int)len, memory_order_relaxed );
+  atomic_thread_fence( memory_order_release );
+  for( idx = 0; idx < len; idx++ )
+    shm->ring[ (widx + (unsigned int)idx) & CHANNEL_RING_MASK ] =
+      samples[idx];
+  atomic_store_explicit( &shm->write_idx,
+      widx + (unsigned int)len, memory_order_release );
+
+  /* Wake up a waiting client */
+  sem_getvalue( &shm->data_ready, &sval );
+  if( !sval ) sem_post( &shm->data_ready );
+
+} /* Channel_Serve() */
+
+/*------------------------------------------------------------------------*/
+
+/* Channel_Client()
+ *
+ * Selects a channel to decode from another instance
+ */
+  void
+Channel_Client( int chn )
+{
+  client_chn = chn;
+  SetFlag( CHANNEL_CLIENT );
+} /* Channel_Client() */
+
+/*------------------------------------------------------------------------*/
+
+/* Channel_Attach()
+ *
+ * Attaches the client to the shared ring of its channel
+ */
+  gboolean
+Channel_Attach( char *mesg )
+{
+  if( client_shm != NULL ) return( TRUE );
+
+  if( (client_chn < 0) || (client_chn >= CHANNEL_MAX) ||
+      ((client_shm = Channel_Map(client_chn, FALSE)) == NULL) )
+  {
+    snprintf( mesg, MESG_SIZE,
+        _("Channel %d is not served by another xwefax"), client_chn );
+    return( FALSE );
+  }
+
+  if( client_shm->dsp_rate != rc_data.dsp_rate )
+  {
+    snprintf( mesg, MESG_SIZE,
+        _("Channel %d is served at %d samples/sec, not %d"),
+        client_chn, client_shm->dsp_rate, rc_data.dsp_rate );
+    Channel_Unmap( client_shm, client_chn, FALSE );
+    client_shm = NULL;
+    return( FALSE );
+  }
+
+  /* Start from the newest samples */
+  read_idx = atomic_load_explicit(
+      &client_shm->write_idx, memory_order_acquire );
+
+  return( TRUE );
+} /* Channel_Attach() */
+
+/*------------------------------------------------------------------------*/
+
+/* Channel_Read()
+ *
+ * Reads samples of the client's channel from the shared
+ * ring, waiting for them. Returns FALSE on time out. If
+ * reception is stopped while waiting, returns silence so
+ * that the decoder gets back to handle the stop
+ */
+  gboolean
+Channel_Read( short *samples, int len )
+{
+  struct timespec ts;
+  unsigned int widx;
+  int idx, waited = 0;
+
+  while( TRUE )
+  {
+    widx = atomic_load_explicit(
+        &client_shm->write_idx, memory_order_acquire );
+
+    /* Drop samples overwritten while the decoder lagged */
+    if( widx - read_idx > CHANNEL_RING_SIZE - (unsigned int)len )
+    {
+      fprintf( stderr, "xwefax: Channel_Read(): "
+          "dropped %u samples\n", widx - read_idx - (unsigned int)len );
+      read_idx = widx - (unsigned int)len;
+    }
+
+    if( widx - read_idx >= (unsigned int)len )
+    {
+      for( idx = 0; idx < len; idx++ )
+        samples[idx] = client_shm->ring[ (read_idx + (unsigned int)idx) &
+          CHANNEL_RING_MASK ];
+
+      /* As in a seqlock, the block is good unless the server
+       * wrote or was writing over its start while it was copied */
+      atomic_thread_fence( memory_order_acquire );
+      widx = atomic_load_explicit(
+          &client_shm->write_end, memory_order_relaxed );
+      if( widx - read_idx <= CHANNEL_RING_SIZE )
+      {
+        read_idx += (unsigned int)len;
+        return( TRUE );
+      }
+
+      fprintf( stderr, "xwefax: Channel_Read(): "
+          "block overwritten while read, retrying\n" );
+      continue;
+    }
+
+    /* Wait for the serving instance in short slices,
+     * letting the GUI run between them */
+    clock_gettime( CLOCK_REALTIME, &ts );
+    ts.tv_nsec += CHANNEL_WAIT_MSEC * 1000000L;
+    if( ts.tv_nsec >= 1000000000L )
+    {
+      ts.tv_sec++;
+      ts.tv_nsec -= 1000000000L;
+    }
+    if( (sem_timedwait(&client_shm->data_ready, &ts) < 0) &&
+        (errno == ETIMEDOUT) )
+    {
+      waited += CHANNEL_WAIT_MSEC;
+      if( waited >= CHANNEL_TIMEOUT * 1000 )
+      {
+        fprintf( stderr, "xwefax: Channel_Read(): "
+            "channel %d is no longer served\n", client_chn );
+        return( FALSE );
+      }
+
+      if( isFlagClear(HEADLESS) )
+        while( g_main_context_iteration(NULL, FALSE) );
+      if( isFlagSet(RECEIVE_STOP) )
+      {
+        bzero( (void *)samples, (size_t)len * sizeof(short) );
+        return( TRUE );
+      }
+    }
+  } /* while( TRUE ) */
+
+} /* Channel_Read() */
+
+/*------------------------------------------------------------------------*/
+
+/* Channel_Close()
+ *
+ * Unmaps the shared rings, removing those served
+ */
+  void
+Channel_Close( void )
+{
+  int chn;
+
+  for( chn = 0; chn < CHANNEL_MAX; chn++ )
+    if( served_shm[chn] != NULL )
+    {
+      Channel_Unmap( served_shm[chn], chn, TRUE );
+      served_shm[chn] = NULL;
+    }
+
+  if( client_shm != NULL )
+  {
+    Channel_Unmap( client_shm, client_chn, FALSE );
+    client_shm = NULL;
+  }
+
+} /* Channel_Close() */
+
+/*------------------------------------------------------------------------*/
@@ -0,0 +1,48 @@
+/*
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License as
+ *  published by the Free Software Foundation; either version 2 of
+ *  the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details:
+ *
+ *  http://www.gnu.org/copyleft/gpl.txt
+ */
+
+#ifndef CHANNEL_H
+#define CHANNEL_H   1
+
+#include "common.h"
+#include <stdatomic.h>
+
+/* Name of the shared memory object serving a channel */
+#define CHANNEL_SHM_NAME    "/xwefax-channel%d"
+
+/* Channels that can be served, the two sound card
+ * channels followed by those of the Perseus channelizer */
+#define CHANNEL_MAX         8
+
+/* Length of the shared samples ring, a power of 2 */
+#define CHANNEL_RING_SIZE   65536
+#define CHANNEL_RING_MASK   ( CHANNEL_RING_SIZE - 1 )
+
+/* Time to wait for samples from the serving instance, sec,
+ * and the slices it is waited in, between which the GUI runs */
+#define CHANNEL_TIMEOUT     2
+#define CHANNEL_WAIT_MSEC   50
+
+/* Samples of a sound card channel, captured by one xwefax
+ * instance and shared with another that decodes them */
+typedef struct
+{
+  int dsp_rate;           /* Sample rate of the channel */
+  atomic_uint write_idx;  /* Count of samples written, wrapping */
+  atomic_uint write_end;  /* End of the samples being written */
+  sem_t data_ready;       /* Posted as samples are written */
+  short ring[ CHANNEL_RING_SIZE ];
+} channel_shm_t;
+
+#endif
@@ -39,30 +39,54 @@
 #define MESG_SIZE   128
 
 /* DFT parameter definitions */
-#define DFT_INPUT_SIZE   2550 /* Size of dft input samples array */
 #define DFT_UPPER_FREQ   2400 /* Frequency at upper end of DFT display */
 #define DFT_LOWER_FREQ   1200 /* Frequency at lower end of DFT display */
-#define DFT_FREQ_MULTP      2 /* Ratio of above frequencies for DFT display */
-
-/* Flow control flags */
-#define CAPTURE_SETUP    0x00000001 /* Sound card capture has been set up */
-#define MIXER_SETUP      0x00000002 /* Sound card Mixer has been set-up */
-#define RECEIVE_STOP     0x00000004 /* Stop WEFAX reception and clean up */
-#define SKIP_ACTION      0x00000008 /* Skip current action */
-#define INIMAGE_PHASING  0x00000010 /* Enable In-Image phasing pulse detection */
-#define SAVE_IMAGE_PGM   0x00000020 /* Save the image buffer to PGM file */
-#define SAVE_IMAGE_JPG   0x00000040 /* Save the image buffer to JPG file */
-#define ENABLE_CAT       0x00000080 /* Enable CAT for transceiver */
-#define CAT_SETUP        0x00000100 /* CAT is set up */
-#define TCVR_SERIAL_TEST 0x00000200 /* Serial port is under test */
-#define XWEFAX_QUIT      0x00000400 /* Xwefax in quit sequence */
-#define SAVE_STATIONS    0x00000800 /* Save the stations list */
-#define STATIONS_LIST_OK 0x00001000 /* Stations List is ready */
-#define DISPLAY_SIGNAL   0x00002000 /* Display detector output */
-#define ENABLE_SCOPE     0x00004000 /* Signal scope data ready to plot */
-#define START_NEW_IMAGE  0x00008000 /* Restart WEFAX image decoder after params change */
-#define SAVE_IMAGE       0x00010000 /* Enable saving of WEFAX image */
-#define PERSEUS_INIT     0x00020000 /* Perseus receiver initialized */
+
+/* Flow control flags. Each subsystem's flags are held in an atomic
+ * word of their own, in a separate cache line. The top byte of a flag
+ * selects its subsystem's word and the low bits the flag in the word */
+#define FLAGS_GROUP_SHIFT 24
+#define FLAGS_BITS        0x00ffffff
+#define FLAGS_CONTROL     0x00000000 /* Control of decoder by the GUI */
+#define FLAGS_DEVICE      0x01000000 /* Signal sources and CAT */
+#define FLAGS_DISPLAY     0x02000000 /* Signal and stations displays */
+#define FLAGS_IMAGE       0x03000000 /* Image decoding and saving */
+#define NUM_FLAG_GROUPS   4
+
+#define RECEIVE_STOP     ( FLAGS_CONTROL | 0x0001 ) /* Stop WEFAX reception and clean up */
+#define SKIP_ACTION      ( FLAGS_CONTROL | 0x0002 ) /* Skip current action */
+#define XWEFAX_QUIT      ( FLAGS_CONTROL | 0x0004 ) /* Xwefax in quit sequence */
+#define SAVE_STATIONS    ( FLAGS_CONTROL | 0x0008 ) /* Save the stations list */
+#define START_NEW_IMAGE  ( FLAGS_CONTROL | 0x0010 ) /* Restart WEFAX image decoder after params change */
+#define LOW_POWER_STANDBY ( FLAGS_CONTROL | 0x0020 ) /* Listen for start tone in low power standby */
+#define SAVE_SPECTRUM    ( FLAGS_CONTROL | 0x0040 ) /* Save the spectrum settings to xwefaxrc */
+
+#define CAPTURE_SETUP    ( FLAGS_DEVICE | 0x0001 ) /* Sound card capture has been set up */
+#define MIXER_SETUP      ( FLAGS_DEVICE | 0x0002 ) /* Sound card Mixer has been set-up */
+#define ENABLE_CAT       ( FLAGS_DEVICE | 0x0004 ) /* Enable CAT for transceiver */
+#define CAT_SETUP        ( FLAGS_DEVICE | 0x0008 ) /* CAT is set up */
+#define TCVR_SERIAL_TEST ( FLAGS_DEVICE | 0x0010 ) /* Serial port is under test */
+#define PERSEUS_INIT     ( FLAGS_DEVICE | 0x0020 ) /* Perseus receiver initialized */
+#define SYNTH_SOURCE     ( FLAGS_DEVICE | 0x0040 ) /* Take signal samples from synthesizer */
+#define FIXED_POINT      ( FLAGS_DEVICE | 0x0080 ) /* Demodulate in fixed point arithmetic */
+#define CHANNEL_CLIENT   ( FLAGS_DEVICE | 0x0100 ) /* Decode a channel served by another instance */
+#define AFC_ENABLE       ( FLAGS_DEVICE | 0x0200 ) /* Track and correct frequency offset of signal */
+#define RECORD_SIGNAL    ( FLAGS_DEVICE | 0x0400 ) /* Record the signal samples to a WAV file */
+#define FILE_SOURCE      ( FLAGS_DEVICE | 0x0800 ) /* Take signal samples from a replayed recording */
+
+#define STATIONS_LIST_OK ( FLAGS_DISPLAY | 0x0001 ) /* Stations List is ready */
+#define DISPLAY_SIGNAL   ( FLAGS_DISPLAY | 0x0002 ) /* Display detector output */
+#define ENABLE_SCOPE     ( FLAGS_DISPLAY | 0x0004 ) /* Signal scope data ready to plot */
+#define HEADLESS         ( FLAGS_DISPLAY | 0x0008 ) /* Running without GUI (bench, regression) */
+#define STANDBY_ASLEEP   ( FLAGS_DISPLAY | 0x0010 ) /* Displays throttled in low power standby */
+
+#define INIMAGE_PHASING  ( FLAGS_IMAGE | 0x0001 ) /* Enable In-Image phasing pulse detection */
+#define SAVE_IMAGE_PGM   ( FLAGS_IMAGE | 0x0002 ) /* Save the image buffer to PGM file */
+#define SAVE_IMAGE_JPG   ( FLAGS_IMAGE | 0x0004 ) /* Save the image buffer to JPG file */
+#define SAVE_IMAGE       ( FLAGS_IMAGE | 0x0008 ) /* Enable saving of WEFAX image */
+#define AUTO_DESLANT     ( FLAGS_IMAGE | 0x0010 ) /* Correct slant from in-image sync pulses */
+#define SAVE_IMAGE_RAW   ( FLAGS_IMAGE | 0x0020 ) /* Save the discriminator output to raw file */
+#define AUTO_IOC_RPM     ( FLAGS_IMAGE | 0x0040 ) /* Detect IOC and RPM from start tone and phasing */
 
 /* Wefax control flags */
 enum
@@ -99,9 +123,88 @@ enum
 {
   ENHANCE_NONE = 0,
   ENHANCE_CONTRAST,
-  ENHANCE_BILEVEL
+  ENHANCE_BILEVEL,
+  ENHANCE_ADAPTIVE
+};
+
+/* Zoom of image viewer */
+enum
+{
+  ZOOM_1 = 0,
+  ZOOM_2,
+  ZOOM_4,
+  ZOOM_8,
+  ZOOM_FIT,
+  NUM_ZOOM
+};
+
+/* Spectrum window functions */
+enum
+{
+  WINDOW_RECTANGULAR = 0,
+  WINDOW_HANN,
+  WINDOW_BLACKMAN_HARRIS
+};
+
+/* Instrumented stages of the signal and image pipeline */
+enum
+{
+  PERF_SOUND_READ = 0,
+  PERF_DEMOD_SSB,
+  PERF_AFC,
+  PERF_RECORD,
+  PERF_DSP_FILTER,
+  PERF_CHANNELIZE,
+  PERF_FM_DETECT,
+  PERF_SPECTRUM,
+  PERF_NORMALIZE,
+  PERF_ENHANCE,
+  PERF_VIEWER,
+  PERF_SAVE_PGM,
+  PERF_SAVE_JPEG,
+  NUM_PERF_STAGES
 };
 
+/* Start of a timed pipeline stage */
+typedef struct
+{
+  uint64_t
+    start,  /* Time stamp at start of stage, nSec */
+    nested; /* Time in nested stages of thread at start */
+} perf_mark_t;
+
+/* Time a pipeline stage, compiled out unless configured --enable-perf.
+ * Both must be used in the same block, PERF_BEGIN() as a declaration */
+#ifdef ENABLE_PERF
+  #define PERF_BEGIN( stage ) \
+    perf_mark_t perf_mark_##stage = Perf_Begin()
+  #define PERF_END( stage ) \
+    Perf_End( stage, perf_mark_##stage )
+#else
+  #define PERF_BEGIN( stage )
+  #define PERF_END( stage )
+#endif
+
+/* Trace the latency of image lines from signal capture to display.
+ * PERF_CAPTURE() marks a block of samples captured at a time stamp,
+ * PERF_SAMPLE() the use of one of its samples by the decoder,
+ * PERF_LINE() the decoding of an image line ending at that sample,
+ * PERF_LINE_ADDED() its entry to the viewer and PERF_DISPLAYED()
+ * the drawing of the viewer, which displays the lines entered */
+#ifdef ENABLE_PERF
+  #define PERF_CAPTURE( time, frames )  Perf_Capture( time, frames )
+  #define PERF_SAMPLE()                 Perf_Sample()
+  #define PERF_LINE( line )             Perf_Line( line )
+  #define PERF_LINE_ADDED( line )       Perf_Line_Added( line )
+  #define PERF_DISPLAYED()              Perf_Displayed()
+#else
+  #define PERF_CAPTURE( time, frames )
+  #define PERF_SAMPLE()
+  #define PERF_LINE( line )
+  #define PERF_LINE_ADDED( line )
+  #define PERF_DISPLAYED()
+#endif
+
 #define SUCCESS     1
 #define ERROR       0
 
@@ -122,6 +225,9 @@ enum
 /* Length of phasing pulse in pixels */
 #define PHASING_PULSE_LEN   55
 
+/* Pixel value threshold for bilevel (0/255) image */
+#define BILEVEL_THRESHOLD   160
+
 /* Length of phasing pulse sliding window */
 #define PHASING_PUSLE_WIN   32.0
 
@@ -167,9 +273,16 @@ typedef struct rc_data
     num_chn,    /* Number of audio channels (2=stereo, 1=mono) */
     use_chn,    /* Channel in use (frontleft=0, frontright=1 etc) */
     cap_lev,    /* Recording/Capture level */
+    capture_rate, /* Capture rate of the sound card samples/sec */
     dsp_rate;   /* DSP rate (speed) samples/sec */
 
-  double dft_stride; /* DFT stride over input data (dsp samples) */
+  int dft_stride; /* DFT stride over input data (dsp samples) */
+
+  int
+    fft_size,    /* Size of the spectrum FFT */
+    fft_window,  /* Window function applied before FFT */
+    fft_overlap, /* Overlap of FFT segments in percent */
+    fft_average; /* Number of FFT segments averaged */
 
   /* Transceiver serial device */
   char cat_serial[32];
@@ -247,6 +360,76 @@ typedef struct filter_data
 
 } filter_data_t;
 
+/* Fixed point formats of the integer DSP path. Trig tables,
+ * gains and detector coefficients are Q15 or Q14 (for 2cos(w)),
+ * filter coefficients Q29, leaving headroom for b1 near 2.0 */
+#define Q14_SHIFT       14
+#define Q15_SHIFT       15
+#define Q29_SHIFT       29
+#define Q15_ONE         ( 1 << Q15_SHIFT )
+
+/* Converts a double to fixed point, for initialization only */
+#define TO_FIXED( x, shift ) \
+  ( (int32_t)lround((x) * (double)(1L << (shift))) )
+
+/* Second order section of a fixed point recursive filter,
+ * Q29 coefficients and saved values in sample units */
+typedef struct
+{
+  int32_t a0, a1, a2, b1, b2;
+  int32_t x1, x2, y1, y2;
+} filter_section_t;
+
+/* Fixed point recursive filter, the cascade of the
+ * second order sections of a filter_data_t design */
+typedef struct
+{
+  int nsections;
+  filter_section_t *sections;
+
+  /* Input samples buffer and its length */
+  int32_t *samples_buf;
+  int samples_buf_len;
+
+} filter_fixed_t;
+
+/* Polyphase resampler by a rational factor, up / down,
+ * of the capture rate to the DSP rate of the detectors */
+typedef struct
+{
+  int
+    in_rate,  /* Sample rate of the input */
+    out_rate, /* Sample rate of the output */
+    up,       /* Up sampling factor, the number of filter phases */
+    down,     /* Down sampling factor */
+    taps,     /* Taps of each filter phase */
+    max_in,   /* Largest block of input samples */
+    max_out;  /* Largest block of output samples */
+
+  /* Filter coefficients, phase after phase with their
+   * taps in reverse, and the input history they run on */
+  float *coef, *hist;
+
+  /* Index in the history of the newest input sample of
+   * the next output sample and the filter phase of it */
+  int pos, phase;
+
+} resampler_t;
+
+/* DSP kernels compiled for an instruction set,
+ * selected at startup for the CPU in use */
+typedef struct
+{
+  const char *name; /* Name of instruction set */
+  void ( *fft )( float *re, float *im, const float *cos_tab,
+      const float *sin_tab, const int *rev, int size );
+  void ( *iir_filter )( filter_data_t *filter_data );
+  void ( *histogram )( const unsigned char *line_buf, int line_len, int *hist );
+  void ( *remap )( unsigned char *line_buf, const unsigned char *lut, int line_len );
+  void ( *fdct )( const float *block, const float *coeff, float *dct );
+  int ( *resample )( resampler_t *resampler, int end, short *out );
+} dsp_kernels_t;
+
 /* Filter type for above struct */
 enum
 {
@@ -255,6 +438,67 @@ enum
   FILTER_BANDPASS
 };
 
+/* SNR at or above which no noise is added, dB */
+#define SYNTH_NO_NOISE      100.0
+
+/* Parameters of a synthetic transmission */
+typedef struct
+{
+  int
+    sample_rate,     /* Sample rate of signal, samples/sec */
+    pixels_per_line, /* Image resolution pixels/line */
+    ioc_value,       /* IOC value, selects start tone */
+    black_freq,      /* Frequency of black level, Hz */
+    white_freq,      /* Frequency of white level, Hz */
+    phasing_lines,   /* Number of phasing lines */
+    image_lines,     /* Number of image lines */
+    pattern;         /* Image content, as below */
+
+  double
+    lines_per_min,   /* Line transmission rate */
+    snr,             /* Signal to noise ratio, dB */
+    fade_freq,       /* Rate of amplitude fading, Hz, 0 for none */
+    freq_offset,     /* Tuning offset of signal, Hz */
+    clock_error;     /* Relative error of line rate, as of clock */
+} synth_params_t;
+
+/* Image content of synthetic transmission */
+enum
+{
+  PATTERN_LINES = 0,
+  PATTERN_CHECKER,
+  PATTERN_GRADIENT
+};
+
+/* Segments of synthetic transmission */
+enum
+{
+  SEGMENT_START = 0,
+  SEGMENT_PHASING,
+  SEGMENT_IMAGE,
+  SEGMENT_STOP,
+  SEGMENT_BLACK,
+  SEGMENT_DONE
+};
+
+/* Canonical 44 byte header of a PCM WAV file */
+typedef struct
+{
+  char riff[4];           /* "RIFF" */
+  uint32_t riff_size;     /* Size of the file less 8 bytes */
+  char wave[4];           /* "WAVE" */
+  char fmt[4];            /* "fmt " */
+  uint32_t fmt_size;      /* Size of the format chunk, 16 */
+  uint16_t format;        /* 1, integer PCM */
+  uint16_t channels;      /* 1 for audio, 2 for I/Q */
+  uint32_t sample_rate;   /* Frames per second */
+  uint32_t byte_rate;     /* Bytes per second */
+  uint16_t block_align;   /* Bytes per frame */
+  uint16_t bits;          /* Bits per sample */
+  char data[4];           /* "data" */
+  uint32_t data_size;     /* Size of the samples in bytes */
+} wav_header_t;
+
 /* Transceiver status data */
 typedef struct
 {
@@ -359,6 +603,11 @@ typedef struct
 
 /*** Function Prototypes created by cproto */
 
+/* afc.c */
+void Afc_Shift(short *sample);
+void Afc_Reset(void);
+/* bench.c */
+int Bench_Run(void);
 /* callbacks.c */
 void Error_Dialog(char *mesg, gboolean hide);
 gboolean on_main_window_delete_event(GtkWidget *widget, GdkEvent *event, gpointer user_data);
@@ -383,10 +632,17 @@ void on_pix_activate(GtkMenuItem *menuitem, gpointer user_data);
 void on_ioc_activate(GtkMenuItem *menuitem, gpointer user_data);
 void on_phl_activate(GtkMenuItem *menuitem, gpointer user_data);
 void on_enhance_activate(GtkMenuItem *menuitem, gpointer user_data);
+void on_spectrum_activate(GtkMenuItem *menuitem, gpointer user_data);
 void on_deslant_spinbutton_value_changed(GtkSpinButton *spinbutton, gpointer user_data);
 void on_in_image_phasing_activate(GtkMenuItem *menuitem, gpointer user_data);
+void on_auto_deslant_activate(GtkMenuItem *menuitem, gpointer user_data);
+void on_auto_ioc_rpm_activate(GtkMenuItem *menuitem, gpointer user_data);
+void on_afc_activate(GtkMenuItem *menuitem, gpointer user_data);
+void on_low_power_standby_activate(GtkMenuItem *menuitem, gpointer user_data);
 gboolean on_wefax_drawingarea_button_press_event(GtkWidget *widget, GdkEventButton *event, gpointer user_data);
 gboolean on_wefax_drawingarea_draw(GtkWidget *widget, cairo_t *cr, gpointer user_data);
+gboolean on_wefax_drawingarea_scroll_event(GtkWidget *widget, GdkEventScroll *event, gpointer user_data);
+void on_zoom_activate(GtkMenuItem *menuitem, gpointer user_data);
 void on_station_list_activate(GtkMenuItem *menuitem, gpointer user_data);
 void on_stations_window_destroy(GObject *object, gpointer user_data);
 void on_down_button_clicked(GtkButton *button, gpointer user_data);
@@ -400,10 +656,15 @@ void on_capture_setup_activate(GtkMenuItem *menuitem, gpointer user_data);
 void on_jpeg_activate(GtkMenuItem *menuitem, gpointer user_data);
 void on_pgm_activate(GtkMenuItem *menuitem, gpointer user_data);
 void on_both_activate(GtkMenuItem *menuitem, gpointer user_data);
+void on_save_raw_activate(GtkMenuItem *menuitem, gpointer user_data);
+void on_record_activate(GtkMenuItem *menuitem, gpointer user_data);
 void on_zerocrossing_activate(GtkMenuItem *menuitem, gpointer user_data);
 void on_bilevel_activate(GtkMenuItem *menuitem, gpointer user_data);
 gboolean on_gauge_drawingarea_draw(GtkWidget *widget, cairo_t *cr, gpointer user_data);
 void on_save_checkbutton_toggled(GtkToggleButton *togglebutton, gpointer user_data);
+void on_performance_activate(GtkMenuItem *menuitem, gpointer user_data);
+void on_perf_window_destroy(GObject *object, gpointer user_data);
+void on_perf_reset_button_clicked(GtkButton *button, gpointer user_data);
 /* cat.c */
 gboolean Open_Tcvr_Serial(void);
 void Close_Tcvr_Serial(void);
@@ -411,17 +672,30 @@ void Tcvr_Status(int action, tcvr_status_t *status);
 gboolean Read_Rx_Freq(int *freq);
 gboolean Set_Rx_Freq_Idle_Cb(gpointer data);
 gboolean Tune_Tcvr(double x);
+/* channel.c */
+gboolean Channel_Serve_Open(int chn, int dsp_rate);
+void Channel_Serve(int chn, const short *samples, int len);
+void Channel_Client(int chn);
+gboolean Channel_Attach(char *mesg);
+gboolean Channel_Read(short *samples, int len);
+void Channel_Close(void);
+
 /* detect.c */
 gboolean FM_Detect_Zero_Crossing(unsigned char *signal_level);
 gboolean FM_Detect_Bilevel(unsigned char *signal_level);
+void Detect_Specialize(gboolean enable);
 gboolean Phasing_Detect(void);
+gboolean Standby_Listen(void);
+gboolean Standby_Replay(short *sample);
+void Standby_Reset(void);
 gboolean Start_Tone_Detect(void);
 gboolean Stop_Tone_Detect(unsigned char discr_op);
+void Detect_Reset(void);
 /* dft.c */
-void Idft_Init(int dft_input_size, int dft_bin_size);
-void Idft(int dft_input_size, int dft_bin_size);
-/* display.c */
+void Spectrum_Configure(void);
 void DFT_Input_Data(short sample_val);
+/* display.c */
+void Display_Waterfall(const guchar *row);
 void Display_Signal(unsigned char plot);
 void Draw_Signal(cairo_t *cr);
 void Set_Indicators(int flag);
@@ -429,10 +703,18 @@ void Set_Menu_Items(void);
 void Normalize(unsigned char *line_buffer, int line_len);
 void Spectrum_Size_Allocate(int width, int height);
 void Set_Sync_Slant(double sync_slant);
+void Set_Pixel_Len(void);
 void Display_Level_Gauge(cairo_t *cr);
+/* enhance.c */
+gboolean Enhance_Put_Line(const unsigned char *pixels, int width, int line_idx);
+gboolean Enhance_Get_Line(unsigned char *image, int width, int *line_idx);
+void Enhance_Flush(void);
+void Enhance_Reset(void);
 /* filters.c */
 void Init_Chebyshev_Filter(filter_data_t *filter_data);
 void DSP_Filter(filter_data_t *filter_data);
+void Init_Chebyshev_Fixed(filter_data_t *filter_data, filter_fixed_t *filter_fixed);
+void DSP_Filter_Fixed(filter_fixed_t *filter_fixed);
 /* interface.c */
 GtkWidget *Builder_Get_Object(GtkBuilder *builder, gchar *name);
 GtkWidget *create_main_window(GtkBuilder **builder);
@@ -440,19 +722,66 @@ GtkWidget *create_error_dialog(GtkBuilder **builder);
 GtkWidget *create_quit_dialog(GtkBuilder **builder);
 GtkWidget *create_popup_menu(GtkBuilder **builder);
 GtkWidget *create_stations_window(GtkBuilder **builder);
+GtkWidget *create_perf_window(GtkBuilder **builder);
 /* jpeg.c */
 jpec_enc_t *jpec_enc_new(const uint8_t *img, uint16_t w, uint16_t h);
 void jpec_enc_del(jpec_enc_t *e);
 const uint8_t *jpec_enc_run(jpec_enc_t *e, int *len);
+/* kernels.c */
+void Kernels_Init(void);
+void FFT_Tables(float *cos_tab, float *sin_tab, int *rev, int size);
 /* main.c */
 int main(int argc, char *argv[]);
+/* perf.c */
+uint64_t Perf_Clock(void);
+perf_mark_t Perf_Begin(void);
+void Perf_End(int stage, perf_mark_t mark);
+void Perf_Capture(uint64_t time, int frames);
+void Perf_Sample(void);
+void Perf_Line(int line);
+void Perf_Line_Added(int line);
+void Perf_Displayed(void);
+void Perf_Init(void);
+void Perf_Reset(void);
+void Perf_Window(void);
 /* perseus.c */
 #ifdef HAVE_LIBPERSEUS_SDR
+gboolean Perseus_Add_Channel(int offset);
 gboolean Demodulate_SSB(short *signal_sample);
 void Perseus_Set_Center_Frequency(int center_freq);
 void Perseus_Close_Device(void);
 gboolean Perseus_Initialize(void);
 #endif
+/* raw.c */
+gboolean Raw_Open(char *file_name, double phase);
+void Raw_Advance(int samples);
+void Raw_Crossing(double time);
+void Raw_Close(void);
+const char *Raw_File_Name(void);
+gboolean Raw_Render(const char *file_name, double sync_slant, double phase, int image_enhance, unsigned char **image, int *width, int *lines);
+int Raw_Render_Run(char *arg);
+/* record.c */
+void Record_Samples(const short *samples, int count);
+void Record_IQ(const uint8_t *buf, int size);
+void Record_Source(int channels, int bits, int rate);
+void Record_Mode(int mode, gboolean iq16);
+void Record_Chart(void);
+void Record_WAV_Header(wav_header_t *header, int channels, int bits, int rate, uint32_t data_size);
+/* regress.c */
+int Regress_Run(char *arg);
+/* replay.c */
+void Replay_Close(void);
+gboolean Replay_Open(char *arg);
+gboolean Replay_Configure(void);
+void Replay_Attach(void);
+const short *Replay_Span(int *len);
+void Replay_IQ(int32_t *i_buf, int32_t *q_buf, int len);
+/* resample.c */
+gboolean Resample_Init(resampler_t *resampler, int in_rate, int out_rate, int max_in);
+int Resample(resampler_t *resampler, const short *in, int len, short *out);
+/* schedule.c */
+void Schedule_File(const char *file_name);
+gboolean Schedule_Start(gpointer data);
 /* shared.c */
 /* sound.c */
 gboolean Open_Capture(char *mesg, int *error);
@@ -467,6 +796,12 @@ void Treeview_Button_Press(void);
 void New_Station_Row(void);
 void Delete_Station_Row(void);
 void cell_edited_callback(GtkCellRendererText *cell, gchar *path, gchar *new_text, gpointer user_data);
+/* synth.c */
+void Synth_Init(const synth_params_t *params);
+unsigned char Synth_Pixel(int line, int pixel);
+int Synth_Segment(void);
+long Synth_Length(void);
+gboolean Synth_Sample(short *sample_val);
 /* utils.c */
 int Load_Line(char *buff, FILE *pfile, char *mesg);
 gboolean Load_Config(gpointer data);
@@ -475,6 +810,10 @@ void New_Pixels_Per_Line(void);
 void New_IOC(void);
 void New_Phasing_Lines(void);
 void New_Image_Enhance(void);
+void New_Image_Zoom(void);
+void New_Spectrum_Settings(void);
+gboolean Save_Spectrum_Settings(void);
+void New_Record_Settings(void);
 void Configure(void);
 void File_Name(char *file_name, const char *extn);
 char *name(char *fpath);
@@ -494,8 +833,17 @@ void ClearFlag(int flag);
 void ToggleFlag(int flag);
 void Strlcpy(char *dest, const char *src, size_t n);
 void Strlcat(char *dest, const char *src, size_t n);
+/* viewer.c */
+gboolean Viewer_Configure(int width, int height);
+void Viewer_Clear(void);
+void Viewer_Add_Line(const unsigned char *line, int line_idx);
+gboolean Viewer_Draw(cairo_t *cr);
+void Viewer_Set_Zoom(int zoom);
+gboolean Viewer_Scroll(GdkEventScroll *event);
+double Viewer_Image_X(double x);
 /* wefax.c */
 gboolean Wefax_Dcode(void);
+gboolean Wefax_Decode_Headless(unsigned char **image, int *lines);
 gboolean Wefax_Drawingarea_Button_Press(GdkEventButton *event);
 void Start_Button_Toggled(GtkToggleButton *togglebutton);
 
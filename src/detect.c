@@ -26,6 +26,8 @@ Queue_Draw_Gauge( void )
 {
   static int cnt = 0;
 
+  if( isFlagSet(HEADLESS) ) return;
+
   if( cnt++ >= GAUGE_COUNT )
   {
     gtk_widget_queue_draw( level_gauge );
@@ -36,7 +38,154 @@ Queue_Draw_Gauge( void )
 
 /*------------------------------------------------------------------------*/
 
-/* FM_Detect_Zero_Crossing()
+/* Signal_Level_Display()
+ *
+ * Displays the maximum signal level of a pixel's samples
+ */
+  static void
+Signal_Level_Display( short signal_max )
+{
+  if( isFlagClear(DISPLAY_SIGNAL) )
+  {
+    Display_Signal( (unsigned char)(signal_max >> 7) );
+    gauge_input  = (int)(signal_max / SIG_GAUGE_SCALE);
+    gauge_level1 = SIG_GAUGE_LEVEL1;
+    gauge_level2 = SIG_GAUGE_LEVEL2;
+    Queue_Draw_Gauge();
+  }
+} /* Signal_Level_Display() */
+
+/*------------------------------------------------------------------------*/
+
+/* State of the zero crossing detector, carried over
+ * between pixels by its generic and specialized instances */
+static struct
+{
+  /* Count of Audio samples used. It is a float as
+   * for some modes, like SSTV, the pixel length
+   * is not an integer number of Audio samples */
+  double samples_used_cnt;
+
+  /* Count of Audio samples used beyond the pixel's end,
+   * in units of 1/den samples, in specialized instances */
+  int residual;
+
+  double
+    zero_cross_interp, // Interpolation of zero crossing point
+    zeros_period,      // Time elapsed between zeros, in Audio samples
+    signal_freq,       // Measured frequency of incoming WEFAX signal
+    new_average,       // New Audio samples average
+    last_average;      // Last Audio samples average
+
+  int
+    period_cnt_incr,  // Number of increments to period counter
+    pixel_num_zeros,  // Number of zero crossings in a pixel
+
+    /* This is used to limit the effects of noise by imposing
+     * a minimum count of Audio samples between zeros */
+    inter_zero_samples; // Count of samples between zero crossings
+
+} zero_cross;
+
+/* State of the bilevel detector, as above */
+static struct
+{
+  /* Index of DSP samples used, as above */
+  double pixel_idx;
+  int residual;
+
+  int
+    det_period, /* Integration period of Goertzel detector */
+    signal_idx; /* Signal samples buffer index */
+
+  /* Circular signal samples buffer for Goertzel detector */
+  short *signal_buff;
+
+  /* Coefficients of the Goertzel detectors */
+  double black_coeff, white_coeff, scale;
+
+  /* As above in fixed point, 2cos(w) in Q14, scale
+   * squared and the count of samples used in Q16 */
+  int32_t black_coeff_q14, white_coeff_q14;
+  int64_t scale_sq;
+  int32_t pixel_idx_q16;
+
+  /* DSP rate the detectors are set up for, 0 if not */
+  int dsp_rate;
+
+} bilevel;
+
+/* State of the fixed point zero crossing detector, with the
+ * signal average in Q3, zero crossing times in Q12 samples,
+ * signal frequency in Q4 Hz and pixel length in Q16 samples */
+static struct
+{
+  int32_t
+    samples_used_cnt,
+    zero_cross_interp,
+    zeros_period,
+    signal_freq,
+    new_average,
+    last_average;
+
+  int
+    period_cnt_incr,
+    pixel_num_zeros,
+    inter_zero_samples;
+
+} zero_fixed;
+
+/* State of the phasing pulse matched filter, with the FFT of the
+ * pulse template and the sum of the phasing lines examined */
+static struct
+{
+  int pixels_per_line, fft_size, lines;
+  float *re, *im, *cos_tab, *sin_tab, *pulse_re, *pulse_im;
+  int *rev;
+  double *line_sum;
+
+  int
+    pixel_idx, /* Index to pixels in Wefax line */
+    count,     /* Count of phasing pulse lines examined */
+    ref;       /* Reference for initial position of phasing pulse */
+} phasing;
+
+/*------------------------------------------------------------------------*/
+
+/* Pixel_Samples()
+ *
+ * Returns the number of Audio samples making up the next image pixel.
+ * With a pixel length given as the ratio pixel_num / pixel_den, the
+ * count is done in integers, else in floats against rc_data.pixel_len
+ */
+  static inline int __attribute__((always_inline))
+Pixel_Samples( double *used_cnt, int *residual,
+    const int pixel_num, const int pixel_den )
+{
+  int samples;
+
+  /* Pixel length is a whole number of samples */
+  if( pixel_den && (pixel_num % pixel_den == 0) )
+    return( pixel_num / pixel_den );
+
+  /* Pixel length is a fraction of integers */
+  if( pixel_den )
+  {
+    samples = ( pixel_num - *residual + pixel_den - 1 ) / pixel_den;
+    *residual += samples * pixel_den - pixel_num;
+    return( samples );
+  }
+
+  /* Pixel length of custom (slanted) modes */
+  samples = (int)ceil( rc_data.pixel_len - *used_cnt );
+  *used_cnt += (double)samples - rc_data.pixel_len;
+  return( samples );
+
+} /* Pixel_Samples() */
+
+/*------------------------------------------------------------------------*/
+
+/* Zero_Crossing_Pixel()
  *
  * Estimates the frequency of the incoming WEFAX audio signal by
  * counting Audio samples, up for +ve and down for -ve, up to a
@@ -45,48 +194,34 @@ Queue_Draw_Gauge( void )
  * between the +ve and -ve half cycles of the signal and thus
  * a measure of the length of half a signal cycle is obtained.
  * From this the instantaneous signal frequency is calculated.
+ * It is instantiated for each standard mode by DETECT_INSTANCE.
  */
-  gboolean
-FM_Detect_Zero_Crossing( uint8_t *signal_level )
+  static inline gboolean __attribute__((always_inline))
+Zero_Crossing_Pixel( unsigned char *signal_level,
+    const int pixel_num, const int pixel_den )
 {
-  static short
+  short
     signal_sample,   /* Signal sample from DSP */
     signal_max = 0;  /* Maximum level from Audio DSP */
 
-  static double
-    discrim_output,           // Output of FM detector (0-255)
-    zero_cross_interp = 0.0;  // Interpolation of zero crossing point
+  double discrim_output; // Output of FM detector (0-255)
 
   // Half the Audio sample rate, as a double
   double sample_rate2  = (double)( rc_data.dsp_rate / 2 );
 
-  /* Count of Audio samples used. It is a float as
-   * for some modes, like SSTV, the pixel length
-   * is not an integer number of Audio samples */
-  static double samples_used_cnt = 0.0;
-
-  static double
-    zeros_period = 0.0, // Time elapsed between zeros, in Audio samples
-    signal_freq  = 0.0, // Measured frequency of incoming WEFAX signal
-    new_average  = 0.0, // New Audio samples average
-    last_average = 0.0; // Last Audio samples average
-
-  static int
-    period_cnt_incr = 0,  // Number of increments to period counter
-    pixel_num_zeros = 0;  // Number of zero crossings in a pixel
-
-  /* These two variables are used to limit the effects of noise
-   * by imposing a minimum count of Audio samples between zeros
-   */
-  // Count of samples between zero crossings
-  static int inter_zero_samples = 0;
-
   // Minimum length of WEFAX signal 1/3 cycle in Audio samples
   int min_cycle3 = rc_data.dsp_rate / rc_data.white_freq / 3;
 
+  // Number of Audio samples in the pixel
+  int idx, samples;
+
+  PERF_BEGIN( PERF_FM_DETECT );
+
   /* Look for a zero crossing of the WEFAX audio
    * signal over the duration of each image pixel */
-  while( samples_used_cnt < rc_data.pixel_len )
+  samples = Pixel_Samples( &zero_cross.samples_used_cnt,
+      &zero_cross.residual, pixel_num, pixel_den );
+  for( idx = 0; idx < samples; idx++ )
   {
     signal_sample = 0;
 
@@ -109,152 +244,186 @@ FM_Detect_Zero_Crossing( uint8_t *signal_level )
       signal_max = (short)( abs(signal_sample) );
 
     // Sliding widow average of DSP signal samples
-    new_average  = new_average * ( SIG_AVE_WINDOW - 1.0 );
-    new_average += (double)signal_sample;
-    new_average /= SIG_AVE_WINDOW;
+    zero_cross.new_average =
+      zero_cross.new_average * SIG_AVE_DECAY +
+      (double)signal_sample * SIG_AVE_GAIN;
 
     // This gives us a zero crossing of the input waveform
-    inter_zero_samples++;
-    if( (new_average * last_average <= 0.0) &&
-        (inter_zero_samples >= min_cycle3) )
+    zero_cross.inter_zero_samples++;
+    if( (zero_cross.new_average * zero_cross.last_average <= 0.0) &&
+        (zero_cross.inter_zero_samples >= min_cycle3) )
     {
       // Signal frequency is 1/2 DSP rate / length of half cycle
       // Interpolate point of zero crossing
-      if( (last_average - new_average) != 0.0 )
-        zero_cross_interp = new_average / ( last_average - new_average );
-      if( zero_cross_interp < -1.0 ) zero_cross_interp = -1.0;
-      if( zero_cross_interp >  1.0 ) zero_cross_interp =  1.0;
-
-      pixel_num_zeros++;
-      period_cnt_incr    = 0;
-      inter_zero_samples = 0;
+      double diff = zero_cross.last_average - zero_cross.new_average;
+      if( diff != 0.0 )
+        zero_cross.zero_cross_interp = zero_cross.new_average / diff;
+      if( zero_cross.zero_cross_interp < -1.0 )
+        zero_cross.zero_cross_interp = -1.0;
+      if( zero_cross.zero_cross_interp >  1.0 )
+        zero_cross.zero_cross_interp =  1.0;
+
+      // Record crossing time for re-rendering
+      if( isFlagSet(SAVE_IMAGE_RAW) )
+        Raw_Crossing( (double)idx + zero_cross.zero_cross_interp );
+
+      zero_cross.pixel_num_zeros++;
+      zero_cross.period_cnt_incr    = 0;
+      zero_cross.inter_zero_samples = 0;
     } // if( (new_average * last_average) < 0.0 )
 
     // Save current signal average
-    last_average = new_average;
+    zero_cross.last_average = zero_cross.new_average;
 
     // Count number of signal samples between zero crossings
-    zeros_period += 1.0;
-    period_cnt_incr++;
-
-    // Count DSP samples
-    samples_used_cnt += 1.0;
-  } // while( samples_used_cnt < wefax_rc.pixel_len )
+    zero_cross.period_cnt_incr++;
+  } // for( idx = 0; idx < samples; idx++ )
+  zero_cross.zeros_period += (double)samples;
+  Raw_Advance( samples );
 
   // Add extrapolation of zero crossing
-  if( pixel_num_zeros )
+  if( zero_cross.pixel_num_zeros )
   {
     // Calculate signal frequency from half cycle period
-    zeros_period += zero_cross_interp;
+    zero_cross.zeros_period += zero_cross.zero_cross_interp;
     double half_cycle =
-      ( zeros_period - (double)period_cnt_incr ) / (double)pixel_num_zeros;
+      ( zero_cross.zeros_period - (double)zero_cross.period_cnt_incr ) /
+      (double)zero_cross.pixel_num_zeros;
     if( half_cycle != 0.0 )
-      signal_freq = sample_rate2 / half_cycle;
+      zero_cross.signal_freq = sample_rate2 / half_cycle;
 
     /* Prepares zeros_period to properly count
      * signal samples to next zero crossing */
-    zeros_period = (double)period_cnt_incr - zero_cross_interp;
-    period_cnt_incr = 0;
+    zero_cross.zeros_period =
+      (double)zero_cross.period_cnt_incr - zero_cross.zero_cross_interp;
+    zero_cross.period_cnt_incr = 0;
   }
-  pixel_num_zeros = 0;
-
-  // Reset the samples index
-  samples_used_cnt -= rc_data.pixel_len;
+  zero_cross.pixel_num_zeros = 0;
 
   // Scale and floor frequency to give a value 0-255
-  discrim_output = signal_freq / DISCR_SCALE - DISCR_FLOOR;
+  discrim_output = zero_cross.signal_freq / DISCR_SCALE - DISCR_FLOOR;
 
   // Limit disriminator output in right range
   if( discrim_output > 255.0 ) discrim_output = 255.0;
   if( discrim_output < 0.0 )   discrim_output = 0.0;
   *signal_level = (unsigned char)discrim_output;
-  signal_max = 0;
 
   /* Display maximum signal level scaled down */
-  if( isFlagClear(DISPLAY_SIGNAL) )
-  {
-    Display_Signal( (unsigned char)(signal_max >> 7) );
-    gauge_input  = (int)(signal_max / SIG_GAUGE_SCALE);
-    gauge_level1 = SIG_GAUGE_LEVEL1;
-    gauge_level2 = SIG_GAUGE_LEVEL2;
-    Queue_Draw_Gauge();
-  }
+  Signal_Level_Display( signal_max );
 
+  PERF_END( PERF_FM_DETECT );
   return( TRUE );
-} // FM_Detect_Zero_Crossing()
+} // Zero_Crossing_Pixel()
 
 //------------------------------------------------------------------------
 
-/* FM_Detect_Bilevel()
+/* Bilevel_Level()
+ *
+ * Calculates signal level according to ratio between
+ * black and white Goertzel tone detector outputs
+ */
+  static inline unsigned char
+Bilevel_Level( int black_level, int white_level )
+{
+  if( black_level > 8 * white_level )
+    return( 0 );
+  else if( (black_level <= 8 * white_level) && (black_level > 4 * white_level) )
+    return( 64 );
+  else if( (black_level <= 4 * white_level) && (white_level < 4 * black_level) )
+    return( 128 );
+  else if( (white_level >= 4 * black_level) && (white_level < 8 * black_level) )
+    return( 196 );
+  else return( 255 );
+} /* Bilevel_Level() */
+
+/*------------------------------------------------------------------------*/
+
+/* Bilevel_Init()
+ *
+ * Initializes the Goertzel detectors of the bilevel detector
+ * for the DSP rate, again whenever the rate changes
+ */
+  static gboolean
+Bilevel_Init( void )
+{
+  double w;
+
+  /* Omega for the white frequency */
+  w = M_2PI / (double)rc_data.dsp_rate * (double)rc_data.white_freq;
+  bilevel.white_coeff = 2.0 * cos( w );
+
+  /* Omega for the black frequency */
+  w = M_2PI / (double)rc_data.dsp_rate * (double)rc_data.black_freq;
+  bilevel.black_coeff = 2.0 * cos( w );
+
+  bilevel.det_period = rc_data.dsp_rate /
+    (rc_data.white_freq - rc_data.black_freq);
+
+  /* To keep values of detected signal in reasonable limits */
+  bilevel.scale = (double)bilevel.det_period * BILEVEL_SCALE_FACTOR;
+
+  /* Coefficients of the fixed point detector */
+  bilevel.white_coeff_q14 = TO_FIXED( bilevel.white_coeff, Q14_SHIFT );
+  bilevel.black_coeff_q14 = TO_FIXED( bilevel.black_coeff, Q14_SHIFT );
+  bilevel.scale_sq = (int64_t)( bilevel.scale * bilevel.scale );
+
+  /* Allocate samples buffer and clear */
+  size_t len = sizeof(short) * (size_t)bilevel.det_period;
+  if( !mem_realloc((void **)&bilevel.signal_buff, len) )
+    return( FALSE );
+  bzero( bilevel.signal_buff, len );
+  bilevel.signal_idx = 0;
+
+  bilevel.dsp_rate = rc_data.dsp_rate;
+  return( TRUE );
+} /* Bilevel_Init() */
+
+/*------------------------------------------------------------------------*/
+
+/* Bilevel_Pixel()
  *
  * Estimates the WEFAX input signal's frequency by comparing
  * the output of a Goertzel detector on the black frequency
  * (1500 Hz) and one on the white frequency (2300 Hz).
+ * It is instantiated for each standard mode by DETECT_INSTANCE.
  */
-  gboolean
-FM_Detect_Bilevel( unsigned char *signal_level )
+  static inline gboolean __attribute__((always_inline))
+Bilevel_Pixel( unsigned char *signal_level,
+    const int pixel_num, const int pixel_den )
 {
-  static int
-    first_call = TRUE,
-    det_period, /* Integration period of Goertzel detector */
-    signal_idx; /* Signal samples buffer index */
-
   int
     idx,
+    samples,     /* Number of DSP samples in the pixel */
     black_level, /* Level of the Black signal */
     white_level; /* Level of the White signal */
 
-  /* Circular signal samples buffer for Goertzel detector */
-  static short *signal_buff = NULL;
   short signal_max;  /* Maximum level from Audio DSP */
 
   /* Variables for the Goertzel algorithm */
-  static double black_cosw, black_coeff;
-  static double white_cosw, white_coeff;
-  static double scale;
+  double black_coeff, white_coeff, scale;
   double black_q0, black_q1, black_q2;
   double white_q0, white_q1, white_q2;
 
-  /* Index of DSP samples used. It is a float as
-   * for some modes, like SSTV, the pixel length
-   * is not an integer number of DSP samples */
-  static double pixel_idx = 0.0;
-
+  short *signal_buff;
+  int signal_idx, det_period;
 
-  /* Initialize on first call */
-  if( first_call )
-  {
-    double w;
-
-    /* Omega for the white frequency */
-    w = M_2PI / (double)rc_data.dsp_rate * (double)rc_data.white_freq;
-    white_cosw  = cos( w );
-    white_coeff = 2.0 * white_cosw;
-
-    /* Omega for the black frequency */
-    w = M_2PI / (double)rc_data.dsp_rate * (double)rc_data.black_freq;
-    black_cosw  = cos( w );
-    black_coeff = 2.0 * black_cosw;
+  /* Initialize on first call and on a change of DSP rate */
+  if( (bilevel.dsp_rate != rc_data.dsp_rate) && !Bilevel_Init() )
+    return( FALSE );
 
-    det_period = rc_data.dsp_rate /
-      (rc_data.white_freq - rc_data.black_freq);
-
-    /* To keep values of detected signal in reasonable limits */
-    scale = (double)det_period * BILEVEL_SCALE_FACTOR;
-
-    /* Allocate samples buffer and clear */
-    size_t len = sizeof(short) * (size_t)det_period;
-    if( !mem_realloc((void **)&signal_buff, len) )
-      return( FALSE );
-    bzero( signal_buff, len );
-    signal_idx = 0;
-
-    first_call = FALSE;
-  } /* if( first_call... ) */
+  signal_buff = bilevel.signal_buff;
+  signal_idx  = bilevel.signal_idx;
+  det_period  = bilevel.det_period;
+  black_coeff = bilevel.black_coeff;
+  white_coeff = bilevel.white_coeff;
+  scale       = bilevel.scale;
 
   /* Save samples for detector */
+  PERF_BEGIN( PERF_FM_DETECT );
   signal_max = 0;
-  while( pixel_idx < rc_data.pixel_len )
+  samples = Pixel_Samples( &bilevel.pixel_idx,
+      &bilevel.residual, pixel_num, pixel_den );
+  for( idx = 0; idx < samples; idx++ )
   {
     if( rc_data.tcvr_type == PERSEUS )
     {
@@ -266,7 +435,10 @@ FM_Detect_Bilevel( unsigned char *signal_level )
     {
       /* Get signal sample from buffer, abort on error */
       if( !Sound_Signal_Sample(&signal_buff[signal_idx]) )
+      {
+        bilevel.signal_idx = signal_idx;
         return( FALSE );
+      }
     }
 
     /* Get max absolute value of signal sample */
@@ -277,13 +449,9 @@ FM_Detect_Bilevel( unsigned char *signal_level )
     signal_idx++;
     if( signal_idx >= det_period ) signal_idx = 0;
 
-    /* Count DSP samples */
-    pixel_idx += 1.0;
-
-  } /* while( idx < rc_data.pixel_len ) */
-
-  /* Reset the samples index */
-  pixel_idx -= rc_data.pixel_len;
+  } /* for( idx = 0; idx < samples; idx++ ) */
+  bilevel.signal_idx = signal_idx;
+  Raw_Advance( samples );
 
   /* Calculate signal level of black and white
    * tone frequencies using Goertzel algorithm */
@@ -321,81 +489,590 @@ FM_Detect_Bilevel( unsigned char *signal_level )
     ( (white_q1 * white_q1 + white_q2 * white_q2 -
        white_q1 * white_q2 * white_coeff) );
 
-  /* Calculate signal level according to ratio between
-   * black and white Goertzel tone detector outputs */
-  if( black_level > 8 * white_level )
-    *signal_level = 0;
-  else if( (black_level <= 8 * white_level) && (black_level > 4 * white_level) )
-    *signal_level = 64;
-  else if( (black_level <= 4 * white_level) && (white_level < 4 * black_level) )
-    *signal_level = 128;
-  else if( (white_level >= 4 * black_level) && (white_level < 8 * black_level) )
-    *signal_level = 196;
-  else *signal_level = 255;
+  *signal_level = Bilevel_Level( black_level, white_level );
+
+  /* Display maximum signal level scaled down */
+  Signal_Level_Display( signal_max );
+
+  PERF_END( PERF_FM_DETECT );
+  return( TRUE );
+} /* Bilevel_Pixel() */
+
+/*------------------------------------------------------------------------*/
+
+/* Pixel length in Q16 Audio samples, for the fixed point detectors */
+static int32_t detect_pixel_len_q16 = 0;
+
+/* Pixel_Samples_Fixed()
+ *
+ * Returns the number of Audio samples making up the
+ * next image pixel, counting in Q16 fixed point
+ */
+  static inline int
+Pixel_Samples_Fixed( int32_t *used_cnt, int32_t pixel_len )
+{
+  int samples;
+
+  samples = ( pixel_len - *used_cnt + FIXED_PIXEL_ONE - 1 ) >> FIXED_PIXEL_SHIFT;
+  *used_cnt += ( samples << FIXED_PIXEL_SHIFT ) - pixel_len;
+  return( samples );
+} /* Pixel_Samples_Fixed() */
+
+/*------------------------------------------------------------------------*/
+
+/* Zero_Crossing_Fixed()
+ *
+ * The zero crossing detector of Zero_Crossing_Pixel()
+ * in integer arithmetic, for CPUs without a fast FPU
+ */
+  static gboolean
+Zero_Crossing_Fixed( unsigned char *signal_level )
+{
+  short
+    signal_sample,   /* Signal sample from DSP */
+    signal_max = 0;  /* Maximum level from Audio DSP */
+
+  int32_t sample, diff, discrim_output, half_cycle;
+
+  // Half the Audio sample rate
+  int32_t sample_rate2 = rc_data.dsp_rate / 2;
+
+  // Minimum length of WEFAX signal 1/3 cycle in Audio samples
+  int min_cycle3 = rc_data.dsp_rate / rc_data.white_freq / 3;
+
+  // Number of Audio samples in the pixel
+  int idx, samples;
+
+  PERF_BEGIN( PERF_FM_DETECT );
+
+  /* Look for a zero crossing of the WEFAX audio
+   * signal over the duration of each image pixel */
+  samples = Pixel_Samples_Fixed(
+      &zero_fixed.samples_used_cnt, detect_pixel_len_q16 );
+  for( idx = 0; idx < samples; idx++ )
+  {
+    signal_sample = 0;
+
+    /* Get new sample from Perseus DSP */
+    if( rc_data.tcvr_type == PERSEUS )
+    {
+#ifdef HAVE_LIBPERSEUS_SDR
+      Demodulate_SSB( &signal_sample );
+#endif
+    }
+    else
+    {
+      /* Get new sample from DSP buffer */
+      if( !Sound_Signal_Sample(&signal_sample) )
+        return( FALSE );
+    }
+
+    /* Get max absolute value of signal sample */
+    if( signal_max < abs(signal_sample) )
+      signal_max = (short)( abs(signal_sample) );
+
+    // Sliding widow average of DSP signal samples, rounded
+    sample = (int32_t)signal_sample << FIXED_AVE_SHIFT;
+    zero_fixed.new_average +=
+      ( (sample - zero_fixed.new_average) * SIG_AVE_GAIN_Q15 +
+        (Q15_ONE >> 1) ) >> Q15_SHIFT;
+
+    // This gives us a zero crossing of the input waveform
+    zero_fixed.inter_zero_samples++;
+    if( ((int64_t)zero_fixed.new_average * zero_fixed.last_average <= 0) &&
+        (zero_fixed.inter_zero_samples >= min_cycle3) )
+    {
+      // Interpolate point of zero crossing
+      diff = zero_fixed.last_average - zero_fixed.new_average;
+      if( diff != 0 )
+        zero_fixed.zero_cross_interp =
+          ( zero_fixed.new_average << FIXED_TIME_SHIFT ) / diff;
+      if( zero_fixed.zero_cross_interp < -FIXED_TIME_ONE )
+        zero_fixed.zero_cross_interp = -FIXED_TIME_ONE;
+      if( zero_fixed.zero_cross_interp >  FIXED_TIME_ONE )
+        zero_fixed.zero_cross_interp =  FIXED_TIME_ONE;
+
+      // Record crossing time for re-rendering
+      if( isFlagSet(SAVE_IMAGE_RAW) )
+        Raw_Crossing( (double)idx +
+            (double)zero_fixed.zero_cross_interp / FIXED_TIME_ONE );
+
+      zero_fixed.pixel_num_zeros++;
+      zero_fixed.period_cnt_incr    = 0;
+      zero_fixed.inter_zero_samples = 0;
+    }
+
+    // Save current signal average
+    zero_fixed.last_average = zero_fixed.new_average;
+
+    // Count number of signal samples between zero crossings
+    zero_fixed.period_cnt_incr++;
+  } // for( idx = 0; idx < samples; idx++ )
+  Raw_Advance( samples );
+
+  // Period between zeros, limited while there are none
+  zero_fixed.zeros_period += samples << FIXED_TIME_SHIFT;
+  if( zero_fixed.zeros_period > FIXED_PERIOD_MAX )
+    zero_fixed.zeros_period = FIXED_PERIOD_MAX;
+
+  // Add extrapolation of zero crossing
+  if( zero_fixed.pixel_num_zeros )
+  {
+    // Calculate signal frequency from half cycle period
+    zero_fixed.zeros_period += zero_fixed.zero_cross_interp;
+    half_cycle = ( zero_fixed.zeros_period -
+        (zero_fixed.period_cnt_incr << FIXED_TIME_SHIFT) ) /
+      zero_fixed.pixel_num_zeros;
+    if( half_cycle != 0 )
+      zero_fixed.signal_freq = (int32_t)(
+          ((int64_t)sample_rate2 << (FIXED_TIME_SHIFT + FIXED_FREQ_SHIFT)) /
+          half_cycle );
+
+    /* Prepares zeros_period to properly count
+     * signal samples to next zero crossing */
+    zero_fixed.zeros_period =
+      ( zero_fixed.period_cnt_incr << FIXED_TIME_SHIFT ) -
+      zero_fixed.zero_cross_interp;
+    zero_fixed.period_cnt_incr = 0;
+  }
+  zero_fixed.pixel_num_zeros = 0;
+
+  // Scale and floor frequency to give a value 0-255
+  discrim_output = zero_fixed.signal_freq /
+    (int32_t)( DISCR_SCALE * (1 << FIXED_FREQ_SHIFT) ) - (int32_t)DISCR_FLOOR;
+
+  // Limit disriminator output in right range
+  if( discrim_output > 255 ) discrim_output = 255;
+  if( discrim_output < 0 )   discrim_output = 0;
+  *signal_level = (unsigned char)discrim_output;
+
+  /* Display maximum signal level scaled down */
+  Signal_Level_Display( signal_max );
+
+  PERF_END( PERF_FM_DETECT );
+  return( TRUE );
+} // Zero_Crossing_Fixed()
+
+//------------------------------------------------------------------------
+
+/* Bilevel_Fixed()
+ *
+ * The bilevel detector of Bilevel_Pixel() in integer
+ * arithmetic, with Q14 Goertzel detector coefficients
+ */
+  static gboolean
+Bilevel_Fixed( unsigned char *signal_level )
+{
+  int idx, samples, black_level, white_level;
+  int32_t black_q0, black_q1, black_q2;
+  int32_t white_q0, white_q1, white_q2;
+  int32_t black_coeff, white_coeff;
+  int64_t power;
+  short *signal_buff, signal_max;
+  int signal_idx, det_period;
+
+  /* Initialize on first call and on a change of DSP rate */
+  if( (bilevel.dsp_rate != rc_data.dsp_rate) && !Bilevel_Init() )
+    return( FALSE );
+
+  signal_buff = bilevel.signal_buff;
+  signal_idx  = bilevel.signal_idx;
+  det_period  = bilevel.det_period;
+  black_coeff = bilevel.black_coeff_q14;
+  white_coeff = bilevel.white_coeff_q14;
+
+  /* Save samples for detector */
+  PERF_BEGIN( PERF_FM_DETECT );
+  signal_max = 0;
+  samples = Pixel_Samples_Fixed( &bilevel.pixel_idx_q16, detect_pixel_len_q16 );
+  for( idx = 0; idx < samples; idx++ )
+  {
+    if( rc_data.tcvr_type == PERSEUS )
+    {
+#ifdef HAVE_LIBPERSEUS_SDR
+      Demodulate_SSB( &signal_buff[signal_idx] );
+#endif
+    }
+    else
+    {
+      /* Get signal sample from buffer, abort on error */
+      if( !Sound_Signal_Sample(&signal_buff[signal_idx]) )
+      {
+        bilevel.signal_idx = signal_idx;
+        return( FALSE );
+      }
+    }
+
+    /* Get max absolute value of signal sample */
+    if( signal_max < abs(signal_buff[signal_idx]) )
+      signal_max = (short)( abs(signal_buff[signal_idx]) );
+
+    /* Increment/reset circular buffer's index */
+    signal_idx++;
+    if( signal_idx >= det_period ) signal_idx = 0;
+
+  } /* for( idx = 0; idx < samples; idx++ ) */
+  bilevel.signal_idx = signal_idx;
+  Raw_Advance( samples );
+
+  /* Calculate signal level of black and white
+   * tone frequencies using Goertzel algorithm */
+  black_q1 = black_q2 = 0;
+  white_q1 = white_q2 = 0;
+  for( idx = 0; idx < det_period; idx++ )
+  {
+    black_q0 = (int32_t)( ((int64_t)black_coeff * black_q1) >> Q14_SHIFT ) -
+      black_q2 + signal_buff[signal_idx];
+    black_q2 = black_q1;
+    black_q1 = black_q0;
+
+    white_q0 = (int32_t)( ((int64_t)white_coeff * white_q1) >> Q14_SHIFT ) -
+      white_q2 + signal_buff[signal_idx];
+    white_q2 = white_q1;
+    white_q1 = white_q0;
+
+    /* Increment/reset circular buffers' index */
+    signal_idx++;
+    if( signal_idx >= det_period ) signal_idx = 0;
+
+  } /* for( idx = 0; idx < det_period; idx++ ) */
+
+  /* Magnitude of black and white tones scaled by dot size and tone freq */
+  power = (int64_t)black_q1 * black_q1 + (int64_t)black_q2 * black_q2 -
+    ( ((int64_t)black_q1 * black_q2 * black_coeff) >> Q14_SHIFT );
+  black_level = (int)( power / bilevel.scale_sq );
+  power = (int64_t)white_q1 * white_q1 + (int64_t)white_q2 * white_q2 -
+    ( ((int64_t)white_q1 * white_q2 * white_coeff) >> Q14_SHIFT );
+  white_level = (int)( power / bilevel.scale_sq );
+
+  *signal_level = Bilevel_Level( black_level, white_level );
+
+  /* Display maximum signal level scaled down */
+  Signal_Level_Display( signal_max );
+
+  PERF_END( PERF_FM_DETECT );
+  return( TRUE );
+} /* Bilevel_Fixed() */
+
+/*------------------------------------------------------------------------*/
+
+/* Detector instances with the pixel length of a standard mode
+ * as compile time constants, and the generic ones for custom modes */
+#define DETECT_INSTANCE( rate, rpm, ppl ) \
+  static gboolean \
+  Zero_Crossing_##rate##_##rpm##_##ppl( unsigned char *signal_level ) \
+  { return( Zero_Crossing_Pixel(signal_level, rate * 60, rpm * ppl) ); } \
+  static gboolean \
+  Bilevel_##rate##_##rpm##_##ppl( unsigned char *signal_level ) \
+  { return( Bilevel_Pixel(signal_level, rate * 60, rpm * ppl) ); }
+
+#define DETECT_ENTRY( rate, rpm, ppl ) \
+  { rate, rpm, ppl, \
+    Zero_Crossing_##rate##_##rpm##_##ppl, Bilevel_##rate##_##rpm##_##ppl },
+
+DETECT_MODES( DETECT_INSTANCE )
+
+  static gboolean
+Zero_Crossing_Generic( unsigned char *signal_level )
+{
+  return( Zero_Crossing_Pixel(signal_level, 0, 0) );
+}
+
+  static gboolean
+Bilevel_Generic( unsigned char *signal_level )
+{
+  return( Bilevel_Pixel(signal_level, 0, 0) );
+}
+
+/* Table of the standard modes' detector instances */
+static const detect_mode_t detect_modes[] =
+{
+  DETECT_MODES( DETECT_ENTRY )
+};
+
+static const detect_mode_t detect_generic =
+  { 0, 0, 0, Zero_Crossing_Generic, Bilevel_Generic };
+
+static const detect_mode_t detect_fixed =
+  { 0, 0, 0, Zero_Crossing_Fixed, Bilevel_Fixed };
+
+/* Detector instances in use, the pixel length and
+ * arithmetic they were selected for */
+static const detect_mode_t *detect_mode = &detect_generic;
+static double detect_pixel_len = 0.0;
+static int detect_fixed_point = 0;
+
+/* Enables the selection of specialized instances */
+static gboolean detect_specialize = TRUE;
+
+/*------------------------------------------------------------------------*/
+
+/* Detect_Select_Mode()
+ *
+ * Selects the detector instances specialized for the
+ * current mode or the generic ones for a custom mode
+ */
+  static void
+Detect_Select_Mode( void )
+{
+  size_t idx;
+
+  detect_mode = &detect_generic;
+  detect_pixel_len = rc_data.pixel_len;
+  detect_fixed_point = isFlagSet( FIXED_POINT );
+
+  /* Integer arithmetic detectors */
+  if( detect_fixed_point )
+  {
+    detect_mode = &detect_fixed;
+    detect_pixel_len_q16 = TO_FIXED( rc_data.pixel_len, FIXED_PIXEL_SHIFT );
+  }
+
+  /* Sync slant and Perseus rate corrections make a custom pixel length */
+  else if( detect_specialize && (rc_data.sync_slant == 0.0) )
+    for( idx = 0; idx < sizeof(detect_modes) / sizeof(detect_mode_t); idx++ )
+    {
+      const detect_mode_t *mode = &detect_modes[idx];
+      if( (rc_data.dsp_rate == mode->dsp_rate) &&
+          (rc_data.lines_per_min   == (double)mode->lines_per_min) &&
+          (rc_data.pixels_per_line == mode->pixels_per_line) )
+      {
+        detect_mode = mode;
+        break;
+      }
+    }
+
+  /* Start a new pixel count in the instances */
+  zero_cross.samples_used_cnt = bilevel.pixel_idx = 0.0;
+  zero_cross.residual = bilevel.residual = 0;
+  zero_fixed.samples_used_cnt = bilevel.pixel_idx_q16 = 0;
+
+} /* Detect_Select_Mode() */
+
+/*------------------------------------------------------------------------*/
+
+/* Detect_Specialize()
+ *
+ * Enables or disables the detector instances specialized
+ * for standard modes, leaving the generic ones in use
+ */
+  void
+Detect_Specialize( gboolean enable )
+{
+  detect_specialize = enable;
+  detect_pixel_len  = 0.0;
+} /* Detect_Specialize() */
+
+/*------------------------------------------------------------------------*/
+
+/* FM_Detect_Zero_Crossing()
+ *
+ * Zero crossing FM detector, runs the instance of the detector
+ * specialized for the current mode or the fixed point one
+ */
+  gboolean
+FM_Detect_Zero_Crossing( unsigned char *signal_level )
+{
+  if( (detect_pixel_len != rc_data.pixel_len) ||
+      (detect_fixed_point != isFlagSet(FIXED_POINT)) )
+    Detect_Select_Mode();
+  return( detect_mode->zero_crossing(signal_level) );
+} /* FM_Detect_Zero_Crossing() */
+
+/*------------------------------------------------------------------------*/
+
+/* FM_Detect_Bilevel()
+ *
+ * Bilevel FM detector, runs the instance of the detector
+ * specialized for the current mode or the fixed point one
+ */
+  gboolean
+FM_Detect_Bilevel( unsigned char *signal_level )
+{
+  if( (detect_pixel_len != rc_data.pixel_len) ||
+      (detect_fixed_point != isFlagSet(FIXED_POINT)) )
+    Detect_Select_Mode();
+  return( detect_mode->bilevel(signal_level) );
+} /* FM_Detect_Bilevel() */
+
+/*------------------------------------------------------------------------*/
+
+/* Phasing_Filter_Init()
+ *
+ * Sets up the phasing pulse matched filter for the current
+ * resolution, with an FFT long enough for a line and a pulse
+ */
+  static gboolean
+Phasing_Filter_Init( void )
+{
+  int idx, size;
+  size_t mreq;
+
+  /* FFT size for the linear correlation of a line, extended by
+   * the pulse length to wrap around, with the pulse template */
+  for( size = 2; size < rc_data.pixels_per_line + PHASING_PULSE_LEN; )
+    size <<= 1;
+
+  mreq = sizeof(float) * (size_t)size;
+  if( !mem_realloc((void **)&phasing.re, mreq) ||
+      !mem_realloc((void **)&phasing.im, mreq) ||
+      !mem_realloc((void **)&phasing.pulse_re, mreq) ||
+      !mem_realloc((void **)&phasing.pulse_im, mreq) ||
+      !mem_realloc((void **)&phasing.cos_tab, mreq / 2) ||
+      !mem_realloc((void **)&phasing.sin_tab, mreq / 2) ||
+      !mem_realloc((void **)&phasing.rev, sizeof(int) * (size_t)size) ||
+      !mem_realloc((void **)&phasing.line_sum,
+        sizeof(double) * (size_t)rc_data.pixels_per_line) )
+  {
+    Show_Message( _("Memory Allocation failed\n"
+          "for phasing pulse filter"), "red" );
+    phasing.pixels_per_line = 0;
+    return( FALSE );
+  }
+  FFT_Tables( phasing.cos_tab, phasing.sin_tab, phasing.rev, size );
+
+  /* Spectrum of the pulse template */
+  for( idx = 0; idx < size; idx++ )
+  {
+    phasing.pulse_re[idx] = ( idx < PHASING_PULSE_LEN ) ? 1.0f : 0.0f;
+    phasing.pulse_im[idx] = 0.0f;
+  }
+  DSP_Kernels->fft( phasing.pulse_re, phasing.pulse_im,
+      phasing.cos_tab, phasing.sin_tab, phasing.rev, size );
+
+  phasing.fft_size = size;
+  phasing.pixels_per_line = rc_data.pixels_per_line;
+  phasing.lines = 0;
+  bzero( phasing.line_sum,
+      sizeof(double) * (size_t)phasing.pixels_per_line );
+
+  return( TRUE );
+} /* Phasing_Filter_Init() */
+
+/*------------------------------------------------------------------------*/
+
+/* Phasing_Filter_Reset()
+ *
+ * Discards the phasing lines examined
+ */
+  static void
+Phasing_Filter_Reset( void )
+{
+  if( phasing.pixels_per_line )
+    bzero( phasing.line_sum,
+        sizeof(double) * (size_t)phasing.pixels_per_line );
+  phasing.lines = 0;
+
+} /* Phasing_Filter_Reset() */
+
+/*------------------------------------------------------------------------*/
+
+/* Phasing_Filter()
+ *
+ * Adds a line to the sum of phasing lines and correlates the sum,
+ * circularly, with the phasing pulse through the FFT. Returns the
+ * normalized correlation at its peak, 1.0 for a clean pulse on black
+ * lines, and the position of the pulse's start in *pulse_idx
+ */
+  static double
+Phasing_Filter( const unsigned char *line, int *pulse_idx )
+{
+  int idx, size = phasing.fft_size, len = phasing.pixels_per_line;
+  double mean = 0.0, var = 0.0, peak, pulse_var;
+  float *re = phasing.re, *im = phasing.im, a, b;
+
+  /* Sum of the lines and its mean and variance. The
+   * noise in the sum grows slower than the pulse */
+  phasing.lines++;
+  for( idx = 0; idx < len; idx++ )
+  {
+    phasing.line_sum[idx] += (double)line[idx];
+    mean += phasing.line_sum[idx];
+  }
+  mean /= (double)len;
+  for( idx = 0; idx < len; idx++ )
+    var += ( phasing.line_sum[idx] - mean ) *
+      ( phasing.line_sum[idx] - mean );
+  var /= (double)len;
+  *pulse_idx = 0;
+  if( var <= 0.0 ) return( 0.0 );
+
+  /* Sum of lines without its mean, extended to wrap around */
+  for( idx = 0; idx < size; idx++ )
+  {
+    re[idx] = ( idx < len + PHASING_PULSE_LEN ) ?
+      (float)( phasing.line_sum[idx % len] - mean ) : 0.0f;
+    im[idx] = 0.0f;
+  }
+  DSP_Kernels->fft( re, im, phasing.cos_tab,
+      phasing.sin_tab, phasing.rev, size );
 
-  /* Display maximum signal level scaled down */
-  if( isFlagClear(DISPLAY_SIGNAL) )
+  /* Multiply by the conjugate spectrum of the pulse, and
+   * conjugate again for the inverse FFT by the forward one */
+  for( idx = 0; idx < size; idx++ )
   {
-    Display_Signal( (unsigned char)(signal_max >> 7) );
-    gauge_input  = (int)(signal_max / SIG_GAUGE_SCALE);
-    gauge_level1 = SIG_GAUGE_LEVEL1;
-    gauge_level2 = SIG_GAUGE_LEVEL2;
-    Queue_Draw_Gauge();
+    a = re[idx];
+    b = im[idx];
+    re[idx] = a * phasing.pulse_re[idx] + b * phasing.pulse_im[idx];
+    im[idx] = a * phasing.pulse_im[idx] - b * phasing.pulse_re[idx];
   }
+  DSP_Kernels->fft( re, im, phasing.cos_tab,
+      phasing.sin_tab, phasing.rev, size );
 
-  return( TRUE );
-} /* FM_Detect_Bilevel() */
+  /* Peak of the correlation over a line */
+  for( idx = 1; idx < len; idx++ )
+    if( re[idx] > re[*pulse_idx] ) *pulse_idx = idx;
+  peak = (double)re[ *pulse_idx ] / (double)size;
+
+  /* Normalized by the deviations of the lines and of a pulse */
+  pulse_var = (double)PHASING_PULSE_LEN / (double)len;
+  pulse_var *= 1.0 - pulse_var;
+  return( peak / (double)len / sqrt(var * pulse_var) );
+
+} /* Phasing_Filter() */
 
 /*------------------------------------------------------------------------*/
 
 /*  Phasing_Detect()
  *
- *  Detects phasing pulses using Goertzel's algorithm.
+ *  Detects phasing pulses with a matched filter, correlating
+ *  the phasing lines with the pulse. Image decoding starts as
+ *  soon as the pulse is found clearly, or after phasing_lines
  */
 
   gboolean
 Phasing_Detect( void )
 {
-  static int
-    pixels_per_line = 0, /* WEFAX RPM or lines per minute */
-    pixel_idx       = 0, /* Index to pixels in Wefax line */
-    phasing_cnt     = 0, /* Count of phasing pulse lines examined */
-    phasing_error   = 0, /* The distance of phasing pulse from line middle  */
-    phasing_ref;         /* Reference for initial position of phasing pulse */
-
-  /* Average of phasing pulse over sliding window */
-  static double phasing_pulse_ave = 0.0;
-
   int
-    error_limit,        /* Max value of phasing pulse position error */
-    phasing_pulse_max,  /* Maximum level of above over the length of a line  */
-    pulse_max_idx = 0;  /* Fragment count where maximum pulse level occurs */
+    phasing_error, /* The distance of phasing pulse from line middle */
+    pulse_idx;     /* Position of the phasing pulse's start */
+
+  double ncc; /* Normalized correlation with phasing pulse */
 
   /* Output from FM detector */
   unsigned char discr_op;
 
 
   /* Initialize on change of parameters */
-  if( pixels_per_line != rc_data.pixels_per_line )
+  if( phasing.pixels_per_line != rc_data.pixels_per_line )
   {
-    /* We need to look for a phasing pulse maximum
-     * over the length (in pixesls) of 1 WEFAX line */
-    pixels_per_line = rc_data.pixels_per_line;
+    if( !Phasing_Filter_Init() ) return( FALSE );
 
-    /* This puts the pahsing pulse in the middle
+    /* This puts the phasing pulse in the middle
      * of the image line during the syncing process */
-    phasing_ref = pixels_per_line / 2 + PHASING_PULSE_LEN;
+    phasing.ref = rc_data.pixels_per_line / 2 + PHASING_PULSE_LEN;
 
-    pixel_idx = 0;
-  } /* if( pixels_per_line != rc_data.pixels_per_line ) */
+    phasing.pixel_idx = 0;
+    phasing.count     = 0;
+  } /* if( phasing.pixels_per_line != rc_data.pixels_per_line ) */
 
   /* Stop on user request */
   if( isFlagSet(RECEIVE_STOP) )
   {
-    pixel_idx     = 0;
-    phasing_cnt   = 0;
-    phasing_error = 0;
-    wefax_action  = ACTION_STOP;
+    phasing.pixel_idx = 0;
+    phasing.count     = 0;
+    Phasing_Filter_Reset();
+    wefax_action = ACTION_STOP;
     return( TRUE );
   }
 
@@ -413,10 +1090,10 @@ Phasing_Detect( void )
     Set_Indicators( ICON_SYNC_SKIP );
 
     ClearFlag( SKIP_ACTION );
-    pixel_idx     = 0;
-    phasing_cnt   = 0;
-    phasing_error = 0;
-    wefax_action  = ACTION_DECODE;
+    phasing.pixel_idx = 0;
+    phasing.count     = 0;
+    Phasing_Filter_Reset();
+    wefax_action = ACTION_DECODE;
     return( TRUE );
   }
 
@@ -433,58 +1110,33 @@ Phasing_Detect( void )
 
   /* Advance line buffer input index */
   linebuff_input++;
-  if( linebuff_input >= pixels_per_line )
+  if( linebuff_input >= rc_data.pixels_per_line )
     linebuff_input = 0;
 
-  pixel_idx++;
-  if( pixel_idx < pixels_per_line ) return( TRUE );
-
-  /* Look for a phasing pulse maximum over a line.
-   * We begin the index from -phasing_error to dump
-   * the number of pixels needed to center the pulse */
-  phasing_pulse_max = -256;
-  phasing_pulse_ave = 0.0;
-
-  /* Look for phasing pulse maximum */
-  for( pixel_idx = 0; pixel_idx < pixels_per_line; pixel_idx++ )
+  phasing.pixel_idx++;
+  if( phasing.pixel_idx < rc_data.pixels_per_line ) return( TRUE );
+  phasing.pixel_idx = 0;
+
+  /* Correlate the phasing lines so far with the pulse.
+   * The line buffer is not shifted until the pulse is
+   * locked, so that the lines add up in the same place */
+  ncc = Phasing_Filter( line_buffer, &pulse_idx );
+  phasing.count++;
+
+  /* Lock on a clear pulse, or look for phasing
+   * pulses over most of phasing lines at most */
+  if( ((phasing.count >= PHASING_MIN_LINES) &&
+        (ncc >= PHASING_LOCK_NCC)) ||
+      (phasing.count > rc_data.phasing_lines) )
   {
-    /* Average line buffer pixel values */
-    phasing_pulse_ave *= PHASING_PUSLE_WIN - 1.0;
-    phasing_pulse_ave += (double)line_buffer[ pixel_idx ];
-    phasing_pulse_ave /= PHASING_PUSLE_WIN;
-
-    /* Record the input buffer index where max occurs */
-    if( phasing_pulse_max < (int)phasing_pulse_ave )
-    {
-      phasing_pulse_max = (int)phasing_pulse_ave;
-      pulse_max_idx     = pixel_idx;
-    }
-  } /* for( pixel_idx = 0; pixel_idx < pixels_per_line; pixel_idx++ */
+    /* Adjust the line buffer index by the phasing error */
+    phasing_error = pulse_idx - phasing.ref;
+    linebuff_input -= phasing_error;
+    if( linebuff_input >= rc_data.pixels_per_line )
+      linebuff_input -= rc_data.pixels_per_line;
+    else if( linebuff_input < 0 )
+      linebuff_input += rc_data.pixels_per_line;
 
-  /* Count phasing pulse lines */
-  phasing_cnt++;
-
-  /* Limit of pulse position error is
-   * reduced progressively with line count */
-  error_limit   = pixels_per_line / 2 / phasing_cnt;
-  phasing_error = pulse_max_idx - phasing_ref;
-
-  /* Limit value of phasing error to avoid big jumps */
-  if( phasing_error > error_limit )
-    phasing_error = error_limit;
-  else if( phasing_error < -error_limit )
-    phasing_error = -error_limit;
-
-  /* Adjust the line buffer index by the phasing error */
-  linebuff_input -= phasing_error;
-  if( linebuff_input >= pixels_per_line )
-    linebuff_input -= pixels_per_line;
-  else if( linebuff_input < 0 )
-    linebuff_input += pixels_per_line;
-
-  /* Look for phasing pulses over most of phasing lines */
-  if( phasing_cnt > rc_data.phasing_lines )
-  {
     /* Point the line buffer output index to middle
      * of the lines buffer, this puts the phasing
      * pulse at the beginning of image lines */
@@ -495,13 +1147,11 @@ Phasing_Detect( void )
     Show_Message( _("Starting WEFAX Image Decoder ..."), "black" );
     Show_Message( _("Listening for Stop Tone ..."), "black" );
     Set_Indicators( ICON_SYNC_APPLY );
-    pixel_idx     = 0;
-    phasing_cnt   = 0;
-    phasing_error = 0;
-    wefax_action  = ACTION_DECODE;
+    phasing.count = 0;
+    Phasing_Filter_Reset();
+    wefax_action = ACTION_DECODE;
   }
 
-  pixel_idx = 0;
   return( TRUE );
 } /* Phasing_Detect() */
 
@@ -510,23 +1160,20 @@ Phasing_Detect( void )
 /* Tone_Detect()
  *
  * Detects audio tones used for start and stop signaling.
- * The tone period is in pixels and input in pixel levels.
+ * The tone period is in pixels and input in pixel levels,
+ * or in outputs of a decimated discriminator and their levels.
  */
 
   static void
 Tone_Detect(
+    tone_detector_t *det,
     double tone_period,
     unsigned char input,
     int *tone_level )
 {
-  static int
-    level_ave = 0,   /* Sliding window average of tone level */
-    input_cnt,       /* Count of pixel level inputs */
-    detector_period; /* Integration period of Goertzel detector */
-
-  /* Variables for the Goertzel algorithm */
-  static double coeff, period;
-  static double q0 = 0.0, q1 = 0.0, q2 = 0.0;
+  double q0;
+  int32_t fq0;
+  int64_t power;
 
   int level; /* Detected Tone level */
 
@@ -534,9 +1181,9 @@ Tone_Detect(
   /* Stop on user request */
   if( isFlagSet(RECEIVE_STOP) )
   {
-    input_cnt = 0;
-    period    = 0.0;
-    level_ave = 0;
+    det->input_cnt = 0;
+    det->period    = 0.0;
+    det->level_ave = 0;
     wefax_action = ACTION_STOP;
     return;
   } /* if( isFlagSet(RECEIVE_STOP) ) */
@@ -549,74 +1196,640 @@ Tone_Detect(
     linebuff_output =
       rc_data.line_buffer_size - rc_data.pixels_per_line2;
 
-    input_cnt = 0;
-    period    = 0.0;
-    level_ave = 0;
+    det->input_cnt = 0;
+    det->period    = 0.0;
+    det->level_ave = 0;
     return;
   }
 
   /* Initialize on new parameters */
-  if( period != tone_period )
+  if( det->period != tone_period )
   {
-    period = tone_period;
-    detector_period = (int)
-      ( period * TONE_PERIOD_MULT / rc_data.lines_per_min + 0.5 );
+    det->period = tone_period;
+    det->detector_period = (int)
+      ( det->period * TONE_PERIOD_MULT / rc_data.lines_per_min + 0.5 );
 
-    double w = M_2PI / period;
-    coeff = 2.0 * cos( w );
+    double w = M_2PI / det->period;
+    det->coeff = 2.0 * cos( w );
+    det->coeff_q14 = TO_FIXED( det->coeff, Q14_SHIFT );
+    det->period_sq_q8 =
+      (int64_t)( det->period * det->period * 256.0 + 0.5 );
 
     /* Reset variables */
-    input_cnt = 0;
-    q0 = q1 = q2 = 0.0;
-    level_ave = 0;
-  } /* if( period != tone_period ) */
+    det->input_cnt = 0;
+    det->q1  = det->q2  = 0.0;
+    det->fq1 = det->fq2 = 0;
+    det->level_ave = 0;
+  } /* if( det->period != tone_period ) */
 
   /* Calculate Start/Stop level using Goertzel algorithm */
-  q0 = coeff * q1 - q2 + (double)input - 127.0;
-  q2 = q1;
-  q1 = q0;
+  if( isFlagSet(FIXED_POINT) )
+  {
+    fq0 = (int32_t)( ((int64_t)det->coeff_q14 * det->fq1) >> Q14_SHIFT ) -
+      det->fq2 + (int32_t)input - 127;
+    det->fq2 = det->fq1;
+    det->fq1 = fq0;
+  }
+  else
+  {
+    q0 = det->coeff * det->q1 - det->q2 + (double)input - 127.0;
+    det->q2 = det->q1;
+    det->q1 = q0;
+  }
 
   /* Compute tone level and reset after detector_period inputs */
-  if( input_cnt++ >= detector_period )
+  if( det->input_cnt++ >= det->detector_period )
   {
     /* Reduce the magnitude to reasonable levels */
-    q1 /= period;
-    q2 /= period;
-    level = (int)( q1 * q1 + q2 * q2 - q1 * q2 * coeff );
+    if( isFlagSet(FIXED_POINT) )
+    {
+      power = (int64_t)det->fq1 * det->fq1 +
+        (int64_t)det->fq2 * det->fq2 -
+        ( ((int64_t)det->fq1 * det->fq2 * det->coeff_q14) >> Q14_SHIFT );
+      level = (int)( (power << 8) / det->period_sq_q8 );
+    }
+    else
+    {
+      det->q1 /= det->period;
+      det->q2 /= det->period;
+      level = (int)( det->q1 * det->q1 + det->q2 * det->q2 -
+          det->q1 * det->q2 * det->coeff );
+    }
 
     /* Compute sliding average of tone level and return */
-    level_ave *= TONE_LEVEL_AVE_WIN - 1;
-    level_ave += level;
-    level_ave /= TONE_LEVEL_AVE_WIN;
+    det->level_ave *= TONE_LEVEL_AVE_WIN - 1;
+    det->level_ave += level;
+    det->level_ave /= TONE_LEVEL_AVE_WIN;
 
     /* Reset variables */
-    q0 = q1 = q2 = 0.0;
-    input_cnt = 0;
-  } /* if( input_cnt++ >= detector_period ) */
+    det->q1  = det->q2  = 0.0;
+    det->fq1 = det->fq2 = 0;
+    det->input_cnt = 0;
+  } /* if( det->input_cnt++ >= det->detector_period ) */
 
-  *tone_level = level_ave;
+  *tone_level = det->level_ave;
 
   return;
 } /* Tone_Detect() */
 
 /*------------------------------------------------------------------------*/
 
+/* IOC values and their start tones, and the standard RPM values,
+ * detected in parallel when the IOC and RPM are set automatically */
+static const int bank_ioc[ NUM_IOC ]  = { IOC288, IOC576 };
+static const int bank_tone[ NUM_IOC ] =
+{ IOC288_START_TONE, IOC576_START_TONE };
+static const int bank_rpm[ NUM_RPM ]  =
+{ RPM60, RPM90, RPM100, RPM120, RPM180, RPM240 };
+
+/* State of the RPM detector bank, run on the phasing signal */
+static struct
+{
+  gboolean active; /* Measuring the RPM */
+
+  int
+    count,  /* Count of pixels measured */
+    length, /* Most pixels to measure */
+    step;   /* Pixels between evaluations of the levels */
+
+  double
+    pixel_rate, /* Rate of pixels from the FM detector, per sec */
+    sum;        /* Sum of the pixels measured */
+
+  /* DFT bins of the pixels and of a constant at the line rates, with
+   * the phasors of the bins and their rotation per pixel, as re/im */
+  double
+    bin_re[ NUM_RPM ],   bin_im[ NUM_RPM ],
+    dc_re[ NUM_RPM ],    dc_im[ NUM_RPM ],
+    phase_re[ NUM_RPM ], phase_im[ NUM_RPM ],
+    rot_re[ NUM_RPM ],   rot_im[ NUM_RPM ];
+} rpm_detect;
+
+/*------------------------------------------------------------------------*/
+
+/* Rpm_Detect_Init()
+ *
+ * Starts measuring the line rate of the phasing signal
+ * with a single bin DFT at each standard RPM
+ */
+  static void
+Rpm_Detect_Init( void )
+{
+  int idx;
+
+  rpm_detect.pixel_rate =
+    rc_data.lines_per_min / 60.0 * (double)rc_data.pixels_per_line;
+  rpm_detect.length = (int)( RPM_DETECT_SECS * rpm_detect.pixel_rate );
+  rpm_detect.step   = (int)( RPM_DETECT_STEP * rpm_detect.pixel_rate );
+  rpm_detect.count  = 0;
+  rpm_detect.sum    = 0.0;
+  rpm_detect.active = TRUE;
+
+  for( idx = 0; idx < NUM_RPM; idx++ )
+  {
+    double w = M_2PI * (double)bank_rpm[idx] / 60.0 / rpm_detect.pixel_rate;
+    rpm_detect.rot_re[idx]   = cos( w );
+    rpm_detect.rot_im[idx]   = -sin( w );
+    rpm_detect.phase_re[idx] = 1.0;
+    rpm_detect.phase_im[idx] = 0.0;
+    rpm_detect.bin_re[idx] = rpm_detect.bin_im[idx] = 0.0;
+    rpm_detect.dc_re[idx]  = rpm_detect.dc_im[idx]  = 0.0;
+  }
+
+} /* Rpm_Detect_Init() */
+
+/*------------------------------------------------------------------------*/
+
+/* Rpm_Detect_Level()
+ *
+ * Returns the index of the lowest standard RPM with a strong
+ * level so far, as higher ones may be harmonics of it, or -1
+ */
+  static int
+Rpm_Detect_Level( void )
+{
+  double level[ NUM_RPM ], level_max = 0.0, mean, re, im;
+  int idx;
+
+  /* Amplitude of the signal at each line rate. The mean level is
+   * removed, as it leaks into the bins over short measurements */
+  mean = rpm_detect.sum / (double)rpm_detect.count;
+  for( idx = 0; idx < NUM_RPM; idx++ )
+  {
+    re = rpm_detect.bin_re[idx] - mean * rpm_detect.dc_re[idx];
+    im = rpm_detect.bin_im[idx] - mean * rpm_detect.dc_im[idx];
+    level[idx] = 2.0 / (double)rpm_detect.count * sqrt( re * re + im * im );
+    if( level[idx] > level_max ) level_max = level[idx];
+  }
+
+  for( idx = 0; idx < NUM_RPM; idx++ )
+    if( (level[idx] >= RPM_DETECT_LEVEL) &&
+        (level[idx] >= RPM_DETECT_RATIO * level_max) )
+      return( idx );
+
+  return( -1 );
+} /* Rpm_Detect_Level() */
+
+/*------------------------------------------------------------------------*/
+
+/* Rpm_Detect()
+ *
+ * Measures the line rate of the phasing signal until the rate
+ * found is told apart from its neighbors, and sets the RPM to
+ * it. Goes on to synchronizing with the phasing pulses when done
+ */
+  static gboolean
+Rpm_Detect( void )
+{
+  unsigned char discr_op;
+  double spacing, re;
+  int idx;
+  char mesg[MESG_SIZE];
+
+
+  /* Leave stop and skip requests to the start tone detector */
+  if( isFlagSet(RECEIVE_STOP) || isFlagSet(SKIP_ACTION) )
+  {
+    rpm_detect.active = FALSE;
+    return( TRUE );
+  }
+
+  if( !FM_Detector(&discr_op) ) return( FALSE );
+  if( isFlagSet(DISPLAY_SIGNAL) )
+    Display_Signal( discr_op );
+
+  /* Accumulate the DFT bins and advance their phasors */
+  rpm_detect.sum += (double)discr_op;
+  for( idx = 0; idx < NUM_RPM; idx++ )
+  {
+    rpm_detect.bin_re[idx] += (double)discr_op * rpm_detect.phase_re[idx];
+    rpm_detect.bin_im[idx] += (double)discr_op * rpm_detect.phase_im[idx];
+    rpm_detect.dc_re[idx]  += rpm_detect.phase_re[idx];
+    rpm_detect.dc_im[idx]  += rpm_detect.phase_im[idx];
+
+    re = rpm_detect.phase_re[idx] * rpm_detect.rot_re[idx] -
+      rpm_detect.phase_im[idx] * rpm_detect.rot_im[idx];
+    rpm_detect.phase_im[idx] =
+      rpm_detect.phase_re[idx] * rpm_detect.rot_im[idx] +
+      rpm_detect.phase_im[idx] * rpm_detect.rot_re[idx];
+    rpm_detect.phase_re[idx] = re;
+  }
+  if( ++rpm_detect.count % rpm_detect.step ) return( TRUE );
+
+  /* The rate found is told apart once measured over RPM_DETECT_CYCLES
+   * of its difference from the nearest standard rate, as the level
+   * of a neighbor's line rate falls off by then. Fast rates are
+   * decided early, before the short phasing of fast modes ends */
+  idx = Rpm_Detect_Level();
+  if( (idx >= 0) && (rpm_detect.count < rpm_detect.length) )
+  {
+    spacing = (double)bank_rpm[ NUM_RPM - 1 ];
+    if( idx > 0 )
+      spacing = (double)( bank_rpm[idx] - bank_rpm[idx - 1] );
+    if( (idx < NUM_RPM - 1) &&
+        (bank_rpm[idx + 1] - bank_rpm[idx] < spacing) )
+      spacing = (double)( bank_rpm[idx + 1] - bank_rpm[idx] );
+    if( spacing / 60.0 * (double)rpm_detect.count /
+        rpm_detect.pixel_rate < RPM_DETECT_CYCLES )
+      return( TRUE );
+  }
+  else if( rpm_detect.count < rpm_detect.length )
+    return( TRUE );
+  rpm_detect.active = FALSE;
+
+  if( idx >= 0 )
+  {
+    rc_data.lines_per_min = (double)bank_rpm[ idx ];
+    snprintf( mesg, sizeof(mesg), _("Detected %d RPM"), bank_rpm[idx] );
+    Show_Message( mesg, "green" );
+  }
+  else
+  {
+    snprintf( mesg, sizeof(mesg),
+        _("No RPM Detected, keeping %d RPM"),
+        (int)rc_data.lines_per_min );
+    Show_Message( mesg, "orange" );
+  }
+
+  /* Configure the decoder for the IOC and RPM found */
+  Configure();
+  if( isFlagClear(HEADLESS) ) Set_Menu_Items();
+
+  Show_Message( _("Synchronizing Phasing Pulses ..."), "black" );
+  Set_Indicators( ICON_SYNC_YES );
+  wefax_action = ACTION_PHASING;
+
+  return( TRUE );
+} /* Rpm_Detect() */
+
+/*------------------------------------------------------------------------*/
+
+/* Tone_Sample()
+ *
+ * Takes a signal sample for the decimated discriminator
+ */
+  static gboolean
+Tone_Sample( short *sample )
+{
+  /* Get new sample from Perseus DSP */
+  if( rc_data.tcvr_type == PERSEUS )
+  {
+#ifdef HAVE_LIBPERSEUS_SDR
+    Demodulate_SSB( sample );
+#endif
+    return( TRUE );
+  }
+
+  /* Get new sample from DSP buffer */
+  return( Sound_Signal_Sample(sample) );
+} /* Tone_Sample() */
+
+/*------------------------------------------------------------------------*/
+
+/* Tone_Discriminator()
+ *
+ * Zero crossing discriminator decimated to about rate, for the
+ * detection of tones whatever the pixel rate. It takes a signal
+ * sample and returns TRUE when a new output is in discr_op
+ */
+  static gboolean
+Tone_Discriminator(
+    tone_discr_t *discr, int rate,
+    short sample, unsigned char *discr_op )
+{
+  double frac, freq;
+
+  /* Set up for the DSP rate */
+  if( discr->dsp_rate != rc_data.dsp_rate )
+  {
+    bzero( discr, sizeof(tone_discr_t) );
+    discr->sub_len  = rc_data.dsp_rate / rate;
+    if( discr->sub_len < 1 ) discr->sub_len = 1;
+    discr->dsp_rate = rc_data.dsp_rate;
+  }
+
+  /* Interpolated zero crossings of sliding window average */
+  frac = discr->average;
+  discr->average = discr->average * SIG_AVE_DECAY +
+    (double)sample * SIG_AVE_GAIN;
+  if( (frac < 0.0) != (discr->average < 0.0) )
+  {
+    frac /= frac - discr->average;
+    discr->half_cycle = discr->since_zero + frac;
+    discr->since_zero = 1.0 - frac;
+    discr->zeros += 1.0;
+  }
+  else discr->since_zero += 1.0;
+
+  if( ++discr->sub_cnt < discr->sub_len ) return( FALSE );
+  discr->sub_cnt = 0;
+
+  /* Signal frequency from the half cycles since last output */
+  frac = 1.0;
+  if( discr->since_zero < discr->half_cycle )
+    frac = discr->since_zero / discr->half_cycle;
+  freq = ( discr->zeros + frac - discr->last_frac ) *
+    (double)rc_data.dsp_rate / (double)( 2 * discr->sub_len );
+  discr->last_frac = frac;
+  discr->zeros     = 0.0;
+
+  /* Scale and limit as the zero crossing detector */
+  freq = freq / DISCR_SCALE - DISCR_FLOOR;
+  if( freq > 255.0 ) freq = 255.0;
+  if( freq < 0.0 )   freq = 0.0;
+  *discr_op = (unsigned char)freq;
+
+  return( TRUE );
+} /* Tone_Discriminator() */
+
+/*------------------------------------------------------------------------*/
+
+/* State of the low power standby listener */
+static struct
+{
+  /* Ring buffer of the last samples, its length and input
+   * index, and the count of samples in it */
+  short *lookback;
+  int lookback_len, lookback_idx, lookback_cnt;
+
+  /* Index and count of samples left to replay to the decoder */
+  int replay_idx, replay_cnt;
+
+  /* Pixels left for the full decoder to detect the start tone */
+  int wake_cnt;
+
+  /* DSP rate the look-back buffer is set up for */
+  int dsp_rate;
+
+  /* Decimated discriminator */
+  tone_discr_t discr;
+
+  /* Detector per start tone */
+  tone_detector_t detector[ NUM_IOC ];
+
+} standby;
+
+/*------------------------------------------------------------------------*/
+
+/* Standby_Asleep()
+ *
+ * Returns TRUE while the start tone is to be listened
+ * for in low power standby, FALSE while the full decoder
+ * is awake after a start tone was heard in standby
+ */
+  static gboolean
+Standby_Asleep( void )
+{
+  if( standby.wake_cnt > 0 )
+  {
+    standby.wake_cnt--;
+    return( FALSE );
+  }
+
+  return( TRUE );
+} /* Standby_Asleep() */
+
+/*------------------------------------------------------------------------*/
+
+/* Standby_Wake()
+ *
+ * Wakes up the full decoder, with the look-back
+ * buffer queued for replay so no signal is lost
+ */
+  static void
+Standby_Wake( void )
+{
+  int idx;
+
+  standby.replay_cnt = standby.lookback_cnt;
+  standby.replay_idx = standby.lookback_idx - standby.lookback_cnt;
+  if( standby.replay_idx < 0 )
+    standby.replay_idx += standby.lookback_len;
+  standby.lookback_cnt = 0;
+
+  /* Counted in pixels, or in decimated outputs with automatic IOC */
+  if( isFlagSet(AUTO_IOC_RPM) )
+    standby.wake_cnt = (int)( STANDBY_WAKE_SECS * AUTO_TONE_RATE );
+  else
+    standby.wake_cnt = (int)( STANDBY_WAKE_SECS *
+        rc_data.lines_per_min / 60.0 * (double)rc_data.pixels_per_line );
+
+  /* Restart the detectors for the next standby */
+  for( idx = 0; idx < NUM_IOC; idx++ )
+    standby.detector[idx].period = 0.0;
+
+  ClearFlag( STANDBY_ASLEEP );
+  Show_Message( _("Start Tone heard, waking decoder"), "green" );
+
+} /* Standby_Wake() */
+
+/*------------------------------------------------------------------------*/
+
+/* Standby_Listen()
+ *
+ * Listens for the start tone in low power standby, over a
+ * block of signal samples at a time. The discriminator is
+ * only evaluated at about STANDBY_RATE, from the zero
+ * crossings of the signal, and the samples are kept in the
+ * look-back buffer for the full decoder when woken up
+ */
+  gboolean
+Standby_Listen( void )
+{
+  short sample;
+  int block, idx, tone, level, tone_level = 0;
+  double period;
+  unsigned char discr_op;
+
+
+  /* Set up for the DSP rate */
+  if( standby.dsp_rate != rc_data.dsp_rate )
+  {
+    standby.lookback_len =
+      (int)( STANDBY_LOOKBACK_SECS * (double)rc_data.dsp_rate );
+    if( !mem_realloc((void **)&standby.lookback,
+          sizeof(short) * (size_t)standby.lookback_len) )
+      return( FALSE );
+    standby.lookback_idx = standby.lookback_cnt = 0;
+    standby.dsp_rate = rc_data.dsp_rate;
+  }
+
+  /* Throttle the waterfall, and drop a stale replay */
+  if( isFlagClear(STANDBY_ASLEEP) )
+  {
+    SetFlag( STANDBY_ASLEEP );
+    Show_Message( _("Listening for Start Tone in Standby ..."), "black" );
+  }
+  standby.replay_cnt = 0;
+
+  block = (int)( STANDBY_BLOCK_SECS * (double)rc_data.dsp_rate );
+  for( idx = 0; idx < block; idx++ )
+  {
+    if( !Tone_Sample(&sample) ) return( FALSE );
+
+    /* Keep the sample for the full decoder */
+    standby.lookback[ standby.lookback_idx ] = sample;
+    if( ++standby.lookback_idx >= standby.lookback_len )
+      standby.lookback_idx = 0;
+    if( standby.lookback_cnt < standby.lookback_len )
+      standby.lookback_cnt++;
+
+    if( !Tone_Discriminator(&standby.discr,
+          STANDBY_RATE, sample, &discr_op) )
+      continue;
+
+    /* Run the start tone detectors, as in Start_Tone_Detect() */
+    for( tone = 0; tone < NUM_IOC; tone++ )
+    {
+      if( isFlagClear(AUTO_IOC_RPM) &&
+          (bank_tone[tone] != rc_data.start_tone) )
+        continue;
+      period = (double)rc_data.dsp_rate /
+        (double)( standby.discr.sub_len * bank_tone[tone] );
+      if( period < 2.0 ) continue;
+
+      level = 0;
+      Tone_Detect( &standby.detector[tone], period, discr_op, &level );
+      if( level > tone_level ) tone_level = level;
+    }
+
+    /* Stop on user request */
+    if( wefax_action == ACTION_STOP ) return( TRUE );
+
+  } /* for( idx = 0; idx < block; idx++ ) */
+
+  /* Display level gauge, once per block */
+  if( isFlagSet(DISPLAY_SIGNAL) && isFlagClear(HEADLESS) )
+  {
+    gauge_input  = tone_level / START_GAUGE_SCALE;
+    gauge_level1 = START_TONE_DOWN / START_GAUGE_SCALE;
+    gauge_level2 = START_TONE_UP   / START_GAUGE_SCALE;
+    gtk_widget_queue_draw( level_gauge );
+  }
+
+  /* Wake up the full decoder to detect the tone */
+  if( tone_level > START_TONE_UP )
+    Standby_Wake();
+
+  return( TRUE );
+} /* Standby_Listen() */
+
+/*------------------------------------------------------------------------*/
+
+/* Standby_Replay()
+ *
+ * Takes the next sample of the look-back buffer, if
+ * any is left to replay to the decoder after waking up
+ */
+  gboolean
+Standby_Replay( short *sample )
+{
+  if( !standby.replay_cnt ) return( FALSE );
+
+  *sample = standby.lookback[ standby.replay_idx ];
+  if( ++standby.replay_idx >= standby.lookback_len )
+    standby.replay_idx = 0;
+  standby.replay_cnt--;
+
+  return( TRUE );
+} /* Standby_Replay() */
+
+/*------------------------------------------------------------------------*/
+
+/* Standby_Reset()
+ *
+ * Ends the wake up of the full decoder, so it goes
+ * back to standby when next listening for a start tone
+ */
+  void
+Standby_Reset( void )
+{
+  standby.wake_cnt = 0;
+  ClearFlag( STANDBY_ASLEEP );
+} /* Standby_Reset() */
+
+/*------------------------------------------------------------------------*/
+
+/* State of the start tone detector */
+static struct
+{
+  /* Detector per start tone, and the strongest one */
+  tone_detector_t detector[ NUM_IOC ];
+  int tone_idx, tone_peak;
+
+  /* Decimated discriminator of automatic IOC detection */
+  tone_discr_t discr;
+
+  gboolean tone_up; /* Start tone level has risen */
+
+} start_tone;
+
+/*------------------------------------------------------------------------*/
+
 /* Start_Tone_Detect()
  *
- * Listens for and detects the Start tone
+ * Listens for and detects the Start tone. With automatic
+ * IOC and RPM, it listens for the start tones of all
+ * IOC values and then measures the RPM from the phasing
  */
   gboolean
 Start_Tone_Detect( void )
 {
   /* Detector output */
   unsigned char discr_op;
-  int tone_level = 0;
-  static gboolean tone_up = FALSE;
+  int tone_level = 0, level, idx;
+  double period;
+  char mesg[MESG_SIZE];
+  gboolean tone_down;
+  short sample;
 
 
-  /* Take signal samples from FM detector for the Start Tone detector */
-  if( !FM_Detector(&discr_op) ) return( FALSE );
-  Tone_Detect( rc_data.start_tone_period, discr_op, &tone_level );
+  /* Measure the RPM after an automatically detected start tone */
+  if( rpm_detect.active ) return( Rpm_Detect() );
+
+  /* Listen in low power standby until a start tone is heard */
+  if( isFlagSet(LOW_POWER_STANDBY) && isFlagClear(SKIP_ACTION) &&
+      !start_tone.tone_up && Standby_Asleep() )
+    return( Standby_Listen() );
+
+  /* Take signal samples from FM detector for the Start Tone detector,
+   * or from the decimated one for those of all IOC values, as the
+   * pixel rate may be too low for the highest tone */
+  if( isFlagSet(AUTO_IOC_RPM) )
+  {
+    do
+    {
+      if( !Tone_Sample(&sample) ) return( FALSE );
+    }
+    while( !Tone_Discriminator(&start_tone.discr,
+          AUTO_TONE_RATE, sample, &discr_op) );
+  }
+  else if( !FM_Detector(&discr_op) ) return( FALSE );
+
+  /* Run the detector of the configured start tone, or those of all */
+  for( idx = 0; idx < NUM_IOC; idx++ )
+  {
+    if( isFlagClear(AUTO_IOC_RPM) )
+    {
+      if( bank_tone[idx] != rc_data.start_tone ) continue;
+      period = rc_data.start_tone_period;
+    }
+    else
+    {
+      /* Tones above half the decimated rate are aliased, so left out */
+      period = (double)rc_data.dsp_rate /
+        (double)( start_tone.discr.sub_len * bank_tone[idx] );
+      if( period < 2.0 ) continue;
+    }
+
+    level = 0;
+    Tone_Detect( &start_tone.detector[idx], period, discr_op, &level );
+    if( level > tone_level )
+    {
+      tone_level = level;
+      if( !start_tone.tone_up ) start_tone.tone_idx = idx;
+    }
+  } /* for( idx = 0; idx < NUM_IOC; idx++ ) */
 
   /* Display detector output and level gauge */
   if( isFlagSet(DISPLAY_SIGNAL) )
@@ -637,27 +1850,55 @@ Start_Tone_Detect( void )
       rc_data.line_buffer_size - rc_data.pixels_per_line2;
 
     ClearFlag( SKIP_ACTION );
+    Standby_Reset();
     Show_Message( _("Skipping Start Tone Detection"), "orange" );
     Show_Message( _("Synchronizing Phasing Pulses ..."), "black" );
     Set_Indicators( ICON_START_SKIP );
     Set_Indicators( ICON_SYNC_YES );
     wefax_action = ACTION_PHASING;
-    tone_up = FALSE;
+    start_tone.tone_up   = FALSE;
+    start_tone.tone_peak = 0;
     return( TRUE );
   }
 
-  /* Record the rise of start tone level */
+  /* Record the rise of start tone level, and its peak */
   if( tone_level > START_TONE_UP )
-    tone_up = TRUE;
+    start_tone.tone_up = TRUE;
+  if( start_tone.tone_up && (tone_level > start_tone.tone_peak) )
+    start_tone.tone_peak = tone_level;
+
+  /* The RPM is measured on the phasing right after the start
+   * tone, so then its end is taken from the fall of its level */
+  if( isFlagSet(AUTO_IOC_RPM) )
+    tone_down = tone_level < start_tone.tone_peak / START_TONE_FALL;
+  else
+    tone_down = tone_level < START_TONE_DOWN;
 
   /* Go to searching for Phasing Pulses when tone goes down */
-  if( (tone_level < START_TONE_DOWN) && tone_up )
+  if( tone_down && start_tone.tone_up )
   {
     Show_Message( _("Start Tone Detected"), "green" );
-    Show_Message( _("Synchronizing Phasing Pulses ..."), "black" );
     Set_Indicators( ICON_START_APPLY );
+    start_tone.tone_up   = FALSE;
+    start_tone.tone_peak = 0;
+    Standby_Reset();
+
+    /* Take the IOC of the tone and measure the RPM */
+    if( isFlagSet(AUTO_IOC_RPM) )
+    {
+      rc_data.ioc_value  = bank_ioc[ start_tone.tone_idx ];
+      rc_data.start_tone = bank_tone[ start_tone.tone_idx ];
+      rc_data.start_tone_period = rc_data.lines_per_min / 60.0 *
+        (double)rc_data.pixels_per_line / (double)rc_data.start_tone;
+      snprintf( mesg, sizeof(mesg),
+          _("Detected IOC %d\nMeasuring RPM ..."), rc_data.ioc_value );
+      Show_Message( mesg, "green" );
+      Rpm_Detect_Init();
+      return( TRUE );
+    }
+
+    Show_Message( _("Synchronizing Phasing Pulses ..."), "black" );
     Set_Indicators( ICON_SYNC_YES );
-    tone_up = FALSE;
     wefax_action = ACTION_PHASING;
   }
 
@@ -666,6 +1907,16 @@ Start_Tone_Detect( void )
 
 /*------------------------------------------------------------------------*/
 
+/* State of the stop tone detector */
+static struct
+{
+  tone_detector_t detector;
+  gboolean tone_up; /* Stop tone level has risen */
+
+} stop_tone;
+
+/*------------------------------------------------------------------------*/
+
 /* Stop_Tone_Detect()
  *
  * Listens for and detects the Stop tone
@@ -675,11 +1926,11 @@ Stop_Tone_Detect( unsigned char discr_op )
 {
   /* Detector output */
   int tone_level = 0;
-  static gboolean tone_up = FALSE;
 
 
   /* Get the stop tone level */
-  Tone_Detect( rc_data.stop_tone_period, discr_op, &tone_level );
+  Tone_Detect( &stop_tone.detector,
+      rc_data.stop_tone_period, discr_op, &tone_level );
 
   /* Display detector output and level gauge */
   if( isFlagSet(DISPLAY_SIGNAL) )
@@ -692,13 +1943,13 @@ Stop_Tone_Detect( unsigned char discr_op )
 
   /* Record the rise of start tone level */
   if( tone_level > STOP_TONE_UP )
-    tone_up = TRUE;
+    stop_tone.tone_up = TRUE;
 
   /* Go to searching for Phasing Pulses when tone goes down */
-  if( (tone_level < STOP_TONE_DOWN) && tone_up )
+  if( (tone_level < STOP_TONE_DOWN) && stop_tone.tone_up )
   {
     Show_Message( _("Stop Tone Detected"), "green" );
-    tone_up = FALSE;
+    stop_tone.tone_up = FALSE;
     return( TRUE );
   }
 
@@ -707,3 +1958,46 @@ Stop_Tone_Detect( unsigned char discr_op )
 
 /*------------------------------------------------------------------------*/
 
+/* Detect_Reset()
+ *
+ * Resets the FM detectors, the start tone, phasing and
+ * stop tone detectors and the line buffer, so that a new
+ * decode does not depend on the signal decoded before it
+ */
+  void
+Detect_Reset( void )
+{
+  int idx;
+
+  bzero( &zero_cross, sizeof(zero_cross) );
+  bzero( &zero_fixed, sizeof(zero_fixed) );
+  bilevel.pixel_idx     = 0.0;
+  bilevel.residual      = 0;
+  bilevel.pixel_idx_q16 = 0;
+  bilevel.dsp_rate      = 0;
+
+  bzero( &start_tone, sizeof(start_tone) );
+  bzero( &stop_tone, sizeof(stop_tone) );
+  rpm_detect.active = FALSE;
+
+  /* Standby listener, with an empty look-back buffer */
+  for( idx = 0; idx < NUM_IOC; idx++ )
+    standby.detector[idx].period = 0.0;
+  standby.dsp_rate   = 0;
+  standby.replay_cnt = 0;
+  standby.discr.dsp_rate = 0;
+  Standby_Reset();
+
+  phasing.pixel_idx = 0;
+  phasing.count     = 0;
+  Phasing_Filter_Reset();
+
+  if( line_buffer != NULL )
+    bzero( line_buffer, (size_t)rc_data.line_buffer_size );
+  linebuff_input  = 0;
+  linebuff_output =
+    rc_data.line_buffer_size - rc_data.pixels_per_line2;
+
+} /* Detect_Reset() */
+
+/*------------------------------------------------------------------------*/
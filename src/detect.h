@@ -16,6 +16,7 @@
 #define DETECT_H    1
 
 #include "common.h"
+#include "utils.h"
 
 /* Multiplier and floor level to bring
  * detectors output to range 0 - 255 */
@@ -31,6 +32,10 @@
 #define STOP_TONE_UP        300000
 #define STOP_TONE_DOWN      100000
 
+/* With automatic IOC and RPM, the start tone ends when its
+ * level falls below its peak level divided by START_TONE_FALL */
+#define START_TONE_FALL     2
+
 /* Number of Start/Stop tone periods * 60 sec
  * used in the Goertzel detector */
 #define TONE_PERIOD_MULT        3600.0
@@ -38,9 +43,62 @@
 /* Length of Start/Stop tone averaging window */
 #define TONE_LEVEL_AVE_WIN      8
 
+/* With automatic IOC and RPM, the RPM is measured after the start
+ * tone from the line rate of the phasing signal, for RPM_DETECT_SECS
+ * at most, evaluated every RPM_DETECT_STEP secs. It is the lowest line
+ * rate whose level, in pixel values, is above RPM_DETECT_LEVEL and at
+ * least RPM_DETECT_RATIO of the highest, so that the harmonics of
+ * slower line rates are not taken for it. It is taken when measured
+ * over RPM_DETECT_CYCLES of its difference from the nearest rate */
+#define RPM_DETECT_SECS     6.0
+#define RPM_DETECT_STEP     0.25
+#define RPM_DETECT_LEVEL    8.0
+#define RPM_DETECT_RATIO    0.5
+#define RPM_DETECT_CYCLES   1.0
+
+/* In low power standby, the start tone is listened for in blocks of
+ * STANDBY_BLOCK_SECS, from a discriminator decimated to about
+ * STANDBY_RATE. The full decoder is woken up with the last
+ * STANDBY_LOOKBACK_SECS of signal, and goes back to standby
+ * if it does not detect the start tone in STANDBY_WAKE_SECS */
+#define STANDBY_BLOCK_SECS      0.1
+#define STANDBY_RATE            2400
+#define STANDBY_LOOKBACK_SECS   2.0
+#define STANDBY_WAKE_SECS       10.0
+
+/* With automatic IOC and RPM, the start tones are detected from a
+ * discriminator decimated to about AUTO_TONE_RATE, as in standby,
+ * so all of them are detected whatever the pixel rate */
+#define AUTO_TONE_RATE          2400
+
 /* Length of signal averaging window */
 #define SIG_AVE_WINDOW      20.0
 
+/* Weights of old average and new sample in the sliding window average */
+#define SIG_AVE_DECAY       ( (SIG_AVE_WINDOW - 1.0) / SIG_AVE_WINDOW )
+#define SIG_AVE_GAIN        ( 1.0 / SIG_AVE_WINDOW )
+
+/* Fixed point formats of the integer detectors: signal
+ * average Q3, zero crossing times Q12 samples, frequency
+ * Q4 Hz and pixel length Q16 samples, with the average's
+ * weight of new samples in Q15 */
+#define FIXED_AVE_SHIFT     3
+#define FIXED_TIME_SHIFT    12
+#define FIXED_TIME_ONE      ( 1 << FIXED_TIME_SHIFT )
+#define FIXED_FREQ_SHIFT    4
+#define FIXED_PIXEL_SHIFT   16
+#define FIXED_PIXEL_ONE     ( 1 << FIXED_PIXEL_SHIFT )
+#define SIG_AVE_GAIN_Q15    ( (int32_t)(Q15_ONE / SIG_AVE_WINDOW + 0.5) )
+
+/* Limit of the period between zero crossings, while there are none */
+#define FIXED_PERIOD_MAX    ( 1 << 30 )
+
+/* The phasing pulse is locked when the normalized correlation of
+ * the sum of the phasing lines with the pulse reaches PHASING_LOCK_NCC,
+ * over at least PHASING_MIN_LINES lines */
+#define PHASING_LOCK_NCC    0.8
+#define PHASING_MIN_LINES   2
+
 /* Scale factors for displaying signal level in the Gauge */
 #define SIG_GAUGE_SCALE     200
 #define SIG_GAUGE_LEVEL1    32
@@ -54,4 +112,59 @@
  * before the gauge display is refreshed */
 #define GAUGE_COUNT     256
 
+/* Standard modes with detector instances specialized for their
+ * pixel length: DSP rates x RPM x pixels per line (IOC 288/576).
+ * 12000 is a DSP rate resampled to from 48 and 96 kHz captures */
+#define DETECT_RPMS( M, rate, ppl ) \
+  M( rate, 60, ppl )  M( rate, 90, ppl )  M( rate, 100, ppl ) \
+  M( rate, 120, ppl ) M( rate, 180, ppl ) M( rate, 240, ppl )
+
+#define DETECT_PPLS( M, rate ) \
+  DETECT_RPMS( M, rate, 600 ) DETECT_RPMS( M, rate, 1200 )
+
+#define DETECT_MODES( M ) \
+  DETECT_PPLS( M, 8000 )  DETECT_PPLS( M, 11025 ) \
+  DETECT_PPLS( M, 12000 ) DETECT_PPLS( M, 48000 )
+
+/* State of a Goertzel detector of start or stop tone */
+typedef struct
+{
+  double
+    period,  /* Tone period in pixels */
+    coeff,   /* Goertzel coefficient 2cos(w) */
+    q1, q2;  /* Goertzel state */
+
+  /* As above in fixed point, 2cos(w) in Q14 and period squared in Q8 */
+  int32_t coeff_q14, fq1, fq2;
+  int64_t period_sq_q8;
+
+  int
+    level_ave,       /* Sliding window average of tone level */
+    input_cnt,       /* Count of pixel level inputs */
+    detector_period; /* Integration period of Goertzel detector */
+} tone_detector_t;
+
+/* State of a zero crossing discriminator decimated to a fixed rate */
+typedef struct
+{
+  /* DSP rate it is set up for, samples per
+   * discriminator output and their count */
+  int dsp_rate, sub_len, sub_cnt;
+
+  double
+    average,      /* Sliding window average of samples */
+    since_zero,   /* Samples since last zero crossing */
+    half_cycle,   /* Length of last half cycle in samples */
+    last_frac,    /* Fraction of half cycle at last output */
+    zeros;        /* Zero crossings since last output */
+} tone_discr_t;
+
+/* A standard mode and its specialized detector instances */
+typedef struct
+{
+  int dsp_rate, lines_per_min, pixels_per_line;
+  gboolean ( *zero_crossing )( unsigned char *signal_level );
+  gboolean ( *bilevel )( unsigned char *signal_level );
+} detect_mode_t;
+
 #endif
@@ -15,81 +15,421 @@
 #include "dft.h"
 #include "shared.h"
 
-/* Scaled-up, integer, sin/cos tables */
+/* Guards the spectrum settings and work buffers */
+static pthread_mutex_t spectrum_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Guards the waterfall rows queue */
+static pthread_mutex_t spectrum_data_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Posted to the worker thread when a new segment is ready */
+static sem_t spectrum_semaphore;
+
+/* Decimated input samples ring buffer */
+static float spectrum_ring[ SPECTRUM_RING_SIZE ];
+
+/* Counts of samples written to the ring, wrapping, at the end
+ * of the latest segment and at the end of the sample being
+ * written. Published by the producer, read by the worker */
+static atomic_uint segment_end, ring_end;
+
+/* Producer's state, reset on new spectrum settings */
+static unsigned int ring_input = 0; /* Count of samples written */
+static int
+  input_sum   = 0, /* Sum of samples being decimated */
+  input_cnt   = 0, /* Count of samples being decimated */
+  hop_cnt     = 0, /* Count of decimated samples in hop */
+  standby_cnt = 0, /* Count of hops skipped in standby */
+  spectrum_hop = 0; /* Samples between segment starts */
+
+/* Spectrum settings, applied by the worker when changed */
 static int
-  *isin = NULL,
-  *icos = NULL;
+  fft_size    = 0, /* Size of FFT, a power of 2 */
+  fft_width   = 0, /* Width of waterfall rows in pixels */
+  fft_average = 1; /* Number of segments averaged */
+static float fft_rate = 0.0f; /* Sample rate of FFT input */
+static gboolean fft_changed = FALSE;
+
+/* FFT work buffers and tables */
+static float
+  *fft_re  = NULL, /* Real part of FFT data */
+  *fft_im  = NULL, /* Imaginary part of FFT data */
+  *fft_cos = NULL, /* Cosine twiddle factors */
+  *fft_sin = NULL, /* Sine twiddle factors */
+  *fft_win = NULL; /* Window function values */
+static int *fft_rev = NULL; /* Bit reversed indices */
+
+/* Welch averaging of column powers */
+static float
+  *ave_hist = NULL, /* History of column powers per segment */
+  *ave_sum  = NULL; /* Sum of column powers over history */
+
+/* Range of FFT bins in each waterfall column */
+static int *col_bin = NULL;
+
+/* Waterfall rows waiting to be displayed */
+static guchar *spectrum_rows = NULL;
+static int
+  rows_width = 0,   /* Width of queued rows */
+  rows_count = 0;   /* Number of queued rows */
 
 /*------------------------------------------------------------------------*/
 
-/* Idft_Init()
+/* Spectrum_Row()
  *
- * Initializes Idft()
+ * Computes a waterfall row of pixel values from the Welch
+ * averaged power spectrum of the segment ending at seg_end.
+ * Returns FALSE if the producer overwrote the segment
  */
-  void
-Idft_Init( int dft_input_size, int dft_bin_size )
+  static gboolean
+Spectrum_Row( unsigned int seg_end, guchar *row )
 {
-  int i;
-  size_t mreq;
-  double w, dw;
-
-  /* Allocate dft buffers */
-  mreq = sizeof(int) * (size_t)dft_input_size;
-  if( !mem_alloc((void **)&dft_in_r, mreq) ) return;
-  if( !mem_alloc((void **)&isin, mreq) ) return;
-  if( !mem_alloc((void **)&icos, mreq) ) return;
-  memset( (void *)dft_in_r, 0, mreq );
-
-  mreq = sizeof(int) * (size_t)dft_bin_size;
-  if( !mem_alloc((void **)&dft_out_r, mreq) ) return;
-  if( !mem_alloc((void **)&dft_out_i, mreq) ) return;
-
-  /* Make sin/cos tables */
-  dw = M_2PI / (double)dft_input_size;
-  for( i = 0; i < dft_input_size; i++ )
+  /* Reference (top) level of display, dB */
+  static float ref_level = 0.0f;
+  static int ave_idx = 0, ave_cnt = 0;
+
+  float *hist, pwr, col_max, db, row_max;
+  unsigned int start, end;
+  int idx, bin;
+
+  PERF_BEGIN( PERF_SPECTRUM );
+
+  /* Reset averaging on new settings */
+  if( fft_changed )
+  {
+    ave_idx = ave_cnt = 0;
+    ref_level = 0.0f;
+    memset( ave_sum, 0, sizeof(float) * (size_t)fft_width );
+    fft_changed = FALSE;
+  }
+
+  /* Windowed copy of segment from ring buffer */
+  start = seg_end - (unsigned int)fft_size;
+  for( idx = 0; idx < fft_size; idx++ )
   {
-    w = dw * (double)i;
-    isin[i] = (int)(127.0 * sin(w) + 0.5);
-    icos[i] = (int)(127.0 * cos(w) + 0.5);
+    fft_re[idx] = fft_win[idx] *
+      spectrum_ring[ (start + (unsigned int)idx) & (SPECTRUM_RING_SIZE - 1) ];
+    fft_im[idx] = 0.0f;
   }
 
-} /* Idft_Init() */
+  /* As in Channel_Read(), the segment is good unless the
+   * producer wrote or was writing over its start meanwhile */
+  atomic_thread_fence( memory_order_acquire );
+  end = atomic_load_explicit( &ring_end, memory_order_relaxed );
+  if( end - start > SPECTRUM_RING_SIZE )
+  {
+    PERF_END( PERF_SPECTRUM );
+    return( FALSE );
+  }
+  DSP_Kernels->fft( fft_re, fft_im, fft_cos, fft_sin, fft_rev, fft_size );
+
+  /* Peak power of bins in each waterfall column */
+  hist = ave_hist + ave_idx * fft_width;
+  for( idx = 0; idx < fft_width; idx++ )
+  {
+    col_max = 0.0f;
+    for( bin = col_bin[idx]; bin < col_bin[idx + 1]; bin++ )
+    {
+      pwr = fft_re[bin] * fft_re[bin] + fft_im[bin] * fft_im[bin];
+      if( col_max < pwr ) col_max = pwr;
+    }
+
+    /* Sliding (Welch) average over segments */
+    if( ave_cnt >= fft_average ) ave_sum[idx] -= hist[idx];
+    ave_sum[idx] += col_max;
+    hist[idx] = col_max;
+  }
+  if( ave_cnt < fft_average ) ave_cnt++;
+  if( ++ave_idx >= fft_average ) ave_idx = 0;
+
+  /* Log (dB) scaling of averaged powers */
+  row_max = -1000.0f;
+  for( idx = 0; idx < fft_width; idx++ )
+  {
+    pwr = ave_sum[idx] / (float)ave_cnt;
+    if( pwr < SPECTRUM_MIN_POWER ) pwr = SPECTRUM_MIN_POWER;
+    db = 10.0f * log10f( pwr );
+    ave_hist[fft_average * fft_width + idx] = db;
+    if( row_max < db ) row_max = db;
+  }
+
+  /* Reference level follows peaks, falls slowly */
+  if( ref_level < row_max )
+    ref_level = row_max;
+  else
+    ref_level -= SPECTRUM_REF_DECAY;
+
+  /* Map dB values to the colorizer's 0-255 range */
+  for( idx = 0; idx < fft_width; idx++ )
+  {
+    db  = ave_hist[fft_average * fft_width + idx];
+    db  = 255.0f * ( db - ref_level + SPECTRUM_DB_RANGE ) / SPECTRUM_DB_RANGE;
+    if( db < 0.0f )   db = 0.0f;
+    if( db > 255.0f ) db = 255.0f;
+    row[idx] = (guchar)db;
+  }
+
+  PERF_END( PERF_SPECTRUM );
+
+  return( TRUE );
+} /* Spectrum_Row() */
 
 /*------------------------------------------------------------------------*/
 
-/* Idft()
+/* Spectrum_Idle_Cb()
  *
- * Simple, integer-only, DFT function
+ * Displays queued waterfall rows from the GUI thread
+ */
+  static gboolean
+Spectrum_Idle_Cb( gpointer data )
+{
+  int idx;
+
+  pthread_mutex_lock( &spectrum_data_lock );
+  if( rows_width == wfall_width )
+    for( idx = 0; idx < rows_count; idx++ )
+      Display_Waterfall( spectrum_rows + idx * rows_width );
+  rows_count = 0;
+  pthread_mutex_unlock( &spectrum_data_lock );
+
+  return( FALSE );
+} /* Spectrum_Idle_Cb() */
+
+/*------------------------------------------------------------------------*/
+
+/* Spectrum_Worker()
+ *
+ * Thread that computes waterfall rows from segments
+ * of decimated input, off the signal decoding path
+ */
+  static void *
+Spectrum_Worker( void *data )
+{
+  unsigned int seg_end;
+  int queued, row_len = 0;
+  guchar *row = NULL;
+
+  while( TRUE )
+  {
+    sem_wait( &spectrum_semaphore );
+
+    /* Skip stale segments if falling behind */
+    while( sem_trywait(&spectrum_semaphore) == 0 );
+
+    seg_end = atomic_load_explicit( &segment_end, memory_order_acquire );
+
+    pthread_mutex_lock( &spectrum_lock );
+    if( fft_size && fft_width )
+    {
+      if( row_len != fft_width )
+      {
+        free( row );
+        row = malloc( (size_t)fft_width );
+        row_len = ( row != NULL ) ? fft_width : 0;
+      }
+      if( (row != NULL) && Spectrum_Row(seg_end, row) )
+      {
+
+        /* Queue row for display, dropped if GUI lags */
+        pthread_mutex_lock( &spectrum_data_lock );
+        queued = rows_count;
+        if( (rows_width == fft_width) &&
+            (rows_count < SPECTRUM_ROWS_PENDING) )
+        {
+          memcpy( spectrum_rows + rows_count * rows_width,
+              row, (size_t)rows_width );
+          rows_count++;
+        }
+        pthread_mutex_unlock( &spectrum_data_lock );
+        if( !queued ) g_idle_add( Spectrum_Idle_Cb, NULL );
+      }
+    }
+    pthread_mutex_unlock( &spectrum_lock );
+
+  } /* while( TRUE ) */
+
+  return( NULL );
+} /* Spectrum_Worker() */
+
+/*------------------------------------------------------------------------*/
+
+/* Spectrum_Configure()
+ *
+ * Applies the spectrum settings in rc_data and the
+ * waterfall's width, starting the worker on first call
  */
   void
-Idft( int dft_input_size, int dft_bin_size )
+Spectrum_Configure( void )
 {
-  int i, j, w;
+  static gboolean first_call = TRUE;
+  static pthread_t pthread_id;
+
+  int idx, bin, nbins;
+  size_t mreq;
+  double w, f;
+
+
+  /* Wait for config and waterfall to be set up */
+  if( !rc_data.dsp_rate || !rc_data.fft_size || (wfall_width <= 0) )
+    return;
+
+  /* Start the spectrum worker thread */
+  if( first_call )
+  {
+    sem_init( &spectrum_semaphore, 0, 0 );
+    if( pthread_create(&pthread_id, NULL, Spectrum_Worker, NULL) != 0 )
+    {
+      Show_Message( _("Failed to create spectrum thread"), "red" );
+      Error_Dialog( _("Failed to create spectrum thread"), QUIT );
+      return;
+    }
+    pthread_detach( pthread_id );
+    first_call = FALSE;
+  }
+
+  pthread_mutex_lock( &spectrum_lock );
+
+  /* Decimate input to about the spectrum rate */
+  rc_data.dft_stride = rc_data.dsp_rate / SPECTRUM_RATE;
+  if( rc_data.dft_stride < 1 ) rc_data.dft_stride = 1;
+  fft_rate    = (float)rc_data.dsp_rate / (float)rc_data.dft_stride;
+  fft_size    = rc_data.fft_size;
+  fft_width   = wfall_width;
+  fft_average = rc_data.fft_average;
+  fft_changed = TRUE;
+
+  /* Allocate FFT buffers */
+  mreq = sizeof(float) * (size_t)fft_size;
+  if( !mem_realloc((void **)&fft_re,  mreq) ||
+      !mem_realloc((void **)&fft_im,  mreq) ||
+      !mem_realloc((void **)&fft_win, mreq) ||
+      !mem_realloc((void **)&fft_cos, mreq / 2) ||
+      !mem_realloc((void **)&fft_sin, mreq / 2) ||
+      !mem_realloc((void **)&fft_rev, sizeof(int) * (size_t)fft_size) )
+  {
+    fft_size = 0;
+    pthread_mutex_unlock( &spectrum_lock );
+    return;
+  }
+
+  /* Allocate averaging buffers, with a row for dB values */
+  mreq = sizeof(float) * (size_t)fft_width;
+  if( !mem_realloc((void **)&ave_hist,
+        mreq * (size_t)(fft_average + 1)) ||
+      !mem_realloc((void **)&ave_sum, mreq) ||
+      !mem_realloc((void **)&col_bin,
+        sizeof(int) * (size_t)(fft_width + 1)) )
+  {
+    fft_size = 0;
+    pthread_mutex_unlock( &spectrum_lock );
+    return;
+  }
 
-  /* In-phase and quadrature summation */
-  int sum_i, sum_q;
+  /* Twiddle factors and bit reversed indices */
+  FFT_Tables( fft_cos, fft_sin, fft_rev, fft_size );
 
-  /* Calculate output bins */
-  for( i = 0; i < dft_bin_size; i++ )
+  /* Window function */
+  for( idx = 0; idx < fft_size; idx++ )
   {
-    sum_i = sum_q = w = 0;
+    w = M_2PI * (double)idx / (double)fft_size;
+    switch( rc_data.fft_window )
+    {
+      case WINDOW_HANN:
+        fft_win[idx] = (float)( 0.5 - 0.5 * cos(w) );
+        break;
+
+      case WINDOW_BLACKMAN_HARRIS:
+        fft_win[idx] = (float)( 0.35875 - 0.48829 * cos(w) +
+            0.14128 * cos(2.0 * w) - 0.01168 * cos(3.0 * w) );
+        break;
+
+      default:
+        fft_win[idx] = 1.0f;
+    }
+  }
 
-    /* Summate input values */
-    for( j = 0; j < dft_input_size; j++ )
+  /* Range of FFT bins in each waterfall column */
+  nbins = fft_size / 2;
+  for( idx = 0; idx <= fft_width; idx++ )
+  {
+    f  = (double)( DFT_UPPER_FREQ - DFT_LOWER_FREQ ) * (double)idx;
+    f /= (double)fft_width;
+    f += (double)DFT_LOWER_FREQ;
+    bin = (int)( f * (double)fft_size / (double)fft_rate + 0.5 );
+    if( bin > nbins ) bin = nbins;
+    col_bin[idx] = bin;
+  }
+  for( idx = 0; idx < fft_width; idx++ )
+    if( col_bin[idx + 1] <= col_bin[idx] )
     {
-      sum_i += dft_in_r[j] * isin[w];
-      sum_q += dft_in_r[j] * icos[w];
-      w += i + dft_bin_size; /* Makes the freq range max/min 2:1 */
-      if( w >= dft_input_size ) w -= dft_input_size;
+      /* Columns narrower than a bin repeat the bin */
+      if( col_bin[idx] >= nbins ) col_bin[idx] = nbins - 1;
+      col_bin[idx + 1] = col_bin[idx] + 1;
     }
 
-    /* Normalized summations to bins */
-    dft_out_r[i] = sum_i/dft_input_size;
-    dft_out_i[i] = sum_q/dft_input_size;
+  /* Restart waterfall rows queue */
+  pthread_mutex_lock( &spectrum_data_lock );
+  if( mem_realloc((void **)&spectrum_rows,
+        (size_t)(fft_width * SPECTRUM_ROWS_PENDING)) )
+    rows_width = fft_width;
+  else
+    rows_width = 0;
+  rows_count = 0;
+  pthread_mutex_unlock( &spectrum_data_lock );
+
+  /* Restart the producer, which runs in this (GUI) thread */
+  spectrum_hop = ( fft_size * (100 - rc_data.fft_overlap) ) / 100;
+  if( spectrum_hop < 1 ) spectrum_hop = 1;
+  memset( spectrum_ring, 0, sizeof(spectrum_ring) );
+  ring_input = 0;
+  input_sum = input_cnt = hop_cnt = standby_cnt = 0;
+  atomic_store_explicit( &ring_end, 0, memory_order_relaxed );
+  atomic_store_explicit( &segment_end, 0, memory_order_relaxed );
 
-  } /* for( i = 0; i < k; i++ ) */
+  pthread_mutex_unlock( &spectrum_lock );
+
+} /* Spectrum_Configure() */
+
+/*------------------------------------------------------------------------*/
+
+/* DFT_Input_Data()
+ *
+ * Collects and decimates signal samples for the spectrum
+ * and hands over a segment to the worker every hop
+ */
+  void
+DFT_Input_Data( short sample_val )
+{
+  if( !spectrum_hop ) return;
+
+  /* Summate (decimate) samples for the FFT */
+  input_sum += sample_val;
+  if( ++input_cnt < rc_data.dft_stride ) return;
+
+  /* Publish the end of the sample before writing it, so that
+   * the worker copying the slot it overwrites sees it */
+  atomic_store_explicit( &ring_end, ring_input + 1, memory_order_relaxed );
+  atomic_thread_fence( memory_order_release );
+  spectrum_ring[ ring_input & (SPECTRUM_RING_SIZE - 1) ] =
+    (float)input_sum / (float)input_cnt;
+  ring_input++;
+  input_sum = input_cnt = 0;
+
+  /* Signal worker when a new segment is complete,
+   * less often while listening in low power standby */
+  if( ++hop_cnt >= spectrum_hop )
+  {
+    if( isFlagSet(STANDBY_ASLEEP) && (++standby_cnt < STANDBY_WFALL_DIVIDE) )
+    {
+      hop_cnt = 0;
+      return;
+    }
+    standby_cnt = 0;
+    hop_cnt = 0;
+    atomic_store_explicit( &segment_end, ring_input, memory_order_release );
+    sem_post( &spectrum_semaphore );
+  }
 
-} /* Idft() */
+} /* DFT_Input_Data() */
 
 /*------------------------------------------------------------------------*/
 
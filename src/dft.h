@@ -15,7 +15,31 @@
 #ifndef DFT_H
 #define DFT_H   1
 
+#include <stdatomic.h>
 #include "common.h"
 
+/* Approximate sample rate of decimated spectrum input */
+#define SPECTRUM_RATE        8000
+
+/* Size of spectrum input ring buffer, must be a power of 2 */
+#define SPECTRUM_RING_SIZE  16384
+
+/* Maximum FFT size and number of averaged (Welch) segments */
+#define SPECTRUM_MAX_FFT     4096
+#define SPECTRUM_MAX_AVE       16
+
+/* Segments per waterfall row in low power standby */
+#define STANDBY_WFALL_DIVIDE    8
+
+/* Waterfall rows that may wait for the GUI to display them */
+#define SPECTRUM_ROWS_PENDING   8
+
+/* Displayed dynamic range and fall rate per row of reference, dB */
+#define SPECTRUM_DB_RANGE    60.0f
+#define SPECTRUM_REF_DECAY    0.2f
+
+/* Floor to avoid log of 0 in dB conversion */
+#define SPECTRUM_MIN_POWER   1.0E-12f
+
 #endif
 
@@ -17,48 +17,6 @@
 
 /*------------------------------------------------------------------------*/
 
-/* DFT_Bin_Value()
- *
- * Calcultes output bin values of the DFT
- */
-  static int
-DFT_Bin_Value( int sum_i, int sum_q, gboolean reset )
-{
- /* Value of dft output "bin" */
-  static int bin_val = 0;
-
-  /* Maximum value of dft bins */
-  static int bin_max = 1000, max = 0;
-
-
-  /* Calculate sliding window average of max bin value */
-  if( reset )
-  {
-    bin_max = max;
-    if( !bin_max ) bin_max = 1;
-    max = 0;
-  }
-  else
-  {
-    /* Calculate average signal power at each frequency (bin) */
-    bin_val  = bin_val * AMPL_AVE_MUL;
-    bin_val += sum_i * sum_i + sum_q * sum_q;
-    bin_val /= AMPL_AVE_WIN;
-
-    /* Record max bin value */
-    if( max < bin_val ) max = bin_val;
-
-    /* Scale bin values to 255 depending on max value */
-    int ret = ( 255 * bin_val ) / bin_max;
-    if( ret > 255 ) ret = 255;
-    return( ret );
-  }
-
-  return( 0 );
-} /* DFT_Bin_Value() */
-
-/*------------------------------------------------------------------------*/
-
 /* Colorize()
  *
  * Pseudo-colorizes FFT Spectrum Display pixels
@@ -103,15 +61,14 @@ Colorize( guchar *pix, int pixel_val )
 
 /* Display_Waterfall()
  *
- * Displays audio spectrum as "waterfall"
+ * Displays a row of the audio spectrum as "waterfall"
  */
-  static void
-Display_Waterfall( void )
+  void
+Display_Waterfall( const guchar *row )
 {
   int
     idh, idv,  /* Index to hor. and vert. position in warterfall */
-    pixel_val, /* Greyscale value of pixel derived from dft o/p  */
-    dft_idx,   /* Index to dft output array */
+    dft_idx,   /* Index to spectrum row */
     temp;
 
   /* Constants needed to draw white lines in waterfall */
@@ -172,27 +129,17 @@ Display_Waterfall( void )
   /* Got to top left of pixbuf */
   pix = wfall_pixels;
 
-  /* Do the DFT on input array */
-  Idft( DFT_INPUT_SIZE, wfall_width );
+  /* Enter the dB scaled spectrum row */
   for( dft_idx = 0; dft_idx < wfall_width; dft_idx++ )
   {
-    /* Calculate power of signal at each freq. ("bin") */
-    dft_out_r[dft_idx] /= 1024;
-    dft_out_i[dft_idx] /= 1024;
-    pixel_val = DFT_Bin_Value(
-        dft_out_r[dft_idx], dft_out_i[dft_idx], FALSE );
-
-    /* Calculate average bin values */
-    bin_ave[dft_idx] = pixel_val;
+    /* Keep bin values for click tuning */
+    bin_ave[dft_idx] = row[dft_idx];
 
     /* Color code signal strength */
-    Colorize( pix, pixel_val );
+    Colorize( pix, row[dft_idx] );
     pix += wfall_n_channels;
 
-  } /* for( dft_idx = 0; dft_idx < DFT_SIZE2; dft_idx++ ) */
-
-  /* Reset function */
-  DFT_Bin_Value( 0, 0, TRUE );
+  } /* for( dft_idx = 0; dft_idx < wfall_width; dft_idx++ ) */
 
   /* At last draw waterfall */
   gtk_widget_queue_draw( spectrum_drawingarea );
@@ -201,67 +148,53 @@ Display_Waterfall( void )
 
 /*------------------------------------------------------------------------*/
 
-/* DFT_Input_Data()
- *
- * Collects and decimates signal samples for the DFT
- */
-  void
-DFT_Input_Data( short sample_val )
-{
-  static int dft_idx = 0; /* dft input buffer idx */
-  static double cnt  = 0.0; /* Count of calls to this function */
-
-  /* Summate (decimate) samples for the DFT */
-  dft_in_r[dft_idx] += sample_val;
-
-  /* Reset stride (decimation) counter */
-  cnt += 1.0;
-  if( cnt >= rc_data.dft_stride )
-  {
-    cnt -= rc_data.dft_stride;
-
-    /* Normalize DFT input samples */
-    dft_in_r[dft_idx] /= (int)rc_data.dft_stride;
-    dft_idx++;
-
-    /* Display waterfall when input buffer full */
-    if( dft_idx >= DFT_INPUT_SIZE )
-    {
-      Display_Waterfall();
-      dft_idx = 0;
-    }
-
-    /* Clear for next summation */
-    dft_in_r[dft_idx] = 0;
-  }
-
-} /* DFT_Input_Data() */
-
-/*------------------------------------------------------------------------*/
-
 /*  Display_Signal()
  *
- *  Updates the signal scope display
+ *  Accumulates the detector's output into per-column
+ *  min/max/mean envelopes of the signal scope, so that
+ *  each scope frame shows all samples of one image line
  */
 
-/* Points to plot */
-static GdkPoint *points = NULL;
+/* Envelope edges of the scope columns, as plot y coordinates */
+static gint
+  *scope_env  = NULL, /* Buffer holding the three edge arrays */
+  *scope_top  = NULL, /* Plot of maximum value in columns */
+  *scope_bot  = NULL, /* Plot of minimum value in columns */
+  *scope_mean = NULL; /* Plot of average value in columns */
+static gint scope_cols_len = 0;
 
   void
 Display_Signal( unsigned char plot )
 {
   static int
-    height = 0,     /* Height of scope window */
-    limit,          /* Limit plotting to inside of scope margin */
-    points_idx = 0; /* Index to points array */
+    height  = 0,   /* Height of scope window */
+    limit   = 0,   /* Limit plotting to inside of scope margin */
+    col_idx = 0,   /* Index to current scope column */
+    col_cnt = 0,   /* Count of samples in current column */
+    col_min = 255, /* Minimum of samples in current column */
+    col_max = 0,   /* Maximum of samples in current column */
+    col_sum = 0,   /* Sum of samples in current column */
+    smp_idx = 0;   /* Index of sample in scope frame */
 
+  int end_col, val;
 
-  /* Initialize on first call */
-  if( points == NULL )
+
+  if( isFlagSet(HEADLESS) ) return;
+
+  /* (Re)initialize on first call or on scope resize */
+  if( scope_cols_len != scope_width )
   {
-    if( !mem_alloc((void **)&points,
-          sizeof(GdkPoint) * (size_t)scope_width) )
+    if( scope_width <= 0 ) return;
+    if( !mem_realloc((void **)&scope_env,
+          3 * sizeof(gint) * (size_t)scope_width) )
       return;
+    scope_cols_len = scope_width;
+    scope_top  = scope_env;
+    scope_bot  = scope_env + scope_cols_len;
+    scope_mean = scope_env + 2 * scope_cols_len;
+    col_idx = col_cnt = col_sum = smp_idx = 0;
+    col_min = 255;
+    col_max = 0;
   }
 
   /* Initialize on parameter change */
@@ -271,33 +204,87 @@ Display_Signal( unsigned char plot )
     limit = height - SCOPE_CLEAR;
   }
 
-  /* Save values to be plotted */
-  plot = (unsigned char)( ((int)plot * limit ) / 255 );
-  points[points_idx].y = limit - (gint)plot;
-  if( points[points_idx].y < SCOPE_CLEAR )
-    points[points_idx].y = SCOPE_CLEAR;
-  points[points_idx].x = points_idx;
+  /* Accumulate the envelope of current column */
+  val = (int)plot;
+  if( col_min > val ) col_min = val;
+  if( col_max < val ) col_max = val;
+  col_sum += val;
+  col_cnt++;
+
+  /* Columns completed by this sample, one frame per image line */
+  smp_idx++;
+  end_col = ( smp_idx * scope_cols_len ) / rc_data.pixels_per_line;
+  if( end_col > scope_cols_len ) end_col = scope_cols_len;
+  if( end_col <= col_idx ) return;
+
+  /* Convert envelope to plot y coordinates, once per column */
+  while( col_idx < end_col )
+  {
+    scope_top[col_idx]  = limit - ( col_max * limit ) / 255;
+    scope_bot[col_idx]  = limit - ( col_min * limit ) / 255;
+    scope_mean[col_idx] = limit - ( (col_sum / col_cnt) * limit ) / 255;
+    if( scope_top[col_idx]  < SCOPE_CLEAR ) scope_top[col_idx]  = SCOPE_CLEAR;
+    if( scope_bot[col_idx]  < SCOPE_CLEAR ) scope_bot[col_idx]  = SCOPE_CLEAR;
+    if( scope_mean[col_idx] < SCOPE_CLEAR ) scope_mean[col_idx] = SCOPE_CLEAR;
+
+    /* Keep flat envelopes visible as a one pixel band */
+    if( scope_bot[col_idx] <= scope_top[col_idx] )
+      scope_bot[col_idx] = scope_top[col_idx] + 1;
+    col_idx++;
+  }
+
+  /* Clear for next column */
+  col_cnt = col_sum = 0;
+  col_min = 255;
+  col_max = 0;
 
-  /* Recycle buffer idx when full and plot */
-  if( ++points_idx >= scope_width )
+  /* Recycle columns when frame full and plot */
+  if( col_idx >= scope_cols_len )
   {
     SetFlag( ENABLE_SCOPE );
     gtk_widget_queue_draw( scope_drawingarea );
-    points_idx = 0;
-  } /* if( ++points_idx == wfall_pixbuf.width ) */
+    col_idx = smp_idx = 0;
+  }
 
 } /* Display_Signal( void ) */
 
 /*------------------------------------------------------------------------*/
 
+/* Scope_Path()
+ *
+ * Adds to the cairo path the vertices of one edge of the
+ * scope envelope, skipping those inside a horizontal run
+ */
+  static void
+Scope_Path( cairo_t *cr, const gint *edge, int from, int to )
+{
+  int idx, step;
+
+  step = ( to >= from ) ? 1 : -1;
+  for( idx = from; idx != to + step; idx += step )
+  {
+    /* Only plot the ends of horizontal runs */
+    if( (idx != from) && (idx != to) &&
+        (edge[idx] == edge[idx - step]) &&
+        (edge[idx] == edge[idx + step]) )
+      continue;
+
+    cairo_line_to( cr, (double)idx, (double)edge[idx] );
+  }
+
+} /* Scope_Path() */
+
+/*------------------------------------------------------------------------*/
+
 /* Draw_Signal()
  *
- * Draws the signal detector's output
+ * Draws the signal detector's output envelope as a single
+ * filled polygon, with the mean value traced over it
  */
   void
 Draw_Signal( cairo_t *cr )
 {
-  int idx;
+  int last;
 
   /* Draw scope backgrounds */
   cairo_set_source_rgb( cr, SCOPE_BACKGND );
@@ -307,18 +294,26 @@ Draw_Signal( cairo_t *cr )
       (double)scope_height );
   cairo_fill( cr );
 
-  /* Plot signal graph */
-  cairo_set_source_rgb( cr, SCOPE_FOREGND );
+  /* Scope may have been resized since last frame */
+  last = MIN( scope_cols_len, scope_width ) - 1;
+  if( (scope_env == NULL) || (last < 1) )
+  {
+    ClearFlag( ENABLE_SCOPE );
+    return;
+  }
 
-  cairo_move_to( cr,
-      (double)points[0].x,
-      (double)points[0].y );
-  for( idx = 1; idx < scope_width; idx++ )
-    cairo_line_to( cr,
-        (double)points[idx].x,
-        (double)points[idx].y );
+  /* Fill the min/max envelope, top edge forward, bottom backward */
+  cairo_set_source_rgb( cr, SCOPE_ENVELOPE );
+  cairo_new_path( cr );
+  Scope_Path( cr, scope_top, 0, last );
+  Scope_Path( cr, scope_bot, last, 0 );
+  cairo_close_path( cr );
+  cairo_fill( cr );
 
-  /* Stroke paths */
+  /* Trace the mean value of columns */
+  cairo_set_source_rgb( cr, SCOPE_FOREGND );
+  cairo_new_path( cr );
+  Scope_Path( cr, scope_mean, 0, last );
   cairo_stroke( cr );
 
   ClearFlag( ENABLE_SCOPE );
@@ -346,6 +341,8 @@ Set_Indicators( int flag )
   GtkWidget *icon = NULL;
   gchar     *name = NULL;
 
+  if( isFlagSet(HEADLESS) ) return;
+
   /* Get the control widgets table */
   if( first_call )
   {
@@ -463,7 +460,18 @@ Set_Menu_Items( void )
   int pix[ NUM_PIX ] = { PIX600, PIX1200 };
   int ioc[ NUM_IOC ] = { IOC288, IOC576 };
   int phl[ NUM_PHL ] = { PHL10, PHL20, PHL40, PHL60 };
-  int ime[ NUM_IME ] = { IME0, IME1, IME2 };
+  int ime[ NUM_IME ] = { IME0, IME1, IME2, IME3 };
+  int fft[ NUM_FFT ] = { FFT512, FFT1024, FFT2048, FFT4096 };
+  int ovl[ NUM_OVL ] = { OVL0, OVL50, OVL75 };
+  int ave[ NUM_AVE ] = { AVE1, AVE2, AVE4, AVE8, AVE16 };
+
+  /* Spectrum settings to set, since activating one of their
+   * items enters those of the other items into rc_data */
+  int
+    fft_size    = rc_data.fft_size,
+    fft_window  = rc_data.fft_window,
+    fft_overlap = rc_data.fft_overlap,
+    fft_average = rc_data.fft_average;
 
   char name[8];
   int idx;
@@ -528,6 +536,49 @@ Set_Menu_Items( void )
   item = GTK_CHECK_MENU_ITEM( Builder_Get_Object(popup_menu_builder, name) );
   gtk_check_menu_item_set_active( item, TRUE );
 
+  /* Find current spectrum FFT size */
+  for( idx = 0; idx < NUM_FFT; idx++ )
+    if( fft[ idx ] == fft_size )
+      break;
+  if( idx == NUM_FFT ) return;
+
+  /* Set active spectrum FFT size menu item */
+  snprintf( name, sizeof(name), "fft%d", fft[idx] );
+  name[7] = '\0';
+  item = GTK_CHECK_MENU_ITEM( Builder_Get_Object(popup_menu_builder, name) );
+  gtk_check_menu_item_set_active( item, TRUE );
+
+  /* Set active spectrum window menu item */
+  if( (fft_window < 0) || (fft_window >= NUM_WIN) ) return;
+  snprintf( name, sizeof(name), "win%d", fft_window );
+  name[7] = '\0';
+  item = GTK_CHECK_MENU_ITEM( Builder_Get_Object(popup_menu_builder, name) );
+  gtk_check_menu_item_set_active( item, TRUE );
+
+  /* Find current spectrum FFT overlap */
+  for( idx = 0; idx < NUM_OVL; idx++ )
+    if( ovl[ idx ] == fft_overlap )
+      break;
+  if( idx == NUM_OVL ) return;
+
+  /* Set active spectrum FFT overlap menu item */
+  snprintf( name, sizeof(name), "ovl%d", ovl[idx] );
+  name[7] = '\0';
+  item = GTK_CHECK_MENU_ITEM( Builder_Get_Object(popup_menu_builder, name) );
+  gtk_check_menu_item_set_active( item, TRUE );
+
+  /* Find current spectrum averaging */
+  for( idx = 0; idx < NUM_AVE; idx++ )
+    if( ave[ idx ] == fft_average )
+      break;
+  if( idx == NUM_AVE ) return;
+
+  /* Set active spectrum averaging menu item */
+  snprintf( name, sizeof(name), "ave%d", ave[idx] );
+  name[7] = '\0';
+  item = GTK_CHECK_MENU_ITEM( Builder_Get_Object(popup_menu_builder, name) );
+  gtk_check_menu_item_set_active( item, TRUE );
+
 } /* Set_Menu_Items() */
 
 /*------------------------------------------------------------------------*/
@@ -540,7 +591,7 @@ Set_Menu_Items( void )
 Normalize( unsigned char *line_buf, int line_len )
 {
   int
-    hist[256],  /* Intensity histogram of pgm image file  */
+    hist[256],  /* Intensity histogram */
     blk_cutoff, /* Count of pixels for black cutoff value */
     wht_cutoff, /* Count of pixels for white cutoff value */
     pixel_val,  /* Used for calculating normalized pixels */
@@ -552,6 +603,9 @@ Normalize( unsigned char *line_buf, int line_len )
     white_val,  /* White cut-off pixel intensity value */
     val_range;  /* Range of intensity values in image  */
 
+  /* Remap table of normalized pixel values */
+  unsigned char lut[256];
+
   if( line_len <= 0 )
   {
     Show_Message( _("Image line length zero\n"\
@@ -559,12 +613,10 @@ Normalize( unsigned char *line_buf, int line_len )
     return;
   }
 
-  /* Clear histogram */
-  bzero( (void *)hist, sizeof(hist) );
+  PERF_BEGIN( PERF_NORMALIZE );
 
   /* Build image intensity histogram */
-  for( idx = 0; idx < line_len; idx++ )
-    hist[ line_buf[idx] ] += 1;
+  DSP_Kernels->histogram( line_buf, line_len, hist );
 
   /* Determine black/white cut-off counts */
   blk_cutoff = (line_len * BLACK_CUT_OFF) / 100;
@@ -590,17 +642,21 @@ Normalize( unsigned char *line_buf, int line_len )
   val_range = white_val - black_val;
   if( val_range <= 0 ) return;
 
-  /* Perform histogram normalization on images */
-  for( pixel_cnt = 0; pixel_cnt < line_len; pixel_cnt++ )
+  /* Build the remap table, one divide per intensity value */
+  for( idx = 0; idx < 256; idx++ )
   {
-    pixel_val = line_buf[ pixel_cnt ];
-    pixel_val = ( (pixel_val - black_val) * 255 ) / val_range;
+    pixel_val = ( (idx - black_val) * 255 ) / val_range;
 
     pixel_val = ( pixel_val < 0 ? 0 : pixel_val );
     pixel_val = ( pixel_val > 255 ? 255 : pixel_val );
-    line_buf[ pixel_cnt ] = (unsigned char)pixel_val;
+    lut[ idx ] = (unsigned char)pixel_val;
   }
 
+  /* Perform histogram normalization on images */
+  DSP_Kernels->remap( line_buf, lut, line_len );
+
+  PERF_END( PERF_NORMALIZE );
+
 } /* End of Normalize() */
 
 /*------------------------------------------------------------------------*/
@@ -633,21 +689,15 @@ Spectrum_Size_Allocate( int width, int height )
   wfall_n_channels = gdk_pixbuf_get_n_channels( wfall_pixbuf );
   gdk_pixbuf_fill( wfall_pixbuf, 0 );
 
-  /* Calculate dft stride to put upper freq at end of DFT
-   * display and allow a freq range max/min ratio of 2:1 */
-  idx = DFT_INPUT_SIZE / wfall_width / DFT_FREQ_MULTP;
-  rc_data.dft_stride =
-    (double)rc_data.dsp_rate / (double)DFT_UPPER_FREQ / (double)idx;
-
   /* Allocate average bin value buffer */
   if( !mem_realloc((void **)&bin_ave,
         (size_t)wfall_width * sizeof(int)) )
     return;
 
-  /* Initialize dft and config */
+  /* Initialize bin values and spectrum engine */
   for( idx = 0; idx < wfall_width; idx++ )
     bin_ave[idx] = 0;
-  Idft_Init( DFT_INPUT_SIZE, wfall_width );
+  Spectrum_Configure();
 
 } /* Spectrum_Size_Allocate() */
 
@@ -668,7 +718,20 @@ Set_Sync_Slant( double sync_slant )
 
   /* Pixels/1000 lines sync slant correction */
   rc_data.sync_slant = sync_slant / 1000.0;
+  Set_Pixel_Len();
+
+} /* Set_Sync_Slant() */
+
+/*------------------------------------------------------------------------*/
 
+/* Set_Pixel_Len()
+ *
+ * Sets the length of an image pixel in DSP samples
+ * from the line rate, resolution and sync slant
+ */
+  void
+Set_Pixel_Len( void )
+{
   /* Length (duration) of an image pixel in DSP samples */
   double temp = rc_data.lines_per_min / 60.0; /* lines/sec */
   if( temp != 0.0 )
@@ -682,7 +745,7 @@ Set_Sync_Slant( double sync_slant )
   if( temp != 0.0 )
     rc_data.pixel_len = rc_data.pixel_len / temp;
 
-} /* Set_Sync_Slant() */
+} /* Set_Pixel_Len() */
 
 /*------------------------------------------------------------------------*/
 
@@ -39,10 +39,7 @@
 
 /* Colors for the signal scope */
 #define SCOPE_FOREGND       0.0, 1.0, 0.0
-
-/* Length and multiplier of amplitude averaging window  */
-#define AMPL_AVE_WIN        2
-#define AMPL_AVE_MUL        1
+#define SCOPE_ENVELOPE      0.0, 0.6, 0.0
 
 #endif
 
@@ -0,0 +1,331 @@
+/*
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License as
+ *  published by the Free Software Foundation; either version 2 of
+ *  the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details:
+ *
+ *  http://www.gnu.org/copyleft/gpl.txt
+ */
+
+#include "enhance.h"
+#include "shared.h"
+
+/* Guards the queues and generation counter */
+static pthread_mutex_t enhance_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Signals new work to the worker and its idling to the decoder */
+static pthread_cond_t
+  work_cond = PTHREAD_COND_INITIALIZER,
+  idle_cond = PTHREAD_COND_INITIALIZER;
+
+/* Lines waiting for enhancement and enhanced lines */
+static enhance_line_t
+  in_queue[ ENHANCE_QUEUE_LEN ],
+  out_queue[ ENHANCE_QUEUE_LEN ];
+
+static int
+  in_head  = 0, in_count  = 0, /* Input queue ring indices */
+  out_head = 0, out_count = 0, /* Output queue ring indices */
+  generation = 0;   /* Incremented on each new image */
+
+static gboolean worker_busy = FALSE;
+
+/*------------------------------------------------------------------------*/
+
+/* CLAHE_Line()
+ *
+ * Contrast-limited adaptive histogram equalization of a line,
+ * over a rolling window of the last CLAHE_WINDOW_LINES lines.
+ * The tile histograms are kept as running sums, adding the new
+ * line and removing the one leaving the window, so that the cost
+ * per line is O(width) plus a fixed cost per tile
+ */
+  static void
+CLAHE_Line( enhance_line_t *line, gboolean reset )
+{
+  /* Rolling window of recent lines */
+  static unsigned char window[ CLAHE_WINDOW_LINES ][ ENHANCE_MAX_WIDTH ];
+  static int win_idx = 0, win_count = 0, width = 0;
+
+  /* Running histograms of tiles and their remap tables */
+  static int hist[ CLAHE_TILES ][ 256 ];
+  static unsigned char lut[ CLAHE_TILES ][ 256 ];
+
+  /* Tile of each pixel and interpolation to the next tile */
+  static int tile_of[ ENHANCE_MAX_WIDTH ], weight[ ENHANCE_MAX_WIDTH ];
+  static int tile_len;
+
+  unsigned char *old, *pix;
+  int idx, tile, val, total, clip, excess, cdf, start, len;
+
+  /* Enhance after the phasing pulse only */
+  start = PHASING_PULSE_LEN;
+  len   = line->width - start;
+  if( len < CLAHE_TILES ) return;
+  pix = line->pixels + start;
+
+  PERF_BEGIN( PERF_ENHANCE );
+
+  /* Restart window on new image or line width */
+  if( reset || (width != len) )
+  {
+    width = len;
+    win_idx = win_count = 0;
+    bzero( (void *)hist, sizeof(hist) );
+
+    /* Pixel to tile map, and weights of linear
+     * interpolation between adjacent tile centers */
+    tile_len = width / CLAHE_TILES;
+    for( idx = 0; idx < width; idx++ )
+    {
+      val = ( (2 * idx + 1 - tile_len) * CLAHE_WEIGHT_ONE ) / ( 2 * tile_len );
+      if( val < 0 ) val = 0;
+      tile = val / CLAHE_WEIGHT_ONE;
+      if( tile >= CLAHE_TILES - 1 )
+      {
+        tile = CLAHE_TILES - 2;
+        val  = ( CLAHE_TILES - 1 ) * CLAHE_WEIGHT_ONE;
+      }
+      tile_of[idx] = tile;
+      weight[idx]  = val - tile * CLAHE_WEIGHT_ONE;
+    }
+  }
+
+  /* Remove line leaving the window from tile histograms */
+  if( win_count == CLAHE_WINDOW_LINES )
+  {
+    old = window[ win_idx ];
+    for( idx = 0; idx < width; idx++ )
+    {
+      tile = idx / tile_len;
+      if( tile >= CLAHE_TILES ) tile = CLAHE_TILES - 1;
+      hist[tile][ old[idx] ]--;
+    }
+  }
+  else win_count++;
+
+  /* Add the new line to window and tile histograms */
+  memcpy( window[win_idx], pix, (size_t)width );
+  if( ++win_idx >= CLAHE_WINDOW_LINES ) win_idx = 0;
+  for( idx = 0; idx < width; idx++ )
+  {
+    tile = idx / tile_len;
+    if( tile >= CLAHE_TILES ) tile = CLAHE_TILES - 1;
+    hist[tile][ pix[idx] ]++;
+  }
+
+  /* Clipped cumulative histogram remap table of each tile */
+  for( tile = 0; tile < CLAHE_TILES; tile++ )
+  {
+    total = 0;
+    for( val = 0; val < 256; val++ )
+      total += hist[tile][val];
+    if( !total ) continue;
+
+    /* Clip histogram, redistributing the excess evenly */
+    clip = ( CLAHE_CLIP_LIMIT * total ) / 256;
+    if( clip < 1 ) clip = 1;
+    excess = 0;
+    for( val = 0; val < 256; val++ )
+      if( hist[tile][val] > clip )
+        excess += hist[tile][val] - clip;
+
+    cdf = 0;
+    for( val = 0; val < 256; val++ )
+    {
+      cdf += ( hist[tile][val] > clip ? clip : hist[tile][val] );
+      lut[tile][val] = (unsigned char)
+        ( ((cdf + (excess * (val + 1)) / 256) * 255) / total );
+    }
+  } /* for( tile = 0; tile < CLAHE_TILES; tile++ ) */
+
+  /* Remap pixels, interpolating between adjacent tiles */
+  for( idx = 0; idx < width; idx++ )
+  {
+    tile = tile_of[idx];
+    val  = pix[idx];
+    pix[idx] = (unsigned char)(
+        ( lut[tile][val] * (CLAHE_WEIGHT_ONE - weight[idx]) +
+          lut[tile + 1][val] * weight[idx] ) / CLAHE_WEIGHT_ONE );
+  }
+
+  PERF_END( PERF_ENHANCE );
+
+} /* CLAHE_Line() */
+
+/*------------------------------------------------------------------------*/
+
+/* Enhance_Worker()
+ *
+ * Thread that enhances queued image lines,
+ * so that the decoder never waits on it
+ */
+  static void *
+Enhance_Worker( void *data )
+{
+  static enhance_line_t line;
+  int gen = -1, idx;
+
+  pthread_mutex_lock( &enhance_lock );
+  while( TRUE )
+  {
+    /* Wait for lines to enhance */
+    while( !in_count )
+    {
+      worker_busy = FALSE;
+      pthread_cond_broadcast( &idle_cond );
+      pthread_cond_wait( &work_cond, &enhance_lock );
+    }
+    worker_busy = TRUE;
+
+    /* Take a line from input queue */
+    line = in_queue[ in_head ];
+    in_head = ( in_head + 1 ) % ENHANCE_QUEUE_LEN;
+    in_count--;
+    pthread_mutex_unlock( &enhance_lock );
+
+    CLAHE_Line( &line, line.generation != gen );
+    gen = line.generation;
+
+    /* Hand over enhanced line, unless
+     * the decoder has moved to a new image */
+    pthread_mutex_lock( &enhance_lock );
+    if( (line.generation == generation) &&
+        (out_count < ENHANCE_QUEUE_LEN) )
+    {
+      idx = ( out_head + out_count ) % ENHANCE_QUEUE_LEN;
+      out_queue[ idx ] = line;
+      out_count++;
+    }
+  } /* while( TRUE ) */
+
+  return( NULL );
+} /* Enhance_Worker() */
+
+/*------------------------------------------------------------------------*/
+
+/* Enhance_Put_Line()
+ *
+ * Queues an image line for adaptive enhancement. Returns FALSE
+ * if it cannot be queued, so the queue should be flushed and
+ * drained and the line queued again, or else used as is
+ */
+  gboolean
+Enhance_Put_Line( const unsigned char *pixels, int width, int line_idx )
+{
+  static gboolean first_call = TRUE;
+  static pthread_t pthread_id;
+  int idx;
+
+  if( (width <= 0) || (width > ENHANCE_MAX_WIDTH) ) return( FALSE );
+
+  /* Start the worker thread */
+  if( first_call )
+  {
+    if( pthread_create(&pthread_id, NULL, Enhance_Worker, NULL) != 0 )
+    {
+      Show_Message( _("Failed to create enhancement thread"), "red" );
+      return( FALSE );
+    }
+    pthread_detach( pthread_id );
+    first_call = FALSE;
+  }
+
+  pthread_mutex_lock( &enhance_lock );
+
+  /* Never wait for the worker, return the line if full */
+  if( in_count + out_count + worker_busy >= ENHANCE_QUEUE_LEN )
+  {
+    pthread_mutex_unlock( &enhance_lock );
+    return( FALSE );
+  }
+
+  idx = ( in_head + in_count ) % ENHANCE_QUEUE_LEN;
+  memcpy( in_queue[idx].pixels, pixels, (size_t)width );
+  in_queue[idx].width      = width;
+  in_queue[idx].line_idx   = line_idx;
+  in_queue[idx].generation = generation;
+  in_count++;
+  worker_busy = TRUE;
+  pthread_cond_signal( &work_cond );
+
+  pthread_mutex_unlock( &enhance_lock );
+
+  return( TRUE );
+} /* Enhance_Put_Line() */
+
+/*------------------------------------------------------------------------*/
+
+/* Enhance_Get_Line()
+ *
+ * Copies an enhanced line, if available, into its row
+ * in the image buffer without waiting for the worker
+ */
+  gboolean
+Enhance_Get_Line( unsigned char *image, int width, int *line_idx )
+{
+  gboolean ret = FALSE;
+
+  pthread_mutex_lock( &enhance_lock );
+  while( out_count )
+  {
+    enhance_line_t *line = &out_queue[ out_head ];
+
+    out_head = ( out_head + 1 ) % ENHANCE_QUEUE_LEN;
+    out_count--;
+
+    /* Drop lines of a previous image */
+    if( (line->generation != generation) || (line->width != width) )
+      continue;
+
+    memcpy( &image[line->line_idx * width], line->pixels, (size_t)width );
+    *line_idx = line->line_idx;
+    ret = TRUE;
+    break;
+  }
+  pthread_mutex_unlock( &enhance_lock );
+
+  return( ret );
+} /* Enhance_Get_Line() */
+
+/*------------------------------------------------------------------------*/
+
+/* Enhance_Flush()
+ *
+ * Waits for the worker to enhance all queued lines, at
+ * the end of an image before saving it or on a full queue
+ */
+  void
+Enhance_Flush( void )
+{
+  pthread_mutex_lock( &enhance_lock );
+  while( in_count || worker_busy )
+    pthread_cond_wait( &idle_cond, &enhance_lock );
+  pthread_mutex_unlock( &enhance_lock );
+
+} /* Enhance_Flush() */
+
+/*------------------------------------------------------------------------*/
+
+/* Enhance_Reset()
+ *
+ * Discards queued lines and restarts the rolling window
+ */
+  void
+Enhance_Reset( void )
+{
+  pthread_mutex_lock( &enhance_lock );
+  generation++;
+  in_count  = 0;
+  out_count = 0;
+  pthread_mutex_unlock( &enhance_lock );
+
+} /* Enhance_Reset() */
+
+/*------------------------------------------------------------------------*/
+
@@ -0,0 +1,49 @@
+/*
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License as
+ *  published by the Free Software Foundation; either version 2 of
+ *  the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details:
+ *
+ *  http://www.gnu.org/copyleft/gpl.txt
+ */
+
+#ifndef ENHANCE_H
+#define ENHANCE_H   1
+
+#include "common.h"
+
+/* Maximum length of image lines (pixels per line) */
+#define ENHANCE_MAX_WIDTH   1200
+
+/* Lines queued to and from the enhancement worker */
+#define ENHANCE_QUEUE_LEN   64
+
+/* Number of recent lines in the rolling CLAHE window */
+#define CLAHE_WINDOW_LINES  64
+
+/* Number of tiles across an image line */
+#define CLAHE_TILES         8
+
+/* Histogram clip limit, as a multiple of the average bin count */
+#define CLAHE_CLIP_LIMIT    3
+
+/* Fixed point scale of tile interpolation weights */
+#define CLAHE_WEIGHT_ONE    256
+
+/* A line in the enhancement queues */
+typedef struct
+{
+  unsigned char pixels[ ENHANCE_MAX_WIDTH ];
+  int
+    width,      /* Length of line in pixels */
+    line_idx,   /* Index of line in image */
+    generation; /* Image the line belongs to */
+} enhance_line_t;
+
+#endif
+
@@ -17,6 +17,95 @@
 
 /*----------------------------------------------------------------------*/
 
+/* Chebyshev_Transform()
+ *
+ * Calculates the S-domain to Z-domain conversion constant t and
+ * the Low Pass to Low Pass or High Pass transform constant k
+ */
+  static void
+Chebyshev_Transform( filter_data_t *filter_data, double *t, double *k )
+{
+  double w;
+
+  /* S-domain to Z-domain conversion */
+  *t = 2.0 * tan( 0.5 );
+
+  /* Cutoff frequency */
+  if( filter_data->cutoff >= 0.49 )
+    filter_data->cutoff = 0.49;
+  w = M_2PI * filter_data->cutoff;
+
+  /* Low Pass to Low Pass or Low Pass to High Pass transform */
+  if( filter_data->type == FILTER_HIGHPASS )
+    *k = -cos( (w + 1.0) / 2.0 ) / cos( (w - 1.0) / 2.0 );
+  else if( filter_data->type == FILTER_LOWPASS )
+    *k = sin( (1.0 - w) / 2.0 ) / sin( (1.0 + w) / 2.0 );
+  else *k = 1.0; // For compiler warnings */
+
+} /* Chebyshev_Transform() */
+
+/*----------------------------------------------------------------------*/
+
+/* Chebyshev_Section()
+ *
+ * Calculates the coefficients of the 2-pole section of
+ * pole pair p, for Chebyshev recursive filters. t and k
+ * are the S to Z domain and Low Pass transform constants
+ */
+  static void
+Chebyshev_Section(
+    const filter_data_t *filter_data, int p, double t, double k,
+    double *a0, double *a1, double *a2, double *b1, double *b2 )
+{
+  double rp, ip, es, vx, kx, m;
+  double d, xn0, xn1, xn2, yn1, yn2, tmp;
+
+  /* Calculate the pole location on the unit circle */
+  tmp = M_PI / (double)filter_data->npoles / 2.0 +
+    (double)(p - 1) * M_PI / (double)filter_data->npoles;
+  rp  = -cos( tmp );
+  ip  =  sin( tmp );
+
+  /* Wrap from a circle to an ellipse */
+  if( filter_data->ripple > 0.0 )
+  {
+    tmp = 100.0 / ( 100.0 - filter_data->ripple );
+    es  = sqrt( tmp * tmp - 1.0 );
+    tmp = 1.0 / (double)filter_data->npoles;
+    vx  = tmp * asinh( 1.0 / es );
+    kx  = tmp * acosh( 1.0 / es );
+    kx  = cosh( kx );
+    rp *= sinh( vx ) / kx;
+    ip *= cosh( vx ) / kx;
+  }
+
+  /* S-domain to Z-domain conversion */
+  m = rp * rp + ip * ip;
+  d = 4.0 - 4.0 * rp * t + m * t * t;
+  xn0 = t * t / d;
+  xn1 = 2.0 * t * t / d;
+  xn2 = t * t / d;
+  yn1 = ( 8.0 - 2.0 * m * t * t ) / d;
+  yn2 = ( -4.0 -4.0 * rp * t - m * t * t ) / d;
+
+  /* Low Pass to Low Pass or Low Pass to High Pass transform */
+  d  = 1.0 + yn1 * k -yn2 * k * k;
+  *a0 = ( xn0 - xn1 * k + xn2 * k * k ) / d;
+  *a1 = ( -2.0 * xn0 * k + xn1 + xn1 * k * k - 2.0 * xn2 * k ) / d;
+  *a2 = ( xn0 * k * k - xn1 * k + xn2 ) / d;
+  *b1 = ( 2.0 * k + yn1 + yn1 * k * k - 2.0 * yn2 * k ) / d;
+  *b2 = ( -k * k - yn1 * k + yn2 ) / d;
+
+  if( filter_data->type == FILTER_HIGHPASS )
+  {
+    *a1 = -*a1;
+    *b1 = -*b1;
+  }
+
+} /* Chebyshev_Section() */
+
+/*----------------------------------------------------------------------*/
+
 /* Init_Chebyshev_Filter()
  *
  * Calculates Chebyshev recursive filter coefficients.
@@ -28,8 +117,7 @@ Init_Chebyshev_Filter( filter_data_t *filter_data )
   double *ta = NULL, *tb = NULL;
   double a0, a1, a2, b1, b2, sa, sb, gain;
   int i, p;
-  double rp, ip, es, vx, kx, t, w, m;
-  double d, xn0, xn1, xn2, yn1, yn2, k, tmp;
+  double t, k;
 
 
   if( !filter_data->npoles ) return;
@@ -68,65 +156,14 @@ Init_Chebyshev_Filter( filter_data_t *filter_data )
   filter_data->a[2] = 1.0;
   filter_data->b[2] = 1.0;
 
-  /* S-domain to Z-domain conversion */
-  t = 2.0 * tan( 0.5 );
-
-  /* Cutoff frequency */
-  if( filter_data->cutoff >= 0.49 )
-    filter_data->cutoff = 0.49;
-  w = M_2PI * filter_data->cutoff;
-
-  /* Low Pass to Low Pass or Low Pass to High Pass transform */
-  if( filter_data->type == FILTER_HIGHPASS )
-    k = -cos( (w + 1.0) / 2.0 ) / cos( (w - 1.0) / 2.0 );
-  else if( filter_data->type == FILTER_LOWPASS )
-    k = sin( (1.0 - w) / 2.0 ) / sin( (1.0 + w) / 2.0 );
-  else k = 1.0; // For compiler warnings */
+  /* S-domain to Z-domain and Low Pass transform constants */
+  Chebyshev_Transform( filter_data, &t, &k );
 
   /* Find coefficients for 2-pole filter for each pole pair */
   for( p = 1; p <= filter_data->npoles / 2; p++ )
   {
-    /* Calculate the pole location on the unit circle */
-    tmp = M_PI / (double)filter_data->npoles / 2.0 +
-      (double)(p - 1) * M_PI / (double)filter_data->npoles;
-    rp  = -cos( tmp );
-    ip  =  sin( tmp );
-
-    /* Wrap from a circle to an ellipse */
-    if( filter_data->ripple > 0.0 )
-    {
-      tmp = 100.0 / ( 100.0 - filter_data->ripple );
-      es  = sqrt( tmp * tmp - 1.0 );
-      tmp = 1.0 / (double)filter_data->npoles;
-      vx  = tmp * asinh( 1.0 / es );
-      kx  = tmp * acosh( 1.0 / es );
-      kx  = cosh( kx );
-      rp *= sinh( vx ) / kx;
-      ip *= cosh( vx ) / kx;
-    }
-
-    /* S-domain to Z-domain conversion */
-    m = rp * rp + ip * ip;
-    d = 4.0 - 4.0 * rp * t + m * t * t;
-    xn0 = t * t / d;
-    xn1 = 2.0 * t * t / d;
-    xn2 = t * t / d;
-    yn1 = ( 8.0 - 2.0 * m * t * t ) / d;
-    yn2 = ( -4.0 -4.0 * rp * t - m * t * t ) / d;
-
-    /* Low Pass to Low Pass or Low Pass to High Pass transform */
-    d  = 1.0 + yn1 * k -yn2 * k * k;
-    a0 = ( xn0 - xn1 * k + xn2 * k * k ) / d;
-    a1 = ( -2.0 * xn0 * k + xn1 + xn1 * k * k - 2.0 * xn2 * k ) / d;
-    a2 = ( xn0 * k * k - xn1 * k + xn2 ) / d;
-    b1 = ( 2.0 * k + yn1 + yn1 * k * k - 2.0 * yn2 * k ) / d;
-    b2 = ( -k * k - yn1 * k + yn2 ) / d;
-
-    if( filter_data->type == FILTER_HIGHPASS )
-    {
-      a1 = -a1;
-      b1 = -b1;
-    }
+    /* Coefficients of the pole pair's section */
+    Chebyshev_Section( filter_data, p, t, k, &a0, &a1, &a2, &b1, &b2 );
 
     /* Add coefficients to the cascade */
     for( i = 0; i <= filter_data->npoles + 2; i++ )
@@ -191,49 +228,108 @@ Init_Chebyshev_Filter( filter_data_t *filter_data )
   void
 DSP_Filter( filter_data_t *filter_data )
 {
-  /* Index to samples buffer */
-  int buf_idx, idx, npp1, len;
-  double y, yn0;
-
-  /* Filter samples in the buffer */
-  npp1 = filter_data->npoles + 1;
-  len  = filter_data->samples_buf_len;
-  for( buf_idx = 0; buf_idx < len; buf_idx++ )
+  PERF_BEGIN( PERF_DSP_FILTER );
+  DSP_Kernels->iir_filter( filter_data );
+  PERF_END( PERF_DSP_FILTER );
+} /* DSP_Filter() */
+
+/*----------------------------------------------------------------------*/
+
+/* Init_Chebyshev_Fixed()
+ *
+ * Designs a Chebyshev recursive filter as Init_Chebyshev_Filter()
+ * but as a cascade of fixed point second order sections, each
+ * normalized to unity gain, as a direct form filter of many
+ * poles is unstable with quantized coefficients
+ */
+  void
+Init_Chebyshev_Fixed(
+    filter_data_t *filter_data, filter_fixed_t *filter_fixed )
+{
+  filter_section_t *sect;
+  double a0, a1, a2, b1, b2, t, k, gain;
+  int p;
+
+
+  filter_fixed->nsections = filter_data->npoles / 2;
+  if( !filter_fixed->nsections ) return;
+
+  /* Allocate sections, clearing saved values */
+  size_t mreq = (size_t)filter_fixed->nsections * sizeof(filter_section_t);
+  free_ptr( (void **)&(filter_fixed->sections) );
+  mem_alloc( (void **)&(filter_fixed->sections), mreq );
+  bzero( filter_fixed->sections, mreq );
+
+  /* S-domain to Z-domain and Low Pass transform constants */
+  Chebyshev_Transform( filter_data, &t, &k );
+
+  for( p = 1; p <= filter_fixed->nsections; p++ )
   {
-    /* Calculate and save filtered samples */
-    yn0 = filter_data->samples_buf[buf_idx] * filter_data->a[0];
-    for( idx = 1; idx < npp1; idx++ )
-    {
-      /* Summate contribution of past input samples */
-      y    = filter_data->a[idx];
-      y   *= filter_data->x[filter_data->ring_idx];
-      yn0 += y;
+    Chebyshev_Section( filter_data, p, t, k, &a0, &a1, &a2, &b1, &b2 );
 
-      /* Summate contribution of past output samples */
-      y   = filter_data->b[idx];
-      y  *= filter_data->y[filter_data->ring_idx];
-      yn0 += y;
+    /* Gain of the section at DC or at Nyquist for High Pass */
+    if( filter_data->type == FILTER_HIGHPASS )
+      gain = ( a0 - a1 + a2 ) / ( 1.0 + b1 - b2 );
+    else
+      gain = ( a0 + a1 + a2 ) / ( 1.0 - b1 - b2 );
+
+    sect = &filter_fixed->sections[p - 1];
+    sect->a0 = TO_FIXED( a0 / gain, Q29_SHIFT );
+    sect->a1 = TO_FIXED( a1 / gain, Q29_SHIFT );
+    sect->a2 = TO_FIXED( a2 / gain, Q29_SHIFT );
+    sect->b1 = TO_FIXED( b1, Q29_SHIFT );
+    sect->b2 = TO_FIXED( b2, Q29_SHIFT );
+  }
 
-      /* Advance ring buffers index */
-      filter_data->ring_idx++;
-      if( filter_data->ring_idx >= npp1 )
-        filter_data->ring_idx = 0;
+} /* Init_Chebyshev_Fixed() */
 
-    } /* for( idx = 0; idx < npp1; idx++ ) */
+/*----------------------------------------------------------------------*/
 
-    /* Save new yn0 output to y ring buffer */
-    filter_data->y[filter_data->ring_idx] = yn0;
+/* DSP_Filter_Fixed()
+ *
+ * Fixed point DSP Recursive Filter, normally used as low pass
+ */
+  void
+DSP_Filter_Fixed( filter_fixed_t *filter_fixed )
+{
+  filter_section_t *sect;
+  int64_t acc;
+  int32_t x;
+  int buf_idx, idx;
 
-    /* Save current input sample to x ring buffer */
-    filter_data->x[filter_data->ring_idx] =
-      filter_data->samples_buf[buf_idx];
+  PERF_BEGIN( PERF_DSP_FILTER );
+  for( buf_idx = 0; buf_idx < filter_fixed->samples_buf_len; buf_idx++ )
+  {
+    /* Filter the sample through the cascade of sections */
+    x = filter_fixed->samples_buf[buf_idx];
+    for( idx = 0; idx < filter_fixed->nsections; idx++ )
+    {
+      sect = &filter_fixed->sections[idx];
+      acc  = (int64_t)sect->a0 * x;
+      acc += (int64_t)sect->a1 * sect->x1;
+      acc += (int64_t)sect->a2 * sect->x2;
+      acc += (int64_t)sect->b1 * sect->y1;
+      acc += (int64_t)sect->b2 * sect->y2;
+
+      /* Round and saturate to sample units */
+      acc = ( acc + (1L << (Q29_SHIFT - 1)) ) >> Q29_SHIFT;
+      if( acc > INT32_MAX ) acc = INT32_MAX;
+      if( acc < INT32_MIN ) acc = INT32_MIN;
+
+      sect->x2 = sect->x1;
+      sect->x1 = x;
+      sect->y2 = sect->y1;
+      sect->y1 = (int32_t)acc;
+      x = (int32_t)acc;
+    }
 
     /* Return filtered samples */
-    filter_data->samples_buf[buf_idx] = yn0;
+    filter_fixed->samples_buf[buf_idx] = x;
 
   } /* for( buf_idx = 0; buf_idx < len; buf_idx++ ) */
+  PERF_END( PERF_DSP_FILTER );
 
-} /* DSP_Filter() */
+} /* DSP_Filter_Fixed() */
 
 /*----------------------------------------------------------------------*/
 
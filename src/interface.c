@@ -124,3 +124,12 @@ create_stations_window( GtkBuilder **builder )
   return( window );
 }
 
+  GtkWidget *
+create_perf_window( GtkBuilder **builder )
+{
+  gchar *object_ids[] = { PERF_WINDOW_IDS };
+  Gtk_Builder( builder, object_ids );
+  GtkWidget *window = Builder_Get_Object( *builder, "perf_window" );
+  return( window );
+}
+
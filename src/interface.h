@@ -59,11 +59,45 @@ NULL
 "ime0", \
 "ime1", \
 "ime2", \
+"ime3", \
+"image_zoom", \
+"image_zoom_menu", \
+"zoom1", \
+"zoom2", \
+"zoom4", \
+"zoom8", \
+"zoomfit", \
 "item1_menu", \
 "jpeg", \
 "pgm", \
 "both", \
+"spectrum", \
+"spectrum_menu", \
+"fft_size", \
+"fft_size_menu", \
+"fft512", \
+"fft1024", \
+"fft2048", \
+"fft4096", \
+"fft_window", \
+"fft_window_menu", \
+"win0", \
+"win1", \
+"win2", \
+"fft_overlap", \
+"fft_overlap_menu", \
+"ovl0", \
+"ovl50", \
+"ovl75", \
+"fft_average", \
+"fft_average_menu", \
+"ave1", \
+"ave2", \
+"ave4", \
+"ave8", \
+"ave16", \
 "capture_setup", \
+"performance", \
 "quit", \
 NULL
 
@@ -106,5 +140,11 @@ NULL
 "save_button", \
 NULL
 
+#define PERF_WINDOW_IDS \
+"perf_window", \
+"perf_textview", \
+"perf_reset_button", \
+NULL
+
 #endif
 
@@ -22,6 +22,7 @@
  */
 
 #include "jpeg.h"
+#include "shared.h"
 
   static jpec_buffer_t
 *jpec_buffer_new2(int siz)
@@ -593,53 +594,19 @@ jpec_enc_block_dct(jpec_enc_t *e)
 #define JPEC_BLOCK(col,row) \
   e->img[(((e->by + row) < e->h) ? e->by + row : e->h-1) * \
   e->w + (((e->bx + col) < e->w) ? e->bx + col : e->w-1)]
-  const float* coeff = jpec_dct;
-  float tmp[64];
+  float block[64];
 
+  /* NOTE: the shift by 128 allows resampling from [0 255] to [-128 127] */
   for(int row = 0; row < 8; row++)
   {
-    /* NOTE: the shift by 256 allows resampling from [0 255] to [–128 127] */
-    float s0 = (float) (JPEC_BLOCK(0, row) + JPEC_BLOCK(7, row) - 256);
-    float s1 = (float) (JPEC_BLOCK(1, row) + JPEC_BLOCK(6, row) - 256);
-    float s2 = (float) (JPEC_BLOCK(2, row) + JPEC_BLOCK(5, row) - 256);
-    float s3 = (float) (JPEC_BLOCK(3, row) + JPEC_BLOCK(4, row) - 256);
-
-    float d0 = (float) (JPEC_BLOCK(0, row) - JPEC_BLOCK(7, row));
-    float d1 = (float) (JPEC_BLOCK(1, row) - JPEC_BLOCK(6, row));
-    float d2 = (float) (JPEC_BLOCK(2, row) - JPEC_BLOCK(5, row));
-    float d3 = (float) (JPEC_BLOCK(3, row) - JPEC_BLOCK(4, row));
-
-    tmp[8 * row]     = coeff[3]*(s0+s1+s2+s3);
-    tmp[8 * row + 1] = coeff[0]*d0+coeff[2]*d1+coeff[4]*d2+coeff[6]*d3;
-    tmp[8 * row + 2] = coeff[1]*(s0-s3)+coeff[5]*(s1-s2);
-    tmp[8 * row + 3] = coeff[2]*d0-coeff[6]*d1-coeff[0]*d2-coeff[4]*d3;
-    tmp[8 * row + 4] = coeff[3]*(s0-s1-s2+s3);
-    tmp[8 * row + 5] = coeff[4]*d0-coeff[0]*d1+coeff[6]*d2+coeff[2]*d3;
-    tmp[8 * row + 6] = coeff[5]*(s0-s3)+coeff[1]*(s2-s1);
-    tmp[8 * row + 7] = coeff[6]*d0-coeff[4]*d1+coeff[2]*d2-coeff[0]*d3;
+    for(int col = 0; col < 8; col++)
+    {
+      block[8 * row + col] = (float) (JPEC_BLOCK(col, row) - 128);
+    }
   }
 
-  for(int col = 0; col < 8; col++)
-  {
-    float s0 = tmp[     col] + tmp[56 + col];
-    float s1 = tmp[ 8 + col] + tmp[48 + col];
-    float s2 = tmp[16 + col] + tmp[40 + col];
-    float s3 = tmp[24 + col] + tmp[32 + col];
-
-    float d0 = tmp[     col] - tmp[56 + col];
-    float d1 = tmp[ 8 + col] - tmp[48 + col];
-    float d2 = tmp[16 + col] - tmp[40 + col];
-    float d3 = tmp[24 + col] - tmp[32 + col];
-
-    e->block.dct[     col] = coeff[3]*(s0+s1+s2+s3);
-    e->block.dct[ 8 + col] = coeff[0]*d0+coeff[2]*d1+coeff[4]*d2+coeff[6]*d3;
-    e->block.dct[16 + col] = coeff[1]*(s0-s3)+coeff[5]*(s1-s2);
-    e->block.dct[24 + col] = coeff[2]*d0-coeff[6]*d1-coeff[0]*d2-coeff[4]*d3;
-    e->block.dct[32 + col] = coeff[3]*(s0-s1-s2+s3);
-    e->block.dct[40 + col] = coeff[4]*d0-coeff[0]*d1+coeff[6]*d2+coeff[2]*d3;
-    e->block.dct[48 + col] = coeff[5]*(s0-s3)+coeff[1]*(s2-s1);
-    e->block.dct[56 + col] = coeff[6]*d0-coeff[4]*d1+coeff[2]*d2-coeff[0]*d3;
-  }
+  /* Transform with the DCT kernel selected for the CPU */
+  DSP_Kernels->fdct(block, jpec_dct, e->block.dct);
 
 #undef JPEC_BLOCK
 }
@@ -0,0 +1,439 @@
+/*
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License as
+ *  published by the Free Software Foundation; either version 2 of
+ *  the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details:
+ *
+ *  http://www.gnu.org/copyleft/gpl.txt
+ */
+#include "kernels.h"
+#include "resample.h"
+#include "shared.h"
+#ifdef __clang__
+  #pragma STDC FP_CONTRACT OFF
+#endif
+#ifdef KERNELS_NEON
+  #include <sys/auxv.h>
+  #ifndef HWCAP_ARM_NEON
+    #define HWCAP_ARM_NEON  ( 1 << 12 )
+  #endif
+#endif
+
+/* The bodies of the kernels below are inlined into a
+ * function for each instruction set, so that each is
+ * compiled and vectorized for its own target */
+
+/*------------------------------------------------------------------------*/
+
+/* FFT_Kernel()
+ *
+ * In-place, iterative radix-2 complex FFT
+ */
+  static inline __attribute__(( always_inline )) void
+FFT_Kernel(
+    float *re, float *im,
+    const float *cos_tab, const float *sin_tab,
+    const int *rev, int size )
+{
+  int len, half, step, i, j, k, t;
+  float wr, wi, tr, ti;
+
+  /* Bit reversal permutation */
+  for( i = 0; i < size; i++ )
+  {
+    j = rev[i];
+    if( j > i )
+    {
+      tr = re[i]; re[i] = re[j]; re[j] = tr;
+      ti = im[i]; im[i] = im[j]; im[j] = ti;
+    }
+  }
+
+  /* Butterflies of increasing span */
+  for( len = 2; len <= size; len <<= 1 )
+  {
+    half = len >> 1;
+    step = size / len;
+    for( i = 0; i < size; i += len )
+    {
+      for( k = 0, t = 0; k < half; k++, t += step )
+      {
+        j  = i + k + half;
+        wr = cos_tab[t];
+        wi = sin_tab[t];
+        tr = re[j] * wr + im[j] * wi;
+        ti = im[j] * wr - re[j] * wi;
+        re[j]      = re[i + k] - tr;
+        im[j]      = im[i + k] - ti;
+        re[i + k] += tr;
+        im[i + k] += ti;
+      }
+    }
+  } /* for( len = 2; len <= size; len <<= 1 ) */
+
+} /* FFT_Kernel() */
+
+/*------------------------------------------------------------------------*/
+
+/* IIR_Filter_Kernel()
+ *
+ * Recursive filter of a buffer of samples
+ */
+  static inline __attribute__(( always_inline )) void
+IIR_Filter_Kernel( filter_data_t *filter_data )
+{
+  int buf_idx, idx, npp1, len;
+  double y, yn0;
+
+  npp1 = filter_data->npoles + 1;
+  len  = filter_data->samples_buf_len;
+  for( buf_idx = 0; buf_idx < len; buf_idx++ )
+  {
+    /* Calculate and save filtered samples */
+    yn0 = filter_data->samples_buf[buf_idx] * filter_data->a[0];
+    for( idx = 1; idx < npp1; idx++ )
+    {
+      /* Summate contribution of past input samples */
+      y    = filter_data->a[idx];
+      y   *= filter_data->x[filter_data->ring_idx];
+      yn0 += y;
+
+      /* Summate contribution of past output samples */
+      y   = filter_data->b[idx];
+      y  *= filter_data->y[filter_data->ring_idx];
+      yn0 += y;
+
+      /* Advance ring buffers index */
+      filter_data->ring_idx++;
+      if( filter_data->ring_idx >= npp1 )
+        filter_data->ring_idx = 0;
+
+    } /* for( idx = 0; idx < npp1; idx++ ) */
+
+    /* Save new yn0 output to y ring buffer */
+    filter_data->y[filter_data->ring_idx] = yn0;
+
+    /* Save current input sample to x ring buffer */
+    filter_data->x[filter_data->ring_idx] =
+      filter_data->samples_buf[buf_idx];
+
+    /* Return filtered samples */
+    filter_data->samples_buf[buf_idx] = yn0;
+
+  } /* for( buf_idx = 0; buf_idx < len; buf_idx++ ) */
+
+} /* IIR_Filter_Kernel() */
+
+/*------------------------------------------------------------------------*/
+
+/* Histogram_Kernel()
+ *
+ * Builds the intensity histogram of a line of pixels.
+ * Consecutive pixels go to separate banks, so that runs
+ * of equal values do not stall on updating one counter
+ */
+  static inline __attribute__(( always_inline )) void
+Histogram_Kernel( const unsigned char *line_buf, int line_len, int *hist )
+{
+  int banks[NORM_HIST_BANKS][256];
+  int bank, idx;
+
+  bzero( (void *)banks, sizeof(banks) );
+  for( idx = 0; idx <= line_len - NORM_HIST_BANKS; idx += NORM_HIST_BANKS )
+  {
+    banks[0][ line_buf[idx] ]++;
+    banks[1][ line_buf[idx + 1] ]++;
+    banks[2][ line_buf[idx + 2] ]++;
+    banks[3][ line_buf[idx + 3] ]++;
+  }
+  for( ; idx < line_len; idx++ )
+    banks[0][ line_buf[idx] ]++;
+
+  /* Merge banks into the histogram */
+  for( idx = 0; idx < 256; idx++ )
+  {
+    hist[idx] = banks[0][idx];
+    for( bank = 1; bank < NORM_HIST_BANKS; bank++ )
+      hist[idx] += banks[bank][idx];
+  }
+
+} /* Histogram_Kernel() */
+
+/*------------------------------------------------------------------------*/
+
+/* Remap_Kernel()
+ *
+ * Remaps a line of pixels through a lookup table
+ */
+  static inline __attribute__(( always_inline )) void
+Remap_Kernel( unsigned char *line_buf, const unsigned char *lut, int line_len )
+{
+  int idx;
+
+  for( idx = 0; idx < line_len; idx++ )
+    line_buf[ idx ] = lut[ line_buf[idx] ];
+
+} /* Remap_Kernel() */
+
+/*------------------------------------------------------------------------*/
+
+/* FDCT_Kernel()
+ *
+ * Separable forward DCT of an 8x8 block of level shifted pixels
+ */
+  static inline __attribute__(( always_inline )) void
+FDCT_Kernel( const float *block, const float *coeff, float *dct )
+{
+  float tmp[64];
+  int row, col;
+
+  for( row = 0; row < 8; row++ )
+  {
+    const float *in = &block[8 * row];
+    float s0 = in[0] + in[7];
+    float s1 = in[1] + in[6];
+    float s2 = in[2] + in[5];
+    float s3 = in[3] + in[4];
+
+    float d0 = in[0] - in[7];
+    float d1 = in[1] - in[6];
+    float d2 = in[2] - in[5];
+    float d3 = in[3] - in[4];
+
+    tmp[8 * row]     = coeff[3]*(s0+s1+s2+s3);
+    tmp[8 * row + 1] = coeff[0]*d0+coeff[2]*d1+coeff[4]*d2+coeff[6]*d3;
+    tmp[8 * row + 2] = coeff[1]*(s0-s3)+coeff[5]*(s1-s2);
+    tmp[8 * row + 3] = coeff[2]*d0-coeff[6]*d1-coeff[0]*d2-coeff[4]*d3;
+    tmp[8 * row + 4] = coeff[3]*(s0-s1-s2+s3);
+    tmp[8 * row + 5] = coeff[4]*d0-coeff[0]*d1+coeff[6]*d2+coeff[2]*d3;
+    tmp[8 * row + 6] = coeff[5]*(s0-s3)+coeff[1]*(s2-s1);
+    tmp[8 * row + 7] = coeff[6]*d0-coeff[4]*d1+coeff[2]*d2-coeff[0]*d3;
+  }
+
+  for( col = 0; col < 8; col++ )
+  {
+    float s0 = tmp[     col] + tmp[56 + col];
+    float s1 = tmp[ 8 + col] + tmp[48 + col];
+    float s2 = tmp[16 + col] + tmp[40 + col];
+    float s3 = tmp[24 + col] + tmp[32 + col];
+
+    float d0 = tmp[     col] - tmp[56 + col];
+    float d1 = tmp[ 8 + col] - tmp[48 + col];
+    float d2 = tmp[16 + col] - tmp[40 + col];
+    float d3 = tmp[24 + col] - tmp[32 + col];
+
+    dct[     col] = coeff[3]*(s0+s1+s2+s3);
+    dct[ 8 + col] = coeff[0]*d0+coeff[2]*d1+coeff[4]*d2+coeff[6]*d3;
+    dct[16 + col] = coeff[1]*(s0-s3)+coeff[5]*(s1-s2);
+    dct[24 + col] = coeff[2]*d0-coeff[6]*d1-coeff[0]*d2-coeff[4]*d3;
+    dct[32 + col] = coeff[3]*(s0-s1-s2+s3);
+    dct[40 + col] = coeff[4]*d0-coeff[0]*d1+coeff[6]*d2+coeff[2]*d3;
+    dct[48 + col] = coeff[5]*(s0-s3)+coeff[1]*(s2-s1);
+    dct[56 + col] = coeff[6]*d0-coeff[4]*d1+coeff[2]*d2-coeff[0]*d3;
+  }
+
+} /* FDCT_Kernel() */
+
+/*------------------------------------------------------------------------*/
+
+/* Resample_Kernel()
+ *
+ * Polyphase filter of the resampler, from its history up to
+ * the end given. The taps of each phase are summed in 8
+ * partial sums, so that they are vectorized in floating point
+ */
+  static inline __attribute__(( always_inline )) int
+Resample_Kernel( resampler_t *resampler, int end, short *out )
+{
+  const float *coef, *hist;
+  float acc[ RESAMPLE_TAP_ALIGN ], sum;
+  int count = 0, tap, idx;
+
+  while( resampler->pos < end )
+  {
+    coef = &resampler->coef[ resampler->phase * resampler->taps ];
+    hist = &resampler->hist[ resampler->pos + 1 - resampler->taps ];
+    for( idx = 0; idx < RESAMPLE_TAP_ALIGN; idx++ )
+      acc[idx] = 0.0f;
+    for( tap = 0; tap < resampler->taps; tap += RESAMPLE_TAP_ALIGN )
+      for( idx = 0; idx < RESAMPLE_TAP_ALIGN; idx++ )
+        acc[idx] += coef[tap + idx] * hist[tap + idx];
+
+    sum = 0.0f;
+    for( idx = 0; idx < RESAMPLE_TAP_ALIGN; idx++ )
+      sum += acc[idx];
+    sum += ( sum < 0.0f ) ? -0.5f : 0.5f;
+    if( sum > 32767.0f )  sum = 32767.0f;
+    if( sum < -32768.0f ) sum = -32768.0f;
+    out[count++] = (short)sum;
+
+    /* Step to the next output sample */
+    resampler->phase += resampler->down;
+    resampler->pos   += resampler->phase / resampler->up;
+    resampler->phase %= resampler->up;
+  }
+
+  return( count );
+} /* Resample_Kernel() */
+
+/*------------------------------------------------------------------------*/
+
+/* KERNEL_SET()
+ *
+ * Compiles the kernels with the given function attributes,
+ * into a table of kernels for an instruction set
+ */
+#define KERNEL_SET( isa, attrs ) \
+  static void __attribute__( attrs ) \
+  FFT_##isa( float *re, float *im, const float *cos_tab, \
+      const float *sin_tab, const int *rev, int size ) \
+  { FFT_Kernel( re, im, cos_tab, sin_tab, rev, size ); } \
+  \
+  static void __attribute__( attrs ) \
+  IIR_Filter_##isa( filter_data_t *filter_data ) \
+  { IIR_Filter_Kernel( filter_data ); } \
+  \
+  static void __attribute__( attrs ) \
+  Histogram_##isa( const unsigned char *line_buf, int line_len, int *hist ) \
+  { Histogram_Kernel( line_buf, line_len, hist ); } \
+  \
+  static void __attribute__( attrs ) \
+  Remap_##isa( unsigned char *line_buf, const unsigned char *lut, int line_len ) \
+  { Remap_Kernel( line_buf, lut, line_len ); } \
+  \
+  static void __attribute__( attrs ) \
+  FDCT_##isa( const float *block, const float *coeff, float *dct ) \
+  { FDCT_Kernel( block, coeff, dct ); } \
+  \
+  static int __attribute__( attrs ) \
+  Resample_##isa( resampler_t *resampler, int end, short *out ) \
+  { return( Resample_Kernel(resampler, end, out) ); } \
+  \
+  static const dsp_kernels_t kernels_##isa = \
+  { \
+    #isa, FFT_##isa, IIR_Filter_##isa, \
+    Histogram_##isa, Remap_##isa, FDCT_##isa, Resample_##isa \
+  }
+
+/* Baseline of the build's target, which includes
+ * SSE2 on x86-64 and Advanced SIMD on AArch64 */
+KERNEL_SET( generic, (KERNEL_VECTORIZE) );
+
+#ifdef KERNELS_X86
+KERNEL_SET( sse42, (target("sse4.2"), KERNEL_VECTORIZE) );
+KERNEL_SET( avx2,  (target("avx2,fma"), KERNEL_VECTORIZE) );
+#endif
+
+#ifdef KERNELS_NEON
+KERNEL_SET( neon, (target("fpu=neon"), KERNEL_VECTORIZE) );
+#endif
+
+/*------------------------------------------------------------------------*/
+
+/* Kernels_Supported()
+ *
+ * Checks that the CPU supports the instruction set of kernels
+ */
+  static gboolean
+Kernels_Supported( const dsp_kernels_t *kernels )
+{
+#ifdef KERNELS_X86
+  __builtin_cpu_init();
+  if( kernels == &kernels_avx2 )
+    return( __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") );
+  if( kernels == &kernels_sse42 )
+    return( __builtin_cpu_supports("sse4.2") );
+#endif
+
+#ifdef KERNELS_NEON
+  if( kernels == &kernels_neon )
+    return( (getauxval(AT_HWCAP) & HWCAP_ARM_NEON) != 0 );
+#endif
+
+  return( kernels == &kernels_generic );
+} /* Kernels_Supported() */
+
+/*------------------------------------------------------------------------*/
+
+/* Kernels_Init()
+ *
+ * Selects the best kernels supported by the CPU, or those
+ * named in the XWEFAX_KERNELS environment variable
+ */
+  void
+Kernels_Init( void )
+{
+  /* Kernels in order of preference */
+  static const dsp_kernels_t *candidates[] =
+  {
+#ifdef KERNELS_X86
+    &kernels_avx2,
+    &kernels_sse42,
+#endif
+#ifdef KERNELS_NEON
+    &kernels_neon,
+#endif
+    &kernels_generic
+  };
+
+  const char *name = getenv( KERNELS_ENV );
+  size_t idx;
+
+  DSP_Kernels = NULL;
+  for( idx = 0; idx < sizeof(candidates) / sizeof(candidates[0]); idx++ )
+  {
+    if( !Kernels_Supported(candidates[idx]) ) continue;
+
+    /* Keep best kernels in case the named ones are unavailable */
+    if( DSP_Kernels == NULL )
+      DSP_Kernels = candidates[idx];
+    if( (name != NULL) && (strcmp(name, candidates[idx]->name) == 0) )
+    {
+      DSP_Kernels = candidates[idx];
+      return;
+    }
+  }
+
+  if( name != NULL )
+    fprintf( stderr, "xwefax: %s kernels not available, using %s\n",
+        name, DSP_Kernels->name );
+
+} /* Kernels_Init() */
+
+/*------------------------------------------------------------------------*/
+
+
+/* FFT_Tables()
+ *
+ * Fills the twiddle factors and bit reversed
+ * indices used by the FFT kernel of a given size
+ */
+  void
+FFT_Tables( float *cos_tab, float *sin_tab, int *rev, int size )
+{
+  int idx, bits, bit;
+  double w;
+
+  for( idx = 0; idx < size / 2; idx++ )
+  {
+    w = M_2PI * (double)idx / (double)size;
+    cos_tab[idx] = (float)cos( w );
+    sin_tab[idx] = (float)sin( w );
+  }
+
+  for( bits = 0; (1 << bits) < size; bits++ );
+  for( idx = 0; idx < size; idx++ )
+  {
+    rev[idx] = 0;
+    for( bit = 0; bit < bits; bit++ )
+      if( idx & (1 << bit) ) rev[idx] |= 1 << ( bits - 1 - bit );
+  }
+
+} /* FFT_Tables() */
+
+/*------------------------------------------------------------------------*/
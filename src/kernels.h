@@ -0,0 +1,44 @@
+/*
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License as
+ *  published by the Free Software Foundation; either version 2 of
+ *  the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details:
+ *
+ *  http://www.gnu.org/copyleft/gpl.txt
+ */
+#ifndef KERNELS_H
+#define KERNELS_H   1
+
+#include "common.h"
+
+/* Histogram banks for normalization, unrolled as 4 */
+#define NORM_HIST_BANKS 4
+
+/* Environment variable that overrides the selection of kernels */
+#define KERNELS_ENV     "XWEFAX_KERNELS"
+
+/* Kernels are vectorized by the compiler for each instruction set.
+ * Multiply-adds are not contracted to FMA where the target has it,
+ * so that all kernels give the same floating point results. The IIR
+ * filter is a serial recursion and is not vectorized, it is only
+ * compiled for each instruction set with the others */
+#if defined(__GNUC__) && !defined(__clang__)
+  #define KERNEL_VECTORIZE    optimize( "tree-vectorize", "fp-contract=off" )
+#else
+  #define KERNEL_VECTORIZE
+#endif
+
+/* Instruction sets with their own kernels */
+#if defined(__x86_64__) || defined(__i386__)
+  #define KERNELS_X86     1
+#elif defined(__arm__) && defined(__linux__)
+  #define KERNELS_NEON    1
+#endif
+
+#endif
+
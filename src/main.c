@@ -42,10 +42,47 @@ main (int argc, char *argv[])
   sigaction( SIGTERM, &sa_new, 0 );
   sigaction( SIGABRT, &sa_new, 0 );
 
+  /* Select DSP kernels for the CPU */
+  Kernels_Init();
+
   /* Process command line options */
-  while( (option = getopt(argc, argv, "hv") ) != -1 )
+  while( (option = getopt(argc, argv, "bc:fho:p:r:R:s:v") ) != -1 )
     switch( option )
     {
+      case 'b' : /* Run DSP benchmarks and exit */
+        return( Bench_Run() );
+
+      case 'c' : /* Decode a channel served by another instance */
+        Channel_Client( atoi(optarg) );
+        break;
+
+      case 'f' : /* Demodulate in fixed point arithmetic */
+        SetFlag( FIXED_POINT );
+        break;
+
+      case 'o' : /* Serve a Perseus channel at an offset in Hz */
+#ifdef HAVE_LIBPERSEUS_SDR
+        if( !Perseus_Add_Channel(atoi(optarg)) ) exit(-1);
+#else
+        fprintf( stderr, "xwefax: built without Perseus support\n" );
+        exit(-1);
+#endif
+        break;
+
+      case 'p' : /* Replay a recording in place of the receiver */
+        if( !Replay_Open(optarg) ) exit(-1);
+        break;
+
+      case 'r' : /* Run regression tests against golden images */
+        return( Regress_Run(optarg) );
+
+      case 'R' : /* Re-render the image of a raw discriminator file */
+        return( Raw_Render_Run(optarg) );
+
+      case 's' : /* Receive unattended by a broadcast schedule */
+        Schedule_File( optarg );
+        break;
+
       case 'h' : /* Print usage and exit */
         Usage();
         return(0);
@@ -189,9 +226,15 @@ main (int argc, char *argv[])
   SetFlag( SAVE_IMAGE );
   Set_Indicators( ICON_SAVE_YES );
 
+  /* Performance counters and their SIGUSR1 dump */
+  Perf_Init();
+
   /* Load runtime config file, abort on error */
   g_idle_add( Load_Config, NULL );
 
+  /* Load the broadcast schedule, if given */
+  g_idle_add( Schedule_Start, NULL );
+
   gtk_main ();
 
   return 0;
@@ -0,0 +1,538 @@
+/*
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License as
+ *  published by the Free Software Foundation; either version 2 of
+ *  the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details:
+ *
+ *  http://www.gnu.org/copyleft/gpl.txt
+ */
+#include "perf.h"
+#include "shared.h"
+#include <time.h>
+#include <signal.h>
+#include <glib-unix.h>
+
+/*------------------------------------------------------------------------*/
+
+/* Perf_Clock()
+ *
+ * Returns a monotonic time stamp in nSec
+ */
+  uint64_t
+Perf_Clock( void )
+{
+  struct timespec ts;
+
+  clock_gettime( CLOCK_MONOTONIC, &ts );
+  return( (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec );
+} /* Perf_Clock() */
+
+/*------------------------------------------------------------------------*/
+
+#ifdef ENABLE_PERF
+
+/* Names of pipeline stages, in order of their enum */
+static const char *stage_names[ NUM_PERF_STAGES ] =
+{
+  "Sound Read",
+  "Demodulate SSB",
+  "AFC",
+  "Record",
+  "DSP Filter",
+  "Channelizer",
+  "FM Detect",
+  "Spectrum FFT",
+  "Normalize",
+  "Adaptive Enhance",
+  "Viewer Add Line",
+  "Save PGM",
+  "Save JPEG"
+};
+
+/* Counters of all threads and number in use */
+static perf_thread_t perf_threads[ PERF_MAX_THREADS ];
+static int num_threads = 0;
+static pthread_mutex_t perf_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Counters of the calling thread */
+static __thread perf_thread_t *this_thread = NULL;
+
+/* Time of last reset of counters */
+static uint64_t reset_time = 0;
+
+/* Text view of Performance window */
+static GtkTextView *perf_textview = NULL;
+
+/* Names of traced latencies, in order of their enum */
+static const char *latency_names[ NUM_LATENCIES ] =
+{
+  "Line Decoded",
+  "Line Displayed"
+};
+
+/* Latencies of lines from capture, only used by the GUI thread */
+static perf_stage_t latency[ NUM_LATENCIES ];
+
+/* Sample block used by decoder, capture times of decoded
+ * lines and ring of lines entered to viewer, not yet drawn */
+static perf_capture_t capture = { 0, 0, 0 };
+static uint64_t line_capture[ PERF_LINE_RING ];
+static int
+  added_lines[ PERF_LINE_RING ],
+  added_head  = 0,
+  added_count = 0;
+
+/* Running average of display latency, count of
+ * latency alerts and time of last alert message */
+static double latency_ave = 0.0;
+static int num_alerts = 0;
+static uint64_t alert_time = 0;
+
+/*------------------------------------------------------------------------*/
+
+/* Perf_Thread()
+ *
+ * Assigns a block of counters to the calling thread
+ */
+  static perf_thread_t *
+Perf_Thread( const char *name )
+{
+  perf_thread_t *thread = NULL;
+
+  pthread_mutex_lock( &perf_lock );
+  if( num_threads < PERF_MAX_THREADS )
+  {
+    thread = &perf_threads[ num_threads ];
+    if( name )
+      snprintf( thread->name, sizeof(thread->name), "%s", name );
+    else
+      snprintf( thread->name, sizeof(thread->name),
+          "Thread %d", num_threads );
+    num_threads++;
+  }
+  pthread_mutex_unlock( &perf_lock );
+
+  return( thread );
+} /* Perf_Thread() */
+
+/*------------------------------------------------------------------------*/
+
+/* Perf_Begin()
+ *
+ * Marks the start of a pipeline stage in the calling thread
+ */
+  perf_mark_t
+Perf_Begin( void )
+{
+  perf_mark_t mark = { 0, 0 };
+
+  if( this_thread == NULL )
+  {
+    this_thread = Perf_Thread( NULL );
+    if( this_thread == NULL ) return( mark );
+  }
+
+  mark.nested = this_thread->nested;
+  mark.start  = Perf_Clock();
+
+  return( mark );
+} /* Perf_Begin() */
+
+/*------------------------------------------------------------------------*/
+
+/* Perf_Record()
+ *
+ * Adds a time to the statistics of a stage
+ */
+  static void
+Perf_Record( perf_stage_t *stat, uint64_t time )
+{
+  int bucket, octave;
+
+  if( !stat->count || (time < stat->min) ) stat->min = time;
+  if( time > stat->max ) stat->max = time;
+  stat->count++;
+  stat->total += time;
+
+  /* Histogram bucket of time, times below 2 * PERF_SUB_BUCKETS
+   * have their own buckets, longer ones one per sub-octave */
+  if( time < 2 * PERF_SUB_BUCKETS )
+    bucket = (int)time;
+  else
+  {
+    octave = 63 - __builtin_clzll( time );
+    bucket = ( octave - PERF_SUB_SHIFT + 1 ) * PERF_SUB_BUCKETS +
+      (int)( (time >> (octave - PERF_SUB_SHIFT)) & (PERF_SUB_BUCKETS - 1) );
+  }
+  if( bucket >= PERF_BUCKETS ) bucket = PERF_BUCKETS - 1;
+  stat->hist[ bucket ]++;
+
+} /* Perf_Record() */
+
+/*------------------------------------------------------------------------*/
+
+/* Perf_End()
+ *
+ * Adds the time of a stage since its mark, less the time of
+ * stages nested in it, to the calling thread's own counters
+ */
+  void
+Perf_End( int stage, perf_mark_t mark )
+{
+  uint64_t elapsed;
+
+  if( this_thread == NULL ) return;
+
+  elapsed = Perf_Clock() - mark.start;
+  Perf_Record( &this_thread->stage[ stage ],
+      elapsed - (this_thread->nested - mark.nested) );
+  this_thread->nested = mark.nested + elapsed;
+
+} /* Perf_End() */
+
+/*------------------------------------------------------------------------*/
+
+/* Perf_Capture()
+ *
+ * Marks a block of signal samples, captured
+ * at a time stamp, for use by the decoder
+ */
+  void
+Perf_Capture( uint64_t time, int frames )
+{
+  capture.time   = time;
+  capture.frames = frames;
+  capture.used   = 0;
+} /* Perf_Capture() */
+
+/*------------------------------------------------------------------------*/
+
+/* Perf_Sample()
+ *
+ * Counts a sample of the block used by the decoder
+ */
+  void
+Perf_Sample( void )
+{
+  capture.used++;
+} /* Perf_Sample() */
+
+/*------------------------------------------------------------------------*/
+
+/* Perf_Line()
+ *
+ * Records the capture time of the last sample of a decoded
+ * image line, back-dated from its block's time stamp, and
+ * the latency of the line's decoding from its capture
+ */
+  void
+Perf_Line( int line )
+{
+  uint64_t time = 0, now;
+  int left = capture.frames - capture.used;
+
+  if( capture.time && (rc_data.dsp_rate > 0) )
+  {
+    if( left < 0 ) left = 0;
+    time = capture.time -
+      (uint64_t)left * 1000000000ull / (uint64_t)rc_data.dsp_rate;
+    now = Perf_Clock();
+    if( now > time ) Perf_Record( &latency[LATENCY_LINE], now - time );
+  }
+
+  line_capture[ line & (PERF_LINE_RING - 1) ] = time;
+} /* Perf_Line() */
+
+/*------------------------------------------------------------------------*/
+
+/* Perf_Line_Added()
+ *
+ * Queues a line entered to the viewer, to be timed when drawn
+ */
+  void
+Perf_Line_Added( int line )
+{
+  added_lines[ (added_head + added_count) & (PERF_LINE_RING - 1) ] = line;
+  if( added_count < PERF_LINE_RING )
+    added_count++;
+  else /* Drop the oldest line */
+    added_head = ( added_head + 1 ) & ( PERF_LINE_RING - 1 );
+} /* Perf_Line_Added() */
+
+/*------------------------------------------------------------------------*/
+
+/* Perf_Alert()
+ *
+ * Shows a message of grown display latency
+ */
+  static gboolean
+Perf_Alert( gpointer data )
+{
+  char mesg[ MESG_SIZE ];
+
+  snprintf( mesg, sizeof(mesg),
+      _("Display latency grew to %d mSec"), GPOINTER_TO_INT(data) );
+  Show_Message( mesg, "orange" );
+
+  return( FALSE );
+} /* Perf_Alert() */
+
+/*------------------------------------------------------------------------*/
+
+/* Perf_Displayed()
+ *
+ * Records the latency from capture of lines drawn in the
+ * viewer, and flags it when it grows well over its average
+ */
+  void
+Perf_Displayed( void )
+{
+  uint64_t now, time, lat;
+  int line;
+
+  now = Perf_Clock();
+  for( ; added_count > 0; added_count-- )
+  {
+    line = added_lines[ added_head ];
+    added_head = ( added_head + 1 ) & ( PERF_LINE_RING - 1 );
+
+    time = line_capture[ line & (PERF_LINE_RING - 1) ];
+    if( !time || (now <= time) ) continue;
+    lat = now - time;
+    Perf_Record( &latency[LATENCY_DISPLAY], lat );
+
+    /* Flag latency grown over its average, e.g. on GUI stalls */
+    if( (lat > PERF_ALERT_MIN * 1000000ull) && (latency_ave > 0.0) &&
+        ((double)lat > PERF_ALERT_GROWTH * latency_ave) )
+    {
+      num_alerts++;
+      if( now - alert_time > PERF_ALERT_INTERVAL * 1000000000ull )
+      {
+        alert_time = now;
+        g_idle_add( Perf_Alert, GINT_TO_POINTER((int)(lat / 1000000)) );
+      }
+    }
+
+    if( latency_ave == 0.0 )
+      latency_ave = (double)lat;
+    else
+      latency_ave += ( (double)lat - latency_ave ) * PERF_LATENCY_WEIGHT;
+  }
+
+} /* Perf_Displayed() */
+
+/*------------------------------------------------------------------------*/
+
+/* Percentile()
+ *
+ * Returns an upper bound of the given
+ * percentile of a stage's times, in nSec
+ */
+  static uint64_t
+Percentile( const perf_stage_t *stat, int percent )
+{
+  uint64_t sum = 0, limit, bound;
+  int idx;
+
+  limit = ( stat->count * (uint64_t)percent + 99 ) / 100;
+  for( idx = 0; idx < PERF_BUCKETS; idx++ )
+  {
+    sum += stat->hist[ idx ];
+    if( sum >= limit ) break;
+  }
+  if( idx >= PERF_BUCKETS ) idx = PERF_BUCKETS - 1;
+
+  /* Upper end of the bucket */
+  if( idx < 2 * PERF_SUB_BUCKETS )
+    bound = (uint64_t)idx + 1;
+  else
+    bound = (uint64_t)( PERF_SUB_BUCKETS + idx % PERF_SUB_BUCKETS + 1 ) <<
+      ( idx / PERF_SUB_BUCKETS - 1 );
+
+  return( MIN(bound, stat->max) );
+} /* Percentile() */
+
+/*------------------------------------------------------------------------*/
+
+/* Perf_Report()
+ *
+ * Formats the counters of all threads into a text report
+ */
+  static void
+Perf_Report( char *report, size_t size )
+{
+  perf_stage_t stat;
+  double elapsed;
+  size_t len;
+  int thr, stg;
+
+  elapsed = (double)( Perf_Clock() - reset_time ) / 1.0E9;
+  len = (size_t)snprintf( report, size,
+      "Elapsed %.1f sec, stage times exclude nested stages\n\n"
+      "%-10s %-17s %10s %9s %9s %9s %9s %9s %6s\n",
+      elapsed, "Thread", "Stage", "Calls", "Mean ns",
+      "Min ns", "P50 ns", "P99 ns", "Max ns", "CPU%" );
+
+  for( thr = 0; thr < num_threads; thr++ )
+    for( stg = 0; stg < NUM_PERF_STAGES; stg++ )
+    {
+      /* Snapshot, counters may be updated meanwhile */
+      stat = perf_threads[ thr ].stage[ stg ];
+      if( !stat.count || (len >= size) ) continue;
+
+      len += (size_t)snprintf( report + len, size - len,
+          "%-10s %-17s %10llu %9llu %9llu %9llu %9llu %9llu %6.2f\n",
+          perf_threads[ thr ].name, stage_names[ stg ],
+          (unsigned long long)stat.count,
+          (unsigned long long)( stat.total / stat.count ),
+          (unsigned long long)stat.min,
+          (unsigned long long)Percentile( &stat, 50 ),
+          (unsigned long long)Percentile( &stat, 99 ),
+          (unsigned long long)stat.max,
+          elapsed > 0.0 ? (double)stat.total / elapsed / 1.0E7 : 0.0 );
+    }
+
+  /* Latencies of image lines from signal capture */
+  if( len < size )
+    len += (size_t)snprintf( report + len, size - len,
+        "\nLatency from capture, %d alerts\n"
+        "%-28s %10s %9s %9s %9s %9s %9s\n",
+        num_alerts, "Image line", "Lines", "Mean ms",
+        "Min ms", "P50 ms", "P99 ms", "Max ms" );
+
+  for( stg = 0; stg < NUM_LATENCIES; stg++ )
+  {
+    stat = latency[ stg ];
+    if( !stat.count || (len >= size) ) continue;
+
+    len += (size_t)snprintf( report + len, size - len,
+        "%-28s %10llu %9.1f %9.1f %9.1f %9.1f %9.1f\n",
+        latency_names[ stg ], (unsigned long long)stat.count,
+        (double)( stat.total / stat.count ) / 1.0E6,
+        (double)stat.min / 1.0E6,
+        (double)Percentile( &stat, 50 ) / 1.0E6,
+        (double)Percentile( &stat, 99 ) / 1.0E6,
+        (double)stat.max / 1.0E6 );
+  }
+
+} /* Perf_Report() */
+
+/*------------------------------------------------------------------------*/
+
+/* Perf_Dump()
+ *
+ * Prints the report to stderr on SIGUSR1
+ */
+  static gboolean
+Perf_Dump( gpointer data )
+{
+  static char report[ PERF_REPORT_SIZE ];
+
+  Perf_Report( report, sizeof(report) );
+  fprintf( stderr, "xwefax: Performance Counters\n%s\n", report );
+
+  return( TRUE );
+} /* Perf_Dump() */
+
+/*------------------------------------------------------------------------*/
+
+/* Perf_Refresh()
+ *
+ * Refreshes the Performance window while it is open
+ */
+  static gboolean
+Perf_Refresh( gpointer data )
+{
+  static char report[ PERF_REPORT_SIZE ];
+
+  if( perf_window == NULL )
+  {
+    perf_textview = NULL;
+    return( FALSE );
+  }
+
+  Perf_Report( report, sizeof(report) );
+  gtk_text_buffer_set_text(
+      gtk_text_view_get_buffer(perf_textview), report, -1 );
+
+  return( TRUE );
+} /* Perf_Refresh() */
+
+#endif
+
+/*------------------------------------------------------------------------*/
+
+/* Perf_Init()
+ *
+ * Names the GUI thread's counters and
+ * installs the SIGUSR1 report dump
+ */
+  void
+Perf_Init( void )
+{
+#ifdef ENABLE_PERF
+  this_thread = Perf_Thread( "GUI" );
+  reset_time  = Perf_Clock();
+  g_unix_signal_add( SIGUSR1, Perf_Dump, NULL );
+#endif
+} /* Perf_Init() */
+
+/*------------------------------------------------------------------------*/
+
+/* Perf_Reset()
+ *
+ * Clears the counters of all threads
+ */
+  void
+Perf_Reset( void )
+{
+#ifdef ENABLE_PERF
+  int idx;
+
+  pthread_mutex_lock( &perf_lock );
+  for( idx = 0; idx < num_threads; idx++ )
+    memset( perf_threads[idx].stage, 0, sizeof(perf_threads[idx].stage) );
+  memset( latency, 0, sizeof(latency) );
+  latency_ave = 0.0;
+  num_alerts  = 0;
+  reset_time = Perf_Clock();
+  pthread_mutex_unlock( &perf_lock );
+#endif
+} /* Perf_Reset() */
+
+/*------------------------------------------------------------------------*/
+
+/* Perf_Window()
+ *
+ * Opens the Performance window, showing
+ * the counters of pipeline stages
+ */
+  void
+Perf_Window( void )
+{
+#ifdef ENABLE_PERF
+  if( perf_window != NULL ) return;
+
+  perf_window = create_perf_window( &perf_window_builder );
+  perf_textview = GTK_TEXT_VIEW(
+      Builder_Get_Object(perf_window_builder, "perf_textview") );
+  g_object_unref( perf_window_builder );
+  perf_window_builder = NULL;
+  gtk_widget_show( perf_window );
+
+  Perf_Refresh( NULL );
+  g_timeout_add( PERF_REFRESH, Perf_Refresh, NULL );
+#else
+  Show_Message(
+      _("Performance counters not compiled in,\n"
+        "configure with --enable-perf"), "orange" );
+#endif
+} /* Perf_Window() */
+
+/*------------------------------------------------------------------------*/
+
@@ -0,0 +1,85 @@
+/*
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License as
+ *  published by the Free Software Foundation; either version 2 of
+ *  the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details:
+ *
+ *  http://www.gnu.org/copyleft/gpl.txt
+ */
+#ifndef PERF_H
+#define PERF_H      1
+
+#include "common.h"
+
+/* Histogram buckets of stage times, nanoseconds in octaves
+ * up to 2^40, each split in linear sub-buckets (a power of 2) */
+#define PERF_OCTAVES        40
+#define PERF_SUB_BUCKETS    8
+#define PERF_SUB_SHIFT      3
+#define PERF_BUCKETS        ( (PERF_OCTAVES - PERF_SUB_SHIFT + 1) * PERF_SUB_BUCKETS )
+
+/* Maximum number of threads with their own counters */
+#define PERF_MAX_THREADS    8
+
+/* Refresh interval of Performance window, mSec */
+#define PERF_REFRESH        1000
+
+/* Size of the performance report text */
+#define PERF_REPORT_SIZE    8192
+
+/* Image lines traced from capture to display, a power of 2 */
+#define PERF_LINE_RING      256
+
+/* A displayed line's latency is flagged if it is over the
+ * minimum, in mSec, and over a multiple of the average */
+#define PERF_ALERT_MIN      250
+#define PERF_ALERT_GROWTH   2.0
+
+/* Minimum interval between latency alert messages, sec */
+#define PERF_ALERT_INTERVAL 10
+
+/* Weight of new latency in its running average */
+#define PERF_LATENCY_WEIGHT 0.01
+
+/* Latencies of image lines from signal capture */
+enum
+{
+  LATENCY_LINE = 0, /* To line decoded */
+  LATENCY_DISPLAY,  /* To line displayed */
+  NUM_LATENCIES
+};
+
+/* Timing statistics of a pipeline stage */
+typedef struct
+{
+  uint64_t
+    count,  /* Number of timed runs */
+    total,  /* Total time, nSec */
+    min,    /* Shortest run, nSec */
+    max,    /* Longest run, nSec */
+    hist[ PERF_BUCKETS ]; /* Runs per sub-octave of nSec */
+} perf_stage_t;
+
+/* Counters of a thread, only written by their own thread */
+typedef struct
+{
+  char name[ 16 ];
+  uint64_t nested; /* Total time of stages, to exclude nested ones */
+  perf_stage_t stage[ NUM_PERF_STAGES ];
+} perf_thread_t;
+
+/* Block of signal samples being used by the decoder */
+typedef struct
+{
+  uint64_t time; /* Capture time of block's last sample, nSec */
+  int frames;    /* Number of samples in block */
+  int used;      /* Number of samples used */
+} perf_capture_t;
+
+#endif
+
@@ -21,6 +21,16 @@ static perseus_descr *descr = NULL;
 /* I/Q Samples buffers for the LP Filters */
 static double *demod_buf_i = NULL, *demod_buf_q = NULL;
 
+/* As above, for the fixed point demodulator */
+static int32_t *demod_fix_i = NULL, *demod_fix_q = NULL;
+
+/* Capture time of above buffers, for latency tracing */
+static uint64_t demod_buf_time = 0;
+
+/* Channels of the channelizer and their count */
+static perseus_chan_t perseus_chan[ PERSEUS_MAX_CHANNELS ];
+static int num_chans = 0;
+
 /*----------------------------------------------------------------------*/
 
 /* Perseus_Settings()
@@ -60,6 +70,55 @@ Perseus_Settings( uint8_t setting )
 
 /*----------------------------------------------------------------------*/
 
+/* Perseus_Step_Attenuators()
+ *
+ * Brings input attenuators in or out by one 10dB step
+ */
+  static void
+Perseus_Step_Attenuators( gboolean up )
+{
+  static gboolean att_10db = FALSE, att_20db = FALSE;
+
+  if( up )
+  {
+    if( !att_10db && !att_20db )
+    {
+      Perseus_Settings( PERSEUS_ATTEN_10DB );
+      att_10db = TRUE;
+    }
+    else if( !att_20db && att_10db )
+    {
+      Perseus_Settings(  PERSEUS_ATTEN_20DB );
+      Perseus_Settings( (uint8_t)~PERSEUS_ATTEN_10DB );
+      att_20db = TRUE;
+      att_10db = FALSE;
+    }
+    else if( att_20db && !att_10db )
+    {
+      Perseus_Settings( PERSEUS_ATTEN_10DB );
+      att_10db = TRUE;
+    }
+  } /* if( up ) */
+  else
+  {
+    if( att_10db )
+    {
+      Perseus_Settings( (uint8_t)~PERSEUS_ATTEN_10DB );
+      att_10db = FALSE;
+    }
+    else if( att_20db && !att_10db )
+    {
+      Perseus_Settings(  PERSEUS_ATTEN_10DB );
+      Perseus_Settings( (uint8_t)~PERSEUS_ATTEN_20DB );
+      att_10db = TRUE;
+      att_20db = FALSE;
+    }
+  } /* else */
+
+} /* Perseus_Step_Attenuators() */
+
+/*----------------------------------------------------------------------*/
+
 /* Perseus_Attenuators()
  *
  * Calculates S-meter indication from ADAGC scale factor
@@ -70,47 +129,405 @@ Perseus_Attenuators( double adagc_scale )
 {
   /* ADAGC scale factor in relative dBm */
   double log_adagc_scale;
-  static gboolean att_10db = FALSE, att_20db = FALSE;
 
   /* Set Perseus attenuators if in auto mode */
   log_adagc_scale = 20.0 * log10( adagc_scale );
-    if( log_adagc_scale > PERSEUS_ATT_UP )
-    {
-      if( !att_10db && !att_20db )
-      {
-        Perseus_Settings( PERSEUS_ATTEN_10DB );
-        att_10db = TRUE;
-      }
-      else if( !att_20db && att_10db )
-      {
-        Perseus_Settings(  PERSEUS_ATTEN_20DB );
-        Perseus_Settings( (uint8_t)~PERSEUS_ATTEN_10DB );
-        att_20db = TRUE;
-        att_10db = FALSE;
-      }
-      else if( att_20db && !att_10db )
+  if( log_adagc_scale > PERSEUS_ATT_UP )
+    Perseus_Step_Attenuators( TRUE );
+  else if( log_adagc_scale < PERSEUS_ATT_DOWN )
+    Perseus_Step_Attenuators( FALSE );
+
+} /* Perseus_Attenuators() */
+
+/*----------------------------------------------------------------------*/
+
+/* Perseus_Add_Channel()
+ *
+ * Adds a channel to the channelizer at an offset in Hz
+ * from the tuned frequency, to be served to another instance
+ */
+  gboolean
+Perseus_Add_Channel( int offset )
+{
+  if( num_chans >= PERSEUS_MAX_CHANNELS )
+  {
+    fprintf( stderr, _("xwefax: at most %d Perseus channels\n"),
+        PERSEUS_MAX_CHANNELS );
+    return( FALSE );
+  }
+
+  if( abs(offset) > PERSEUS_MAX_OFFSET )
+  {
+    fprintf( stderr, _("xwefax: Perseus channel offset %d Hz"
+          " is outside +/- %d Hz\n"), offset, PERSEUS_MAX_OFFSET );
+    return( FALSE );
+  }
+
+  perseus_chan[num_chans].offset = offset;
+  num_chans++;
+
+  return( TRUE );
+} /* Perseus_Add_Channel() */
+
+/*----------------------------------------------------------------------*/
+
+/* Perseus_Channels_Init()
+ *
+ * Sets up the NCOs, Weaver phasors, filters and decimators
+ * of the channelizer and the shared rings its channels are
+ * served in
+ */
+  static void
+Perseus_Channels_Init( void )
+{
+  perseus_chan_t *chan;
+  double dphi = 0.0, cutoff;
+  int ch;
+
+  /* Weaver phasing frequency as in Demodulate_SSB() */
+  if( strcmp(rc_data.station_sideband, "USB") == 0 )
+    dphi = M_2PI / (double)( PERSEUS_SAMPLE_RATE / PERSEUS_WEAVER_FREQ );
+  else if( strcmp(rc_data.station_sideband, "LSB") == 0 )
+    dphi = -M_2PI / (double)( PERSEUS_SAMPLE_RATE / PERSEUS_WEAVER_FREQ );
+
+  cutoff  = PERSEUS_DEMOD_BANDW;
+  cutoff /= (double)PERSEUS_SAMPLE_RATE * 2.0;
+
+  size_t req = (size_t)PERSEUS_BUFFER_LEN * sizeof(double);
+  for( ch = 0; ch < num_chans; ch++ )
+  {
+    chan = &perseus_chan[ch];
+
+    /* The NCO steps back by the channel's offset */
+    double w = M_2PI * (double)chan->offset / (double)PERSEUS_SAMPLE_RATE;
+    chan->nco_re = 1.0;
+    chan->nco_im = 0.0;
+    chan->nco_step_re = cos( w );
+    chan->nco_step_im = -sin( w );
+
+    chan->wvr_re = 1.0;
+    chan->wvr_im = 0.0;
+    chan->wvr_step_re = cos( dphi );
+    chan->wvr_step_im = sin( dphi );
+    chan->adagc_scale = 1.0;
+
+    if( chan->buf_i == NULL )
+      mem_alloc( (void **)&chan->buf_i, req );
+    if( chan->buf_q == NULL )
+      mem_alloc( (void **)&chan->buf_q, req );
+
+    chan->filter_i.cutoff   = cutoff;
+    chan->filter_i.ripple   = SSB_FILTER_RIPPLE;
+    chan->filter_i.npoles   = SSB_FILTER_POLES;
+    chan->filter_i.type     = FILTER_LOWPASS;
+    chan->filter_i.ring_idx = 0;
+    chan->filter_i.samples_buf = chan->buf_i;
+    chan->filter_i.samples_buf_len = PERSEUS_BUFFER_LEN;
+    Init_Chebyshev_Filter( &chan->filter_i );
+
+    chan->filter_q.cutoff   = cutoff;
+    chan->filter_q.ripple   = SSB_FILTER_RIPPLE;
+    chan->filter_q.npoles   = SSB_FILTER_POLES;
+    chan->filter_q.type     = FILTER_LOWPASS;
+    chan->filter_q.ring_idx = 0;
+    chan->filter_q.samples_buf = chan->buf_q;
+    chan->filter_q.samples_buf_len = PERSEUS_BUFFER_LEN;
+    Init_Chebyshev_Filter( &chan->filter_q );
+
+    if( !Resample_Init(&chan->resampler, PERSEUS_SAMPLE_RATE,
+          PERSEUS_CHANNEL_RATE, PERSEUS_BUFFER_LEN) ||
+        !Channel_Serve_Open(PERSEUS_FIRST_CHANNEL + ch,
+          PERSEUS_CHANNEL_RATE) )
+      fprintf( stderr, _("xwefax: cannot serve Perseus channel %d\n"),
+          PERSEUS_FIRST_CHANNEL + ch );
+  } /* for( ch = 0; ch < num_chans; ch++ ) */
+
+} /* Perseus_Channels_Init() */
+
+/*----------------------------------------------------------------------*/
+
+/* Perseus_Channelize()
+ *
+ * Mixes each channel of the channelizer down from its offset,
+ * filters and demodulates it, and decimates it to serve it to
+ * another instance. Called on each new I/Q buffer, before it
+ * is filtered in place
+ */
+  static void
+Perseus_Channelize( void )
+{
+  static short *chan_samples = NULL, *chan_audio = NULL;
+  perseus_chan_t *chan;
+  double re, im, tmp, base_band, signal_ratio;
+  int ch, idx, len;
+
+  if( !num_chans ) return;
+
+  if( (chan_samples == NULL) &&
+      (!mem_alloc((void **)&chan_samples,
+                  (size_t)PERSEUS_BUFFER_LEN * sizeof(short)) ||
+       !mem_alloc((void **)&chan_audio,
+         (size_t)perseus_chan[0].resampler.max_out * sizeof(short))) )
+    return;
+
+  PERF_BEGIN( PERF_CHANNELIZE );
+  for( ch = 0; ch < num_chans; ch++ )
+  {
+    chan = &perseus_chan[ch];
+    if( chan->resampler.coef == NULL ) continue;
+
+    /* Take the I/Q samples at the scale of the floating point path */
+    if( isFlagSet(FIXED_POINT) )
+      for( idx = 0; idx < PERSEUS_BUFFER_LEN; idx++ )
       {
-        Perseus_Settings( PERSEUS_ATTEN_10DB );
-        att_10db = TRUE;
+        chan->buf_i[idx] =
+          (double)demod_fix_i[idx] * (double)( 1 << PERSEUS_FIXED_SHIFT );
+        chan->buf_q[idx] =
+          (double)demod_fix_q[idx] * (double)( 1 << PERSEUS_FIXED_SHIFT );
       }
-    } /* if( log_adagc_scale > PERSEUS_ATT_UP ) */
-    else if( log_adagc_scale < PERSEUS_ATT_DOWN )
+    else
     {
-      if( att_10db )
-      {
-        Perseus_Settings( (uint8_t)~PERSEUS_ATTEN_10DB );
-        att_10db = FALSE;
-      }
-      else if( att_20db && !att_10db )
-      {
-        Perseus_Settings(  PERSEUS_ATTEN_10DB );
-        Perseus_Settings( (uint8_t)~PERSEUS_ATTEN_20DB );
-        att_10db = TRUE;
-        att_20db = FALSE;
-      }
-    } /* if( log_adagc_scale > PERSEUS_ATT_DOWN ) */
+      memcpy( chan->buf_i, demod_buf_i, PERSEUS_BUFFER_LEN * sizeof(double) );
+      memcpy( chan->buf_q, demod_buf_q, PERSEUS_BUFFER_LEN * sizeof(double) );
+    }
 
-} /* Perseus_Attenuators() */
+    /* Mix the channel's carrier down to zero */
+    for( idx = 0; idx < PERSEUS_BUFFER_LEN; idx++ )
+    {
+      re = chan->buf_i[idx];
+      im = chan->buf_q[idx];
+      chan->buf_i[idx] = re * chan->nco_re - im * chan->nco_im;
+      chan->buf_q[idx] = re * chan->nco_im + im * chan->nco_re;
+
+      tmp = chan->nco_re * chan->nco_step_re -
+        chan->nco_im * chan->nco_step_im;
+      chan->nco_im = chan->nco_re * chan->nco_step_im +
+        chan->nco_im * chan->nco_step_re;
+      chan->nco_re = tmp;
+    }
+
+    DSP_Filter( &chan->filter_i );
+    DSP_Filter( &chan->filter_q );
+
+    /* Weaver SSB demodulator and ADAGC as in Demodulate_SSB() */
+    for( idx = 0; idx < PERSEUS_BUFFER_LEN; idx++ )
+    {
+      base_band =
+        chan->buf_i[idx] * chan->wvr_im +
+        chan->buf_q[idx] * chan->wvr_re;
+
+      tmp = chan->wvr_re * chan->wvr_step_re -
+        chan->wvr_im * chan->wvr_step_im;
+      chan->wvr_im = chan->wvr_re * chan->wvr_step_im +
+        chan->wvr_im * chan->wvr_step_re;
+      chan->wvr_re = tmp;
+
+      signal_ratio = fabs( base_band ) / ADAGC_REF_LEVEL;
+      if( signal_ratio > chan->adagc_scale )
+        chan->adagc_scale = signal_ratio;
+      else
+        chan->adagc_scale *= ADAGC_DECAY;
+
+      chan_samples[idx] = (short)( base_band / chan->adagc_scale );
+    }
+
+    /* Keep the phasors on the unit circle */
+    tmp = 1.0 / hypot( chan->nco_re, chan->nco_im );
+    chan->nco_re *= tmp;
+    chan->nco_im *= tmp;
+    tmp = 1.0 / hypot( chan->wvr_re, chan->wvr_im );
+    chan->wvr_re *= tmp;
+    chan->wvr_im *= tmp;
+
+    /* Decimate to the channel rate, so that the
+     * clients run their detectors at a low rate */
+    len = Resample( &chan->resampler,
+        chan_samples, PERSEUS_BUFFER_LEN, chan_audio );
+    Channel_Serve( PERSEUS_FIRST_CHANNEL + ch, chan_audio, len );
+  } /* for( ch = 0; ch < num_chans; ch++ ) */
+  PERF_END( PERF_CHANNELIZE );
+
+} /* Perseus_Channelize() */
+
+/*----------------------------------------------------------------------*/
+
+/* Perseus_Replay_Buffer()
+ *
+ * Fills the demodulator's I/Q buffers from the recording
+ * replayed, in place of the Perseus async read thread
+ */
+  static void
+Perseus_Replay_Buffer( void )
+{
+  int idx;
+
+  Replay_IQ( demod_fix_i, demod_fix_q, PERSEUS_BUFFER_LEN );
+  if( isFlagSet(FIXED_POINT) )
+    for( idx = 0; idx < PERSEUS_BUFFER_LEN; idx++ )
+    {
+      demod_fix_i[idx] >>= PERSEUS_FIXED_SHIFT;
+      demod_fix_q[idx] >>= PERSEUS_FIXED_SHIFT;
+    }
+  else
+    for( idx = 0; idx < PERSEUS_BUFFER_LEN; idx++ )
+    {
+      demod_buf_i[idx] = (double)demod_fix_i[idx];
+      demod_buf_q[idx] = (double)demod_fix_q[idx];
+    }
+  demod_buf_time = Perf_Clock();
+
+} /* Perseus_Replay_Buffer() */
+
+/*----------------------------------------------------------------------*/
+
+/* Demodulate_SSB_Fixed()
+ *
+ * Demodulates SSB Signals as Demodulate_SSB() but in integer
+ * arithmetic: Q29 filter sections, Q15 Weaver trig tables and
+ * an ADAGC whose level is kept in Q16 sample units
+ */
+  static gboolean
+Demodulate_SSB_Fixed( short *signal_sample )
+{
+  /* Index to i and q buffers */
+  static int iqd_buf_idx = PERSEUS_BUFFER_LEN;
+
+  /* sinf/cosf tables, their length and index */
+  static int32_t *sinf = NULL, *cosf = NULL;
+  static int trig_len, itr = 0;
+
+  /* ADAGC signal level and gain in Q16, and the
+   * levels that bring attenuators in or out */
+  static int64_t adagc_level, adagc_gain, att_up, att_down;
+
+  int64_t base_band, level;
+
+  /* Demodulator filters for samples buffers */
+  static filter_fixed_t demod_filter_i, demod_filter_q;
+
+
+  /* Initialize on first call */
+  static gboolean init = TRUE;
+  if( init )
+  {
+    filter_data_t design;
+    double phi = 0.0, dphi = 0.0;
+    int idx;
+
+    /* Length of sinf/cosf trig tables */
+    trig_len = PERSEUS_SAMPLE_RATE / PERSEUS_WEAVER_FREQ;
+
+    /* Allocate trigonometric tables */
+    size_t req = (size_t)trig_len * sizeof(int32_t);
+    mem_alloc( (void **)&sinf, req );
+    mem_alloc( (void **)&cosf, req );
+
+    /* Calculate Q15 trigonometric tables, as in Demodulate_SSB() */
+    if( strcmp(rc_data.station_sideband, "USB") == 0 )
+      dphi = M_2PI / (double)trig_len;
+    else if( strcmp(rc_data.station_sideband, "LSB") == 0 )
+      dphi = -M_2PI / (double)trig_len;
+
+    for( idx = 0; idx < trig_len; idx++ )
+    {
+      sinf[idx] = TO_FIXED( sin(phi), Q15_SHIFT );
+      cosf[idx] = TO_FIXED( cos(phi), Q15_SHIFT );
+      phi += dphi;
+    }
+
+    /* Demodulator LP filters, designed as in Demodulate_SSB() */
+    design.cutoff  = PERSEUS_DEMOD_BANDW / (double)PERSEUS_SAMPLE_RATE / 2.0;
+    design.ripple  = SSB_FILTER_RIPPLE;
+    design.npoles  = SSB_FILTER_POLES;
+    design.type    = FILTER_LOWPASS;
+    Init_Chebyshev_Fixed( &design, &demod_filter_i );
+    Init_Chebyshev_Fixed( &design, &demod_filter_q );
+    demod_filter_i.samples_buf = demod_fix_i;
+    demod_filter_q.samples_buf = demod_fix_q;
+    demod_filter_i.samples_buf_len = PERSEUS_BUFFER_LEN;
+    demod_filter_q.samples_buf_len = PERSEUS_BUFFER_LEN;
+
+    /* ADAGC scale of 1.0 and the attenuators' thresholds, in the
+     * units of the I/Q samples scaled down by PERSEUS_FIXED_SHIFT */
+    adagc_level = (int64_t)ADAGC_REF_LEVEL << ( 16 - PERSEUS_FIXED_SHIFT );
+    adagc_gain  = ( (int64_t)ADAGC_REF_LEVEL << 32 ) / adagc_level;
+    att_up   = (int64_t)( ADAGC_REF_LEVEL * pow(10.0, PERSEUS_ATT_UP / 20.0) *
+        65536.0 / (double)(1 << PERSEUS_FIXED_SHIFT) );
+    att_down = (int64_t)( ADAGC_REF_LEVEL * pow(10.0, PERSEUS_ATT_DOWN / 20.0) *
+        65536.0 / (double)(1 << PERSEUS_FIXED_SHIFT) );
+
+    init = FALSE;
+  } /* if( init ) */
+
+  /* Wait for new IQ data */
+  if( iqd_buf_idx >= PERSEUS_BUFFER_LEN )
+  {
+    /* Take I/Q data from the recording replayed, else
+     * wait on DSP data to be ready for processing */
+    if( isFlagSet(FILE_SOURCE) )
+      Perseus_Replay_Buffer();
+    else
+      sem_wait( &pback_semaphore );
+
+    PERF_CAPTURE( demod_buf_time, PERSEUS_BUFFER_LEN );
+
+    /* Serve the other channels before filtering in place */
+    Perseus_Channelize();
+
+    /* Demodulate filtered I/Q buffers */
+    DSP_Filter_Fixed( &demod_filter_i );
+    DSP_Filter_Fixed( &demod_filter_q );
+
+    iqd_buf_idx = 0;
+  }
+
+  /* Apply Weaver SSB demodulator method to get base band */
+  PERF_BEGIN( PERF_DEMOD_SSB );
+  base_band =
+    (int64_t)demod_fix_i[iqd_buf_idx] * sinf[itr] +
+    (int64_t)demod_fix_q[iqd_buf_idx] * cosf[itr];
+  base_band >>= Q15_SHIFT;
+  itr++;
+  if( itr >= trig_len ) itr = 0;
+  iqd_buf_idx++;
+  PERF_SAMPLE();
+
+  /* Apply audio derived AGC, the gain is only
+   * divided out on attack and tracks the decay */
+  level = ( base_band < 0 ? -base_band : base_band ) << 16;
+  if( level > adagc_level )
+  {
+    adagc_level = level;
+    adagc_gain  = ( (int64_t)ADAGC_REF_LEVEL << 32 ) / adagc_level;
+  }
+  else
+  {
+    adagc_level -= ( adagc_level * ADAGC_DECAY_Q32 ) >> 32;
+    adagc_gain  += ( adagc_gain  * ADAGC_GROWTH_Q32 ) >> 32;
+    if( adagc_gain > ADAGC_GAIN_MAX ) adagc_gain = ADAGC_GAIN_MAX;
+  }
+
+  /* Scale demodulated signal and return as short int */
+  base_band = ( base_band * adagc_gain ) >> 16;
+  if( base_band > SHRT_MAX ) base_band = SHRT_MAX;
+  if( base_band < SHRT_MIN ) base_band = SHRT_MIN;
+  *signal_sample = (short)base_band;
+
+  /* Correct the frequency offset of the signal */
+  if( isFlagSet(AFC_ENABLE) ) Afc_Shift( signal_sample );
+
+  /* Decimate sample values for the DFT */
+  DFT_Input_Data( *signal_sample );
+
+  /* Control attenuators as needed */
+  if( adagc_level > att_up )
+    Perseus_Step_Attenuators( TRUE );
+  else if( adagc_level < att_down )
+    Perseus_Step_Attenuators( FALSE );
+  PERF_END( PERF_DEMOD_SSB );
+
+  return( TRUE );
+} /* Demodulate_SSB_Fixed() */
 
 /*----------------------------------------------------------------------*/
 
@@ -140,6 +557,13 @@ Demodulate_SSB( short *signal_sample )
   static filter_data_t demod_filter_data_i, demod_filter_data_q;
 
 
+  /* Replay the signal heard in standby first */
+  if( Standby_Replay(signal_sample) ) return( TRUE );
+
+  /* Integer demodulator for receivers without a fast FPU */
+  if( isFlagSet(FIXED_POINT) )
+    return( Demodulate_SSB_Fixed(signal_sample) );
+
   /* Initialize on first call */
   static gboolean init = TRUE;
   if( init )
@@ -200,8 +624,17 @@ Demodulate_SSB( short *signal_sample )
   /* Wait for new IQ data */
   if( iqd_buf_idx >= PERSEUS_BUFFER_LEN )
   {
-    /* Wait on DSP data to be ready for processing */
-    sem_wait( &pback_semaphore );
+    /* Take I/Q data from the recording replayed, else
+     * wait on DSP data to be ready for processing */
+    if( isFlagSet(FILE_SOURCE) )
+      Perseus_Replay_Buffer();
+    else
+      sem_wait( &pback_semaphore );
+
+    PERF_CAPTURE( demod_buf_time, PERSEUS_BUFFER_LEN );
+
+    /* Serve the other channels before filtering in place */
+    Perseus_Channelize();
 
     /* Demodulate filtered I/Q buffers */
     DSP_Filter( &demod_filter_data_i );
@@ -211,12 +644,14 @@ Demodulate_SSB( short *signal_sample )
   }
 
   /* Apply Weaver SSB demodulator method to get base band */
+  PERF_BEGIN( PERF_DEMOD_SSB );
   base_band =
     demod_buf_i[iqd_buf_idx] * sinf[itr] +
     demod_buf_q[iqd_buf_idx] * cosf[itr];
   itr++;
   if( itr >= trig_len ) itr = 0;
   iqd_buf_idx++;
+  PERF_SAMPLE();
 
   /* Apply audio derived AGC */
   /* Ratio of demodulated signal level to reference
@@ -236,11 +671,15 @@ Demodulate_SSB( short *signal_sample )
   /* Return demod output as short int */
   *signal_sample = (short)base_band;
 
+  /* Correct the frequency offset of the signal */
+  if( isFlagSet(AFC_ENABLE) ) Afc_Shift( signal_sample );
+
   /* Decimate sample values for the DFT */
   DFT_Input_Data( *signal_sample );
 
   /* Control attenuators as needed */
   Perseus_Attenuators( adagc_scale );
+  PERF_END( PERF_DEMOD_SSB );
 
   return( TRUE );
 } /* Demodulate_SSB() */
@@ -271,6 +710,10 @@ Perseus_Data_Cb( void *buf, int buf_size, void *extra )
   int buf_idx, idx;
 
 
+  /* Tee the I/Q samples to the recording */
+  if( isFlagSet(RECORD_SIGNAL) )
+    Record_IQ( samplebuf, buf_size );
+
   /* Initialize on first call */
   if( buffer_len == 0 )
   {
@@ -304,14 +747,24 @@ Perseus_Data_Cb( void *buf, int buf_size, void *extra )
     /* Copy local buffers to Perseus buffers in double form */
     if( count >= buffer_len )
     {
-      for( buf_idx = 0; buf_idx < buffer_len; buf_idx++ )
-      {
-        demod_buf_i[buf_idx] = (double)i_buf[iq_idx];
-        demod_buf_q[buf_idx] = (double)q_buf[iq_idx];
-        iq_idx++;
-        if( iq_idx >= buffer_len ) iq_idx = 0;
-      }
+      if( isFlagSet(FIXED_POINT) )
+        for( buf_idx = 0; buf_idx < buffer_len; buf_idx++ )
+        {
+          demod_fix_i[buf_idx] = i_buf[iq_idx] >> PERSEUS_FIXED_SHIFT;
+          demod_fix_q[buf_idx] = q_buf[iq_idx] >> PERSEUS_FIXED_SHIFT;
+          iq_idx++;
+          if( iq_idx >= buffer_len ) iq_idx = 0;
+        }
+      else
+        for( buf_idx = 0; buf_idx < buffer_len; buf_idx++ )
+        {
+          demod_buf_i[buf_idx] = (double)i_buf[iq_idx];
+          demod_buf_q[buf_idx] = (double)q_buf[iq_idx];
+          iq_idx++;
+          if( iq_idx >= buffer_len ) iq_idx = 0;
+        }
       count = 0;
+      demod_buf_time = Perf_Clock();
 
       /* Post to semaphore that DSP data is ready */
       int sval;
@@ -353,7 +806,7 @@ Perseus_Read_Async( void *arg )
   void
 Perseus_Set_Center_Frequency( int center_freq )
 {
-  if( isFlagSet(PERSEUS_INIT) )
+  if( isFlagSet(PERSEUS_INIT) && (descr != NULL) )
   {
     /* Offset designated frequency to carrier frequency */
     double freq = (double)( center_freq + WEFAX_CARRIER_OFFSET );
@@ -371,7 +824,7 @@ Perseus_Set_Center_Frequency( int center_freq )
       return;
     }
 
-  } /* if( isFlagSet(PERSEUS_INIT) ) */
+  } /* if( isFlagSet(PERSEUS_INIT) && (descr != NULL) ) */
 
 } /* Perseus_Set_Center_Frequency() */
 
@@ -387,14 +840,47 @@ Perseus_Close_Device( void )
   if( isFlagSet(PERSEUS_INIT) )
   {
     ClearFlag( PERSEUS_INIT );
-    perseus_stop_async_input( descr );
-    perseus_close( descr );
-    perseus_exit();
-    descr = NULL;
+    if( descr != NULL )
+    {
+      perseus_stop_async_input( descr );
+      Record_Source( 0, 0, 0 );
+      perseus_close( descr );
+      perseus_exit();
+      descr = NULL;
+    }
+    Channel_Close();
   }
 
 } /* Perseus_Close_Device() */
 
+/*----------------------------------------------------------------------*/
+
+/* Perseus_Buffers_Init()
+ *
+ * Allocates the demodulator's I/Q buffers and
+ * sets up channels of the channelizer, if any
+ */
+  static void
+Perseus_Buffers_Init( void )
+{
+  /* Allocate I/Q double buffers */
+  size_t req = (size_t)PERSEUS_BUFFER_LEN * sizeof(double);
+  if( demod_buf_i == NULL )
+    mem_alloc( (void **)&demod_buf_i, req );
+  if( demod_buf_q == NULL )
+    mem_alloc( (void **)&demod_buf_q, req );
+
+  /* Allocate I/Q integer buffers */
+  req = (size_t)PERSEUS_BUFFER_LEN * sizeof(int32_t);
+  if( demod_fix_i == NULL )
+    mem_alloc( (void **)&demod_fix_i, req );
+  if( demod_fix_q == NULL )
+    mem_alloc( (void **)&demod_fix_q, req );
+
+  /* Set up channels of the channelizer, if any */
+  Perseus_Channels_Init();
+} /* Perseus_Buffers_Init() */
+
 /*----------------------------------------------------------------------*/
 
   static void
@@ -421,6 +907,15 @@ Perseus_Initialize( void )
   /* Abort if already init */
   if( isFlagSet(PERSEUS_INIT) ) return( TRUE );
 
+  /* Replay a recording of I/Q samples in place of the receiver */
+  if( isFlagSet(FILE_SOURCE) )
+  {
+    Perseus_Buffers_Init();
+    Replay_Attach();
+    SetFlag( PERSEUS_INIT );
+    return( TRUE );
+  }
+
   /* Set debug info dumped to stderr
    * to the maximum verbose level */
   perseus_set_debug( PERSEUS_DEBUG_LEVEL );
@@ -520,12 +1015,11 @@ Perseus_Initialize( void )
     return( FALSE );
   }
 
-  /* Allocate I/Q double buffers */
-  size_t req = (size_t)PERSEUS_BUFFER_LEN * sizeof(double);
-  if( demod_buf_i == NULL )
-    mem_alloc( (void **)&demod_buf_i, req );
-  if( demod_buf_q == NULL )
-    mem_alloc( (void **)&demod_buf_q, req );
+  /* Demodulator buffers and channels */
+  Perseus_Buffers_Init();
+
+  /* Record the I/Q samples as received */
+  Record_Source( 2, 24, PERSEUS_SAMPLE_RATE );
 
   /* Init semaphore */
   sem_init( &pback_semaphore, 0, 0 );
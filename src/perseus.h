@@ -65,6 +65,45 @@
 #define ADAGC_REF_LEVEL     25000.0
 #define ADAGC_DECAY         0.99995
 
+/* For the fixed point demodulator, the ADAGC decay of the level
+ * and growth of the gain in Q32 (1 - 0.99995 and 1/0.99995 - 1),
+ * the maximum gain in Q16 and the right shift of the 32 bit
+ * I/Q samples that leaves headroom in the filter sections */
+#define ADAGC_DECAY_Q32     214748
+#define ADAGC_GROWTH_Q32    214759
+#define ADAGC_GAIN_MAX      ( (int64_t)ADAGC_REF_LEVEL << 16 )
+#define PERSEUS_FIXED_SHIFT 8
+
+/* Channels of the channelizer, served to other instances as
+ * channels from PERSEUS_FIRST_CHANNEL on, after the sound card's */
+#define PERSEUS_MAX_CHANNELS    6
+#define PERSEUS_FIRST_CHANNEL   2
+
+/* DSP rate the channels are decimated to and served at,
+ * one the detectors are specialized for */
+#define PERSEUS_CHANNEL_RATE    12000
+
+/* Largest offset of a channel from the tuned frequency,
+ * keeping its carrier and passband inside the DDC's */
+#define PERSEUS_MAX_OFFSET  ( PERSEUS_SAMPLE_RATE / 2 - \
+    WEFAX_CARRIER_OFFSET - 2 * (int)PERSEUS_DEMOD_BANDW )
+
+/* A channel of the channelizer, mixed down from its offset
+ * by an NCO, demodulated as in Demodulate_SSB() and
+ * decimated to PERSEUS_CHANNEL_RATE */
+typedef struct
+{
+  int offset;             /* Offset from tuned frequency, Hz */
+  double nco_re, nco_im;  /* NCO phasor and its step per sample */
+  double nco_step_re, nco_step_im;
+  double wvr_re, wvr_im;  /* Weaver phasor and its step per sample */
+  double wvr_step_re, wvr_step_im;
+  double adagc_scale;     /* ADAGC scale factor */
+  double *buf_i, *buf_q;  /* Mixed I/Q samples, filtered in place */
+  filter_data_t filter_i, filter_q;
+  resampler_t resampler;  /* Decimator of the demodulated signal */
+} perseus_chan_t;
+
 /* This union/struct is suggested in the Perseus API */
 typedef union data
 {
@@ -0,0 +1,434 @@
+/*
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License as
+ *  published by the Free Software Foundation; either version 2 of
+ *  the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details:
+ *
+ *  http://www.gnu.org/copyleft/gpl.txt
+ */
+
+#include "raw.h"
+#include "shared.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+
+/* State of the raw discriminator capture */
+static struct
+{
+  int fd;                 /* Descriptor of the raw file, -1 if closed */
+  raw_header_t *header;   /* Mapped raw file, NULL if closed */
+  size_t map_size;        /* Size of the mapping in bytes */
+  uint64_t capacity;      /* Zero crossing times the mapping can hold */
+
+  /* DSP samples taken by the detectors since the capture opened */
+  int64_t samples;
+
+  /* Name of the open or last raw file */
+  char file_name[ MAX_FILE_NAME ];
+
+} raw = { -1, NULL, 0, 0, 0, "" };
+
+/*------------------------------------------------------------------------*/
+
+/* Raw_Map_Size()
+ *
+ * Sizes the raw file to map_size and maps it
+ */
+  static gboolean
+Raw_Map_Size( size_t map_size )
+{
+  void *map;
+
+  if( ftruncate(raw.fd, (off_t)map_size) < 0 )
+    return( FALSE );
+  map = mmap( NULL, map_size, PROT_READ | PROT_WRITE,
+      MAP_SHARED, raw.fd, 0 );
+  if( map == MAP_FAILED )
+    return( FALSE );
+
+  raw.header   = map;
+  raw.map_size = map_size;
+  raw.capacity = (uint64_t)
+    ( (map_size - sizeof(raw_header_t)) / sizeof(uint64_t) );
+
+  return( TRUE );
+} /* Raw_Map_Size() */
+
+/*------------------------------------------------------------------------*/
+
+/* Raw_Open()
+ *
+ * Opens a raw file for the discriminator output of an image
+ * about to be decoded. Phase is the count of pixels from the
+ * start of the capture to the first pixel of the image
+ */
+  gboolean
+Raw_Open( char *file_name, double phase )
+{
+  raw_header_t *header;
+
+  Raw_Close();
+
+  Strlcpy( raw.file_name, file_name, sizeof(raw.file_name) );
+  raw.fd = open( file_name, O_RDWR | O_CREAT | O_TRUNC, 0644 );
+  if( (raw.fd < 0) || !Raw_Map_Size(RAW_MAP_CHUNK) )
+  {
+    perror( file_name );
+    Show_Message( _("Failed to open raw file"), "red" );
+    if( raw.fd >= 0 ) close( raw.fd );
+    raw.fd = -1;
+    return( FALSE );
+  }
+
+  /* Mode of the decode, kept as defaults for re-rendering */
+  header = raw.header;
+  memcpy( header->magic, RAW_MAGIC, RAW_MAGIC_LEN );
+  header->dsp_rate        = rc_data.dsp_rate;
+  header->pixels_per_line = rc_data.pixels_per_line;
+  header->image_enhance   = rc_data.image_enhance;
+  header->time_shift      = RAW_TIME_SHIFT;
+  header->lines_per_min   = rc_data.lines_per_min;
+  header->sync_slant      = rc_data.sync_slant;
+  header->phase           = phase;
+  header->count           = 0;
+
+  raw.samples = 0;
+
+  return( TRUE );
+} /* Raw_Open() */
+
+/*------------------------------------------------------------------------*/
+
+/* Raw_Advance()
+ *
+ * Counts the DSP samples taken by a detector for a pixel
+ */
+  void
+Raw_Advance( int samples )
+{
+  raw.samples += samples;
+
+} /* Raw_Advance() */
+
+/*------------------------------------------------------------------------*/
+
+/* Raw_Crossing()
+ *
+ * Records a zero crossing of the signal, at time DSP
+ * samples from the start of the current detector pixel
+ */
+  void
+Raw_Crossing( double time )
+{
+  raw_header_t *header = raw.header;
+  double crossing;
+
+  if( header == NULL ) return;
+
+  /* Crossing time from the capture start in Q4 samples */
+  crossing = ( (double)raw.samples + time ) * RAW_TIME_ONE + 0.5;
+  if( crossing < 0.0 ) crossing = 0.0;
+
+  /* Grow the raw file when full, closing it on failure */
+  if( header->count >= raw.capacity )
+  {
+    uint64_t count = header->count;
+
+    munmap( header, raw.map_size );
+    raw.header = NULL;
+    if( !Raw_Map_Size(raw.map_size + RAW_MAP_CHUNK) )
+    {
+      Show_Message( _("Failed to extend raw file"), "red" );
+      close( raw.fd );
+      raw.fd = -1;
+      return;
+    }
+    header = raw.header;
+    header->count = count;
+  }
+
+  ( (uint64_t *)(header + 1) )[ header->count++ ] = (uint64_t)crossing;
+
+} /* Raw_Crossing() */
+
+/*------------------------------------------------------------------------*/
+
+/* Raw_Close()
+ *
+ * Trims the raw file to the zero crossings recorded and closes it
+ */
+  void
+Raw_Close( void )
+{
+  size_t size;
+
+  if( raw.header == NULL ) return;
+
+  size = sizeof(raw_header_t) +
+    (size_t)raw.header->count * sizeof(uint64_t);
+  munmap( raw.header, raw.map_size );
+  raw.header = NULL;
+  if( ftruncate(raw.fd, (off_t)size) < 0 )
+    perror( "xwefax: Error trimming raw file" );
+  close( raw.fd );
+  raw.fd = -1;
+
+} /* Raw_Close() */
+
+/*------------------------------------------------------------------------*/
+
+/* Raw_File_Name()
+ *
+ * Returns the name of the open or last raw file
+ */
+  const char *
+Raw_File_Name( void )
+{
+  return( raw.file_name );
+} /* Raw_File_Name() */
+
+/*------------------------------------------------------------------------*/
+
+/* Raw_Enhance()
+ *
+ * Applies an image enhancement to a re-rendered image
+ */
+  static void
+Raw_Enhance( unsigned char *image, int width, int lines, int image_enhance )
+{
+  int line, idx;
+
+  switch( image_enhance )
+  {
+    case ENHANCE_CONTRAST: /* Leave behind the pixels of phasing pulse */
+      for( line = 0; line < lines; line++ )
+        Normalize( &image[line * width + PHASING_PULSE_LEN],
+            width - PHASING_PULSE_LEN );
+      break;
+
+    case ENHANCE_BILEVEL:
+      for( idx = 0; idx < width * lines; idx++ )
+        image[idx] = ( image[idx] > BILEVEL_THRESHOLD ) ? 255 : 0;
+      break;
+
+    case ENHANCE_ADAPTIVE: /* On a full queue, drain it and queue again */
+      Enhance_Reset();
+      for( line = 0; line < lines; line++ )
+        if( !Enhance_Put_Line(&image[line * width], width, line) )
+        {
+          Enhance_Flush();
+          while( Enhance_Get_Line(image, width, &idx) );
+          Enhance_Put_Line( &image[line * width], width, line );
+        }
+      Enhance_Flush();
+      while( Enhance_Get_Line(image, width, &idx) );
+      break;
+  }
+
+} /* Raw_Enhance() */
+
+/*------------------------------------------------------------------------*/
+
+/* Raw_Render()
+ *
+ * Renders an image from the zero crossings of a raw file, with
+ * the given sync slant and phase offset in pixels, and image
+ * enhancement. A NAN slant or a negative enhancement select
+ * those of the capture. The crossings are resampled to the new
+ * pixel grid as the detector does, the frequency of a pixel
+ * being that of the half cycles ending in it
+ */
+  gboolean
+Raw_Render( const char *file_name, double sync_slant, double phase,
+    int image_enhance, unsigned char **image, int *width, int *lines )
+{
+  const raw_header_t *header;
+  const uint64_t *times;
+  struct stat st;
+  size_t size;
+  double pixel_len, pixel_end, signal_freq, discrim_output;
+  uint64_t idx, first = 0, last = 0, crossings, count;
+  int fd, pixel, num_zeros;
+
+  /* Map the raw file and check its header */
+  fd = open( file_name, O_RDONLY );
+  if( fd < 0 )
+  {
+    perror( file_name );
+    return( FALSE );
+  }
+  if( (fstat(fd, &st) < 0) || (st.st_size < (off_t)sizeof(raw_header_t)) )
+  {
+    fprintf( stderr, "xwefax: %s: not a raw file\n", file_name );
+    close( fd );
+    return( FALSE );
+  }
+  size = (size_t)st.st_size;
+  header = mmap( NULL, size, PROT_READ, MAP_PRIVATE, fd, 0 );
+  close( fd );
+  if( header == MAP_FAILED )
+  {
+    perror( file_name );
+    return( FALSE );
+  }
+  times = (const uint64_t *)( header + 1 );
+  if( memcmp(header->magic, RAW_MAGIC, RAW_MAGIC_LEN) ||
+      (header->time_shift != RAW_TIME_SHIFT) ||
+      (header->dsp_rate <= 0) || (header->lines_per_min <= 0.0) ||
+      (header->pixels_per_line <= PHASING_PULSE_LEN) ||
+      (header->count < 2) )
+  {
+    fprintf( stderr, "xwefax: %s: not a raw file\n", file_name );
+    munmap( (void *)header, size );
+    return( FALSE );
+  }
+
+  /* A file cut short keeps the crossings it holds */
+  count = (uint64_t)( (size - sizeof(raw_header_t)) / sizeof(uint64_t) );
+  if( count < header->count )
+    fprintf( stderr, "xwefax: %s: truncated, %llu of %llu crossings\n",
+        file_name, (unsigned long long)count,
+        (unsigned long long)header->count );
+  else count = header->count;
+  if( count < 2 )
+  {
+    munmap( (void *)header, size );
+    return( FALSE );
+  }
+
+  /* Settings of the capture, unless given */
+  if( isnan(sync_slant) ) sync_slant = header->sync_slant;
+  if( image_enhance < 0 ) image_enhance = header->image_enhance;
+  phase += header->phase;
+
+  /* Pixel length in Q4 samples, as in Set_Pixel_Len() */
+  pixel_len = (double)header->dsp_rate * 60.0 / header->lines_per_min;
+  pixel_len /= (double)header->pixels_per_line + sync_slant;
+  pixel_len *= RAW_TIME_ONE;
+
+  /* Whole lines up to the last zero crossing */
+  *width = header->pixels_per_line;
+  *lines = (int)( ((double)times[count - 1] / pixel_len - phase) /
+      (double)header->pixels_per_line );
+  if( (pixel_len <= 0.0) || (*lines <= 0) )
+  {
+    fprintf( stderr, "xwefax: %s: no image lines\n", file_name );
+    munmap( (void *)header, size );
+    return( FALSE );
+  }
+  if( !mem_alloc((void **)image, (size_t)(*width * *lines)) )
+  {
+    munmap( (void *)header, size );
+    return( FALSE );
+  }
+
+  /* Resample the crossings to the pixels of the image */
+  idx = 0;
+  crossings   = 0;
+  signal_freq = 0.0;
+  for( pixel = 0; pixel < *width * *lines; pixel++ )
+  {
+    pixel_end = ( (double)(pixel + 1) + phase ) * pixel_len;
+    num_zeros = 0;
+    while( (idx < count) && ((double)times[idx] < pixel_end) )
+    {
+      if( !crossings++ ) first = times[ idx ];
+      last = times[ idx++ ];
+      num_zeros++;
+    }
+
+    /* Frequency from the half cycles ending in the pixel,
+     * the first crossing only marks the start of the first */
+    if( num_zeros && (crossings > 1) )
+    {
+      if( crossings == (uint64_t)num_zeros ) num_zeros--;
+      signal_freq = (double)( header->dsp_rate / 2 ) * RAW_TIME_ONE *
+        (double)num_zeros / (double)( last - first );
+      first = last;
+    }
+    else if( num_zeros ) first = last;
+
+    // Scale and floor frequency to give a value 0-255
+    discrim_output = signal_freq / DISCR_SCALE - DISCR_FLOOR;
+    if( discrim_output > 255.0 ) discrim_output = 255.0;
+    if( discrim_output < 0.0 )   discrim_output = 0.0;
+    (*image)[ pixel ] = (unsigned char)discrim_output;
+  }
+  munmap( (void *)header, size );
+
+  Raw_Enhance( *image, *width, *lines, image_enhance );
+
+  return( TRUE );
+} /* Raw_Render() */
+
+/*------------------------------------------------------------------------*/
+
+/* Raw_Render_Run()
+ *
+ * Re-renders the image of a raw file to a PGM file next to it.
+ * The argument is the raw file name, optionally followed by the
+ * sync slant, phase offset and enhancement, separated by commas
+ */
+  int
+Raw_Render_Run( char *arg )
+{
+  char file_name[ MAX_FILE_NAME ];
+  char *raw_file, *field;
+  double sync_slant = NAN, phase = 0.0;
+  int image_enhance = -1, width, lines, len;
+  unsigned char *image = NULL;
+  struct timespec start, end;
+  FILE *fp;
+
+  SetFlag( HEADLESS );
+
+  /* Raw file name and the optional settings, empty if skipped */
+  raw_file = strsep( &arg, "," );
+  if( (field = strsep(&arg, ",")) && *field )
+    sync_slant = atof( field );
+  if( (field = strsep(&arg, ",")) && *field )
+    phase = atof( field );
+  if( (field = strsep(&arg, ",")) && *field )
+    image_enhance = atoi( field );
+
+  clock_gettime( CLOCK_MONOTONIC, &start );
+  if( !Raw_Render(raw_file, sync_slant, phase,
+        image_enhance, &image, &width, &lines) )
+    return( 1 );
+  clock_gettime( CLOCK_MONOTONIC, &end );
+
+  /* Replace the .raw extension with .pgm */
+  Strlcpy( file_name, raw_file, sizeof(file_name) - 4 );
+  len = (int)strlen( file_name );
+  if( (len > 4) && (strcmp(&file_name[len - 4], ".raw") == 0) )
+    file_name[ len - 4 ] = '\0';
+  Strlcat( file_name, ".pgm", sizeof(file_name) );
+
+  if( (fp = fopen(file_name, "w")) == NULL )
+  {
+    perror( file_name );
+    free_ptr( (void **)&image );
+    return( 1 );
+  }
+  if( !Save_Image_PGM(fp, "P5", width, lines, 255, image) )
+  {
+    free_ptr( (void **)&image );
+    return( 1 );
+  }
+  free_ptr( (void **)&image );
+
+  printf( "%s: %d lines rendered in %.1f ms\n", file_name, lines,
+      (double)(end.tv_sec - start.tv_sec) * 1000.0 +
+      (double)(end.tv_nsec - start.tv_nsec) / 1.0e6 );
+
+  return( 0 );
+} /* Raw_Render_Run() */
+
+/*------------------------------------------------------------------------*/
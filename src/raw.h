@@ -0,0 +1,52 @@
+/*
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License as
+ *  published by the Free Software Foundation; either version 2 of
+ *  the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details:
+ *
+ *  http://www.gnu.org/copyleft/gpl.txt
+ */
+
+#ifndef RAW_H
+#define RAW_H   1
+
+#include "common.h"
+#include "detect.h"
+
+/* Identifies a raw discriminator file and its format version */
+#define RAW_MAGIC       "XWEFAXD2"
+#define RAW_MAGIC_LEN   8
+
+/* Zero crossing times are kept in Q4 DSP samples */
+#define RAW_TIME_SHIFT  4
+#define RAW_TIME_ONE    ( 1 << RAW_TIME_SHIFT )
+
+/* The mapped raw file is grown in steps of this size */
+#define RAW_MAP_CHUNK   1048576
+
+/* Header of a raw discriminator file. It is followed by the times
+ * of the zero crossings of the signal, as seen by the zero crossing
+ * detector, from the start of the image decode in Q4 DSP samples.
+ * The times are 64 bit, as 32 bits overflow in about 36 minutes of
+ * a 125 kHz capture */
+typedef struct
+{
+  char magic[ RAW_MAGIC_LEN ];
+  int32_t
+    dsp_rate,         /* DSP sample rate of the capture */
+    pixels_per_line,  /* Image resolution in pixels/line */
+    image_enhance,    /* Image enhancement of the decode */
+    time_shift;       /* Fixed point shift of crossing times */
+  double
+    lines_per_min,    /* Lines per minute of the capture */
+    sync_slant,       /* Sync slant correction at start, pix/line */
+    phase;            /* Pixels from capture start to image start */
+  uint64_t count;     /* Count of zero crossing times */
+} raw_header_t;
+
+#endif
@@ -0,0 +1,579 @@
+/*
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License as
+ *  published by the Free Software Foundation; either version 2 of
+ *  the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details:
+ *
+ *  http://www.gnu.org/copyleft/gpl.txt
+ */
+
+#include "record.h"
+#include "shared.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <time.h>
+
+/* Guards the recording file, taken by the writer thread
+ * and by the GUI as it starts and stops a recording */
+static pthread_mutex_t record_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Posted to the writer thread when a block of samples is buffered */
+static sem_t record_semaphore;
+
+/* State of the signal recorder. The capture thread puts samples into
+ * the ring and advances head, the writer thread writes them to the
+ * file and advances tail, so the capture never waits for the disk */
+static struct
+{
+  uint8_t *ring;          /* Ring buffer of samples, page aligned */
+  atomic_uint_fast64_t
+    head,                 /* Count of bytes put into the ring */
+    tail,                 /* Count of bytes written to the file */
+    rotate_at;            /* Head at which to start a new file */
+  atomic_uint overruns;   /* Blocks dropped on a full ring */
+
+  /* Rotation mode and 16 bit packing of Perseus I/Q */
+  int mode;
+  gboolean iq16;
+
+  /* Format of the signal source, no rate if closed */
+  int channels, src_bits, rate;
+
+  /* Bits per sample recorded */
+  int bits;
+
+  /* Recording file, its data size and UTC hour of opening */
+  int fd;
+  uint32_t data_size;
+  int hour;
+  char file_name[ MAX_FILE_NAME ];
+
+} record = { .fd = -1, .mode = RECORD_OFF };
+
+/*------------------------------------------------------------------------*/
+
+/* Record_Message_Idle_Cb()
+ *
+ * Shows a message of the writer thread in the GUI
+ */
+  static gboolean
+Record_Message_Idle_Cb( gpointer data )
+{
+  Show_Message( (char *)data, "black" );
+  g_free( data );
+  return( FALSE );
+} /* Record_Message_Idle_Cb() */
+
+/*------------------------------------------------------------------------*/
+
+/* Record_WAV_Header()
+ *
+ * Fills in the canonical header of a PCM WAV file
+ */
+  void
+Record_WAV_Header(
+    wav_header_t *header, int channels, int bits, int rate,
+    uint32_t data_size )
+{
+  int frame = channels * bits / 8;
+
+  memcpy( header->riff, "RIFF", 4 );
+  memcpy( header->wave, "WAVE", 4 );
+  memcpy( header->fmt,  "fmt ", 4 );
+  memcpy( header->data, "data", 4 );
+  header->riff_size   = data_size + sizeof(wav_header_t) - 8;
+  header->fmt_size    = 16;
+  header->format      = 1;
+  header->channels    = (uint16_t)channels;
+  header->sample_rate = (uint32_t)rate;
+  header->byte_rate   = (uint32_t)( rate * frame );
+  header->block_align = (uint16_t)frame;
+  header->bits        = (uint16_t)bits;
+  header->data_size   = data_size;
+
+} /* Record_WAV_Header() */
+
+/*------------------------------------------------------------------------*/
+
+/* Record_Header()
+ *
+ * Writes the WAV header of the recording with its current data size
+ */
+  static void
+Record_Header( void )
+{
+  wav_header_t header;
+
+  Record_WAV_Header( &header, record.channels,
+      record.bits, record.rate, record.data_size );
+  if( pwrite(record.fd, &header, sizeof(header), 0) !=
+      (ssize_t)sizeof(header) )
+    perror( record.file_name );
+
+} /* Record_Header() */
+
+/*------------------------------------------------------------------------*/
+
+/* Record_Open_File()
+ *
+ * Opens a new recording file named by the UTC date and time
+ */
+  static gboolean
+Record_Open_File( void )
+{
+  time_t tp;
+  struct tm utc;
+  int len, idx;
+
+
+  /* Recordings are kept in the record/ directory */
+  Strlcpy( record.file_name, rc_data.xwefax_dir, MAX_FILE_NAME - 40 );
+  Strlcat( record.file_name, "record", sizeof(record.file_name) );
+  mkdir( record.file_name, 0755 );
+
+  time( &tp );
+  gmtime_r( &tp, &utc );
+  len = (int)strlen( record.file_name );
+  len += (int)strftime(
+      &record.file_name[len], 24, "/%d%b%Y-%H%M%Sz", &utc );
+  record.hour = utc.tm_hour;
+
+  /* Number the file if one was opened in the same second */
+  for( idx = 0; idx < 10; idx++ )
+  {
+    if( idx )
+      snprintf( &record.file_name[len], 8, "-%d.wav", idx );
+    else
+      Strlcpy( &record.file_name[len], ".wav", 8 );
+    record.fd = open( record.file_name,
+        O_WRONLY | O_CREAT | O_EXCL, 0644 );
+    if( (record.fd >= 0) || (errno != EEXIST) ) break;
+  }
+  if( record.fd < 0 )
+  {
+    perror( record.file_name );
+    return( FALSE );
+  }
+
+  record.data_size = 0;
+  Record_Header();
+  if( lseek(record.fd, sizeof(wav_header_t), SEEK_SET) < 0 )
+  {
+    perror( record.file_name );
+    close( record.fd );
+    record.fd = -1;
+    return( FALSE );
+  }
+
+  return( TRUE );
+} /* Record_Open_File() */
+
+/*------------------------------------------------------------------------*/
+
+/* Record_Close_File()
+ *
+ * Completes the WAV header of the recording and closes it
+ */
+  static void
+Record_Close_File( void )
+{
+  if( record.fd < 0 ) return;
+  Record_Header();
+  close( record.fd );
+  record.fd = -1;
+} /* Record_Close_File() */
+
+/*------------------------------------------------------------------------*/
+
+/* Record_Write()
+ *
+ * Writes the samples in the ring up to count end to the file.
+ * On a write error the recording is stopped
+ */
+  static void
+Record_Write( uint64_t end )
+{
+  uint64_t tail;
+  size_t offset, len;
+  ssize_t ret;
+
+
+  tail = atomic_load_explicit( &record.tail, memory_order_relaxed );
+  while( (record.fd >= 0) && (tail < end) )
+  {
+    offset = (size_t)( tail & RECORD_RING_MASK );
+    len    = (size_t)( end - tail );
+    if( len > RECORD_RING_SIZE - offset )
+      len = RECORD_RING_SIZE - offset;
+
+    ret = write( record.fd, &record.ring[offset], len );
+    if( ret < 0 )
+    {
+      if( errno == EINTR ) continue;
+      perror( record.file_name );
+      ClearFlag( RECORD_SIGNAL );
+      Record_Close_File();
+      g_idle_add( Record_Message_Idle_Cb,
+          g_strdup(_("Recording stopped on write error")) );
+      tail = end;
+      break;
+    }
+
+    tail += (uint64_t)ret;
+    record.data_size += (uint32_t)ret;
+  } /* while( (record.fd >= 0) && (tail < end) ) */
+
+  /* Release the written space to the capture thread */
+  atomic_store_explicit( &record.tail, tail, memory_order_release );
+
+} /* Record_Write() */
+
+/*------------------------------------------------------------------------*/
+
+/* Record_Rotate()
+ *
+ * Closes the recording and continues in a new file
+ */
+  static void
+Record_Rotate( void )
+{
+  char mesg[ MESG_SIZE ];
+
+  Record_Close_File();
+  if( Record_Open_File() )
+    snprintf( mesg, sizeof(mesg), _("Recording to %s"), record.file_name );
+  else
+  {
+    ClearFlag( RECORD_SIGNAL );
+    snprintf( mesg, sizeof(mesg), _("Failed to open %s"), record.file_name );
+  }
+  g_idle_add( Record_Message_Idle_Cb, g_strdup(mesg) );
+
+} /* Record_Rotate() */
+
+/*------------------------------------------------------------------------*/
+
+/* Record_Writer()
+ *
+ * Writer thread that writes the buffered samples to the recording,
+ * rotating it at the end of a chart, on the hour or before it grows
+ * too large. It is woken up when a block is buffered or periodically
+ */
+  static void *
+Record_Writer( void *data )
+{
+  struct timespec ts;
+  struct tm utc;
+  time_t tp;
+  uint64_t head, rotate;
+
+
+  while( TRUE )
+  {
+    clock_gettime( CLOCK_REALTIME, &ts );
+    ts.tv_nsec += RECORD_FLUSH_MSEC * 1000000L;
+    if( ts.tv_nsec >= 1000000000L )
+    {
+      ts.tv_sec++;
+      ts.tv_nsec -= 1000000000L;
+    }
+    sem_timedwait( &record_semaphore, &ts );
+
+    pthread_mutex_lock( &record_lock );
+    if( record.fd < 0 )
+    {
+      pthread_mutex_unlock( &record_lock );
+      continue;
+    }
+
+    head = atomic_load_explicit( &record.head, memory_order_acquire );
+
+    /* Start a new file where the last chart ended */
+    rotate = atomic_exchange_explicit(
+        &record.rotate_at, RECORD_NO_ROTATE, memory_order_acq_rel );
+    if( rotate <= head )
+    {
+      Record_Write( rotate );
+      if( record.fd >= 0 ) Record_Rotate();
+    }
+    Record_Write( head );
+
+    /* Start a new file on the hour or before it grows too large */
+    time( &tp );
+    gmtime_r( &tp, &utc );
+    if( (record.fd >= 0) &&
+        (((record.mode == RECORD_HOURLY) && (utc.tm_hour != record.hour)) ||
+         (record.data_size >= RECORD_MAX_DATA)) )
+      Record_Rotate();
+
+    /* Keep the header valid if xwefax is killed */
+    if( record.fd >= 0 ) Record_Header();
+
+    pthread_mutex_unlock( &record_lock );
+  } /* while( TRUE ) */
+
+  return( NULL );
+} /* Record_Writer() */
+
+/*------------------------------------------------------------------------*/
+
+/* Record_Put()
+ *
+ * Puts a block of samples into the ring. If the writer thread has
+ * fallen behind and the ring is full, the block is dropped
+ */
+  static void
+Record_Put( const void *data, size_t size )
+{
+  const uint8_t *src = (const uint8_t *)data;
+  uint64_t head, tail;
+  size_t offset, first;
+  int sval;
+
+
+  head = atomic_load_explicit( &record.head, memory_order_relaxed );
+  tail = atomic_load_explicit( &record.tail, memory_order_acquire );
+  if( head - tail + size > RECORD_RING_SIZE )
+  {
+    atomic_fetch_add_explicit( &record.overruns, 1, memory_order_relaxed );
+    return;
+  }
+
+  offset = (size_t)( head & RECORD_RING_MASK );
+  first  = RECORD_RING_SIZE - offset;
+  if( first > size ) first = size;
+  memcpy( &record.ring[offset], src, first );
+  memcpy( record.ring, &src[first], size - first );
+  head += size;
+  atomic_store_explicit( &record.head, head, memory_order_release );
+
+  /* Wake up the writer thread when a block is buffered */
+  if( head - tail >= RECORD_WRITE_SIZE )
+  {
+    sem_getvalue( &record_semaphore, &sval );
+    if( !sval ) sem_post( &record_semaphore );
+  }
+
+} /* Record_Put() */
+
+/*------------------------------------------------------------------------*/
+
+/* Record_Samples()
+ *
+ * Tees a block of audio samples, as taken by the decoder, to the recording
+ */
+  void
+Record_Samples( const short *samples, int count )
+{
+  PERF_BEGIN( PERF_RECORD );
+  Record_Put( samples, (size_t)count * sizeof(short) );
+  PERF_END( PERF_RECORD );
+} /* Record_Samples() */
+
+/*------------------------------------------------------------------------*/
+
+/* Record_IQ()
+ *
+ * Tees a buffer of 24 bit Perseus I/Q samples to the recording, as they
+ * are or packed to 16 bits. Both are little endian as in a WAV file
+ */
+  void
+Record_IQ( const uint8_t *buf, int size )
+{
+  uint8_t pack[ RECORD_IQ16_CHUNK * 4 ];
+  int idx, len;
+
+
+  PERF_BEGIN( PERF_RECORD );
+  if( record.bits == 24 )
+    Record_Put( buf, (size_t)size );
+  else
+  {
+    /* Keep the two high bytes of I and of Q */
+    size /= 6;
+    while( size > 0 )
+    {
+      len = size < RECORD_IQ16_CHUNK ? size : RECORD_IQ16_CHUNK;
+      for( idx = 0; idx < len; idx++ )
+      {
+        pack[4 * idx]     = buf[1];
+        pack[4 * idx + 1] = buf[2];
+        pack[4 * idx + 2] = buf[4];
+        pack[4 * idx + 3] = buf[5];
+        buf += 6;
+      }
+      Record_Put( pack, (size_t)len * 4 );
+      size -= len;
+    }
+  }
+  PERF_END( PERF_RECORD );
+
+} /* Record_IQ() */
+
+/*------------------------------------------------------------------------*/
+
+/* Record_Begin()
+ *
+ * Starts recording the open signal source, starting
+ * the writer thread and its ring buffer on first call
+ */
+  static void
+Record_Begin( void )
+{
+  static gboolean first_call = TRUE;
+  pthread_t pthread_id;
+  char mesg[ MESG_SIZE ];
+
+
+  if( first_call )
+  {
+    if( posix_memalign((void **)&record.ring,
+          RECORD_ALIGN, RECORD_RING_SIZE) != 0 )
+    {
+      Show_Message( _("Memory allocation failed - Quit"), "red" );
+      Error_Dialog( _("Memory allocation failed - Quit"), QUIT );
+      return;
+    }
+    atomic_init( &record.rotate_at, RECORD_NO_ROTATE );
+
+    sem_init( &record_semaphore, 0, 0 );
+    if( pthread_create(&pthread_id, NULL, Record_Writer, NULL) != 0 )
+    {
+      Show_Message( _("Failed to create recorder thread"), "red" );
+      Error_Dialog( _("Failed to create recorder thread"), QUIT );
+      return;
+    }
+    pthread_detach( pthread_id );
+    first_call = FALSE;
+  } /* if( first_call ) */
+
+  pthread_mutex_lock( &record_lock );
+
+  /* Perseus I/Q is 24 bit, or packed to 16 bit */
+  record.bits = record.src_bits;
+  if( (record.src_bits == 24) && record.iq16 )
+    record.bits = 16;
+
+  /* Drop anything left in the ring from a past recording */
+  atomic_store_explicit( &record.tail,
+      atomic_load_explicit(&record.head, memory_order_acquire),
+      memory_order_release );
+  atomic_store_explicit( &record.rotate_at,
+      RECORD_NO_ROTATE, memory_order_relaxed );
+  atomic_store_explicit( &record.overruns, 0, memory_order_relaxed );
+
+  if( Record_Open_File() )
+  {
+    SetFlag( RECORD_SIGNAL );
+    snprintf( mesg, sizeof(mesg), _("Recording to %s"), record.file_name );
+    Show_Message( mesg, "green" );
+  }
+  else
+  {
+    snprintf( mesg, sizeof(mesg), _("Failed to open %s"), record.file_name );
+    Show_Message( mesg, "red" );
+  }
+
+  pthread_mutex_unlock( &record_lock );
+
+} /* Record_Begin() */
+
+/*------------------------------------------------------------------------*/
+
+/* Record_Stop()
+ *
+ * Stops recording, writing out the samples still in the ring
+ */
+  static void
+Record_Stop( void )
+{
+  char mesg[ MESG_SIZE ];
+  unsigned int overruns;
+
+
+  ClearFlag( RECORD_SIGNAL );
+
+  pthread_mutex_lock( &record_lock );
+  if( record.fd < 0 )
+  {
+    pthread_mutex_unlock( &record_lock );
+    return;
+  }
+  Record_Write( atomic_load_explicit(&record.head, memory_order_acquire) );
+  Record_Close_File();
+  pthread_mutex_unlock( &record_lock );
+
+  overruns = atomic_load_explicit( &record.overruns, memory_order_relaxed );
+  if( overruns && isFlagClear(XWEFAX_QUIT) )
+  {
+    snprintf( mesg, sizeof(mesg),
+        _("Recording dropped %u blocks of samples"), overruns );
+    Show_Message( mesg, "orange" );
+  }
+
+} /* Record_Stop() */
+
+/*------------------------------------------------------------------------*/
+
+/* Record_Source()
+ *
+ * Sets the format of the signal source as it is opened, which starts
+ * a recording if enabled, or stops the recording as it is closed
+ * (rate 0). Sound card audio is 1 channel of 16 bits, Perseus I/Q
+ * 2 channels of 24 bits
+ */
+  void
+Record_Source( int channels, int bits, int rate )
+{
+  Record_Stop();
+  record.channels = channels;
+  record.src_bits = bits;
+  record.rate     = rate;
+  if( rate && (record.mode != RECORD_OFF) ) Record_Begin();
+} /* Record_Source() */
+
+/*------------------------------------------------------------------------*/
+
+/* Record_Mode()
+ *
+ * Sets the rotation of recordings, starting
+ * or stopping recording of an open source
+ */
+  void
+Record_Mode( int mode, gboolean iq16 )
+{
+  if( (mode == record.mode) && (iq16 == record.iq16) ) return;
+
+  Record_Stop();
+  record.mode = mode;
+  record.iq16 = iq16;
+  if( record.rate && (record.mode != RECORD_OFF) ) Record_Begin();
+} /* Record_Mode() */
+
+/*------------------------------------------------------------------------*/
+
+/* Record_Chart()
+ *
+ * Marks the end of a chart, where a recording
+ * rotated by chart is continued in a new file
+ */
+  void
+Record_Chart( void )
+{
+  if( isFlagClear(RECORD_SIGNAL) || (record.mode != RECORD_BY_CHART) )
+    return;
+
+  atomic_store_explicit( &record.rotate_at,
+      atomic_load_explicit(&record.head, memory_order_acquire),
+      memory_order_release );
+  sem_post( &record_semaphore );
+
+} /* Record_Chart() */
+
+/*------------------------------------------------------------------------*/
@@ -0,0 +1,53 @@
+/*
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License as
+ *  published by the Free Software Foundation; either version 2 of
+ *  the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details:
+ *
+ *  http://www.gnu.org/copyleft/gpl.txt
+ */
+
+#ifndef RECORD_H
+#define RECORD_H    1
+
+#include "common.h"
+#include <stdatomic.h>
+
+/* Size of the recorder's ring buffer in bytes, a power of 2. It
+ * holds about 11 sec of 24 bit Perseus I/Q to ride out disk stalls */
+#define RECORD_RING_SIZE    8388608
+#define RECORD_RING_MASK    ( RECORD_RING_SIZE - 1 )
+
+/* Alignment of the ring buffer, a memory page */
+#define RECORD_ALIGN        4096
+
+/* The writer thread is woken up when this many bytes are
+ * buffered, else it writes out what is buffered periodically */
+#define RECORD_WRITE_SIZE   262144
+#define RECORD_FLUSH_MSEC   500
+
+/* A recording is rotated before its data grows past
+ * this size, keeping it inside the 4 GiB WAV limit */
+#define RECORD_MAX_DATA     0xF0000000u
+
+/* Perseus I/Q samples packed to 16 bit at a time */
+#define RECORD_IQ16_CHUNK   1024
+
+/* No rotation of the recording pending */
+#define RECORD_NO_ROTATE    UINT64_MAX
+
+/* Rotation of recordings, Off stops recording */
+enum
+{
+  RECORD_OFF = 0,
+  RECORD_BY_CHART,
+  RECORD_HOURLY,
+  NUM_REC
+};
+
+#endif
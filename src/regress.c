@@ -0,0 +1,656 @@
+/*
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License as
+ *  published by the Free Software Foundation; either version 2 of
+ *  the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details:
+ *
+ *  http://www.gnu.org/copyleft/gpl.txt
+ */
+#include "regress.h"
+#include "shared.h"
+#include <ctype.h>
+#include <sys/stat.h>
+
+/*------------------------------------------------------------------------*/
+
+/* Regress_Synth()
+ *
+ * Starts the transmission of a regression case
+ */
+  static void
+Regress_Synth( const regress_case_t *cas )
+{
+  synth_params_t params;
+
+  params.sample_rate     = rc_data.dsp_rate;
+  params.pixels_per_line = rc_data.pixels_per_line;
+  params.ioc_value       = rc_data.ioc_value;
+  params.black_freq      = rc_data.black_freq;
+  params.white_freq      = rc_data.white_freq;
+  params.phasing_lines   = rc_data.phasing_lines;
+  params.image_lines     = REGRESS_LINES;
+  params.lines_per_min   = rc_data.lines_per_min;
+  params.pattern         = cas->pattern;
+  params.snr         = cas->noisy ? REGRESS_NOISY_SNR    : SYNTH_NO_NOISE;
+  params.fade_freq   = cas->noisy ? REGRESS_NOISY_FADE   : 0.0;
+  params.freq_offset = cas->noisy ? REGRESS_NOISY_OFFSET : 0.0;
+  params.clock_error = cas->clock_error;
+  if( cas->afc ) params.freq_offset = REGRESS_AFC_OFFSET;
+
+  Synth_Init( &params );
+} /* Regress_Synth() */
+
+/*------------------------------------------------------------------------*/
+
+/* Regress_PGM_Value()
+ *
+ * Reads a number from a PGM file header, skipping comments
+ */
+  static gboolean
+Regress_PGM_Value( FILE *fp, int *value )
+{
+  int chr;
+
+  while( (chr = fgetc(fp)) != EOF )
+  {
+    if( chr == '#' )
+    {
+      while( ((chr = fgetc(fp)) != EOF) && (chr != '\n') );
+    }
+    else if( !isspace(chr) )
+    {
+      ungetc( chr, fp );
+      return( fscanf(fp, "%d", value) == 1 );
+    }
+  }
+
+  return( FALSE );
+} /* Regress_PGM_Value() */
+
+/*------------------------------------------------------------------------*/
+
+/* Regress_Load_Golden()
+ *
+ * Loads a golden P5 PGM image, returns FALSE if it does not exist
+ */
+  static gboolean
+Regress_Load_Golden(
+    const char *file_name, unsigned char **image,
+    int *width, int *lines )
+{
+  FILE *fp;
+  char type[3];
+  int max_val;
+  size_t size;
+  gboolean ok;
+
+  fp = fopen( file_name, "r" );
+  if( fp == NULL ) return( FALSE );
+
+  ok = (fscanf(fp, "%2s", type) == 1) && (strcmp(type, "P5") == 0) &&
+    Regress_PGM_Value(fp, width) && Regress_PGM_Value(fp, lines) &&
+    Regress_PGM_Value(fp, &max_val) && (max_val == 255) &&
+    (*width > 0) && (*lines > 0) && isspace( fgetc(fp) );
+
+  if( ok )
+  {
+    size = (size_t)( *width * *lines );
+    ok = mem_alloc( (void **)image, size ) &&
+      ( fread(*image, 1, size, fp) == size );
+  }
+
+  fclose( fp );
+  if( !ok )
+    fprintf( stderr, "xwefax: invalid golden image %s\n", file_name );
+  return( ok );
+} /* Regress_Load_Golden() */
+
+/*------------------------------------------------------------------------*/
+
+/* Regress_Line_Offset()
+ *
+ * Finds the shift of a decoded line against its golden
+ * line that minimizes their sum of absolute differences
+ */
+  static int
+Regress_Line_Offset(
+    const unsigned char *line, const unsigned char *golden, int width )
+{
+  long sad, best_sad = -1;
+  int shift, best_shift = 0, pix;
+
+  /* Search outward from zero shift, so that
+   * ties on flat lines report no offset */
+  for( shift = 0; shift <= 2 * REGRESS_MAX_SHIFT; shift++ )
+  {
+    int sft = ( shift & 1 ) ? -( (shift + 1) / 2 ) : shift / 2;
+
+    sad = 0;
+    for( pix = REGRESS_MAX_SHIFT; pix < width - REGRESS_MAX_SHIFT; pix++ )
+      sad += abs( (int)line[pix + sft] - (int)golden[pix] );
+
+    if( (best_sad < 0) || (sad < best_sad) )
+    {
+      best_sad   = sad;
+      best_shift = sft;
+    }
+  }
+
+  return( best_shift );
+} /* Regress_Line_Offset() */
+
+/*------------------------------------------------------------------------*/
+
+/* Regress_Compare()
+ *
+ * Measures PSNR, mean block SSIM and mean line sync
+ * offset of a decoded image against its golden image
+ */
+  static void
+Regress_Compare(
+    const unsigned char *image, const unsigned char *golden,
+    int width, int lines, regress_metrics_t *metrics )
+{
+  /* SSIM stabilizing constants for 8 bit pixels */
+  const double c1 = ( 0.01 * 255.0 ) * ( 0.01 * 255.0 );
+  const double c2 = ( 0.03 * 255.0 ) * ( 0.03 * 255.0 );
+
+  double sum_sq = 0.0, diff, ssim_sum = 0.0;
+  double mx, my, vx, vy, cxy, n;
+  long offset_sum = 0;
+  int line, pix, bln, bpx, row, col, blocks = 0;
+  const unsigned char *px, *py;
+
+  /* Mean squared error and line sync offsets */
+  for( line = 0; line < lines; line++ )
+  {
+    for( pix = 0; pix < width; pix++ )
+    {
+      diff = (double)image[line * width + pix] -
+        (double)golden[line * width + pix];
+      sum_sq += diff * diff;
+    }
+
+    offset_sum += abs( Regress_Line_Offset(
+          &image[line * width], &golden[line * width], width) );
+  }
+
+  if( sum_sq > 0.0 )
+    metrics->psnr = 10.0 * log10( 255.0 * 255.0 /
+        (sum_sq / (double)width / (double)lines) );
+  else
+    metrics->psnr = REGRESS_MAX_PSNR;
+  if( metrics->psnr > REGRESS_MAX_PSNR )
+    metrics->psnr = REGRESS_MAX_PSNR;
+
+  metrics->offset = (double)offset_sum / (double)lines;
+
+  /* Mean SSIM over non-overlapping blocks */
+  n = (double)( REGRESS_SSIM_BLOCK * REGRESS_SSIM_BLOCK );
+  for( bln = 0; bln + REGRESS_SSIM_BLOCK <= lines; bln += REGRESS_SSIM_BLOCK )
+    for( bpx = 0; bpx + REGRESS_SSIM_BLOCK <= width; bpx += REGRESS_SSIM_BLOCK )
+    {
+      mx = my = vx = vy = cxy = 0.0;
+      for( row = bln; row < bln + REGRESS_SSIM_BLOCK; row++ )
+      {
+        px = &image[row * width + bpx];
+        py = &golden[row * width + bpx];
+        for( col = 0; col < REGRESS_SSIM_BLOCK; col++ )
+        {
+          mx  += (double)px[col];
+          my  += (double)py[col];
+          vx  += (double)px[col] * (double)px[col];
+          vy  += (double)py[col] * (double)py[col];
+          cxy += (double)px[col] * (double)py[col];
+        }
+      }
+
+      mx /= n;
+      my /= n;
+      vx  = vx  / n - mx * mx;
+      vy  = vy  / n - my * my;
+      cxy = cxy / n - mx * my;
+
+      ssim_sum += ( (2.0 * mx * my + c1) * (2.0 * cxy + c2) ) /
+        ( (mx * mx + my * my + c1) * (vx + vy + c2) );
+      blocks++;
+    }
+
+  metrics->ssim = blocks ? ssim_sum / (double)blocks : 0.0;
+
+} /* Regress_Compare() */
+
+/*------------------------------------------------------------------------*/
+
+/* Regress_Configure()
+ *
+ * Sets up runtime data for the regression tests
+ */
+  static void
+Regress_Configure( void )
+{
+  rc_data.capture_rate    = REGRESS_RATE;
+  rc_data.dsp_rate        = REGRESS_RATE;
+  rc_data.num_chn         = 1;
+  rc_data.use_chn         = 0;
+  rc_data.tcvr_type       = NONE;
+  rc_data.lines_per_min   = REGRESS_RPM;
+  rc_data.pixels_per_line = REGRESS_PIXELS;
+  rc_data.ioc_value       = REGRESS_IOC;
+  rc_data.start_tone      = IOC576_START_TONE;
+  rc_data.black_freq      = 1500;
+  rc_data.white_freq      = 2300;
+  rc_data.phasing_lines   = REGRESS_PHASING;
+  rc_data.sync_slant      = 0.0;
+
+  /* Room for the image, in case the stop tone is missed */
+  rc_data.image_lines     = 2 * REGRESS_LINES;
+
+  /* Take samples from synthesizer, without the GUI */
+  SetFlag( HEADLESS );
+  SetFlag( SYNTH_SOURCE );
+  SetFlag( DISPLAY_SIGNAL );
+  ClearFlag( SAVE_IMAGE );
+  Configure();
+
+} /* Regress_Configure() */
+
+/*------------------------------------------------------------------------*/
+
+/* Regress_Replay_End()
+ *
+ * Ends the replay of a case and deletes the recording made of it
+ */
+  static void
+Regress_Replay_End( const char *dir )
+{
+  char file_name[ MAX_FILE_NAME ];
+
+  Close_Capture();
+  Replay_Close();
+  SetFlag( SYNTH_SOURCE );
+  rc_data.tcvr_type    = NONE;
+  rc_data.capture_rate = REGRESS_RATE;
+  rc_data.dsp_rate     = REGRESS_RATE;
+
+  snprintf( file_name, sizeof(file_name), "%s/replay.wav", dir );
+  unlink( file_name );
+} /* Regress_Replay_End() */
+
+/*------------------------------------------------------------------------*/
+
+/* Regress_Replay()
+ *
+ * Records the synthetic transmission of a case to a WAV
+ * file in a directory, or takes the case's recording from
+ * there, and replays it in place of the synthesizer, as fast
+ * as it is decoded, resampled to the case's DSP rate if it
+ * differs from that recorded
+ */
+  static gboolean
+Regress_Replay( const char *dir, const regress_case_t *cas )
+{
+  char file_name[ MAX_FILE_NAME ], mesg[ MESG_SIZE ];
+  short samples[ PERIOD_SIZE ];
+  wav_header_t header;
+  uint32_t size = 0;
+  int len = 0, error, dsp_rate;
+  gboolean ok = TRUE;
+  FILE *fp;
+
+  /* A recording is decoded at its own rate, unless given */
+  if( cas->recording )
+  {
+    snprintf( file_name, sizeof(file_name),
+        "%s/%s", dir, cas->recording );
+    dsp_rate = cas->replay ? cas->replay : rc_data.capture_rate;
+  }
+  else
+  {
+    snprintf( file_name, sizeof(file_name), "%s/replay.wav", dir );
+    dsp_rate = cas->replay;
+  }
+
+  if( !cas->recording && ((fp = fopen(file_name, "w")) == NULL) )
+  {
+    perror( file_name );
+    return( FALSE );
+  }
+
+  /* Samples after room for the header, then the header */
+  if( !cas->recording )
+  {
+    ok = ( fseek(fp, sizeof(header), SEEK_SET) == 0 );
+    while( ok && Synth_Sample(&samples[len]) )
+      if( ++len == PERIOD_SIZE )
+      {
+        ok = ( fwrite(samples, sizeof(short),
+              (size_t)len, fp) == (size_t)len );
+        size += (uint32_t)len * sizeof(short);
+        len = 0;
+      }
+    ok = ok &&
+      ( fwrite(samples, sizeof(short), (size_t)len, fp) == (size_t)len );
+    size += (uint32_t)len * sizeof(short);
+    Record_WAV_Header( &header, 1, 16, rc_data.dsp_rate, size );
+    ok = ok && ( fseek(fp, 0, SEEK_SET) == 0 ) &&
+      ( fwrite(&header, sizeof(header), 1, fp) == 1 );
+    if( (fclose(fp) != 0) || !ok )
+    {
+      perror( file_name );
+      return( FALSE );
+    }
+  }
+
+  /* Replay it in place of the synthesizer */
+  Strlcat( file_name, ",fast", sizeof(file_name) );
+  ClearFlag( SYNTH_SOURCE );
+  rc_data.dsp_rate = dsp_rate;
+  mesg[0] = '\0';
+  if( !Replay_Open(file_name) || !Replay_Configure() ||
+      !Open_Capture(mesg, &error) )
+  {
+    if( mesg[0] ) fprintf( stderr, "xwefax: %s\n", mesg );
+    Regress_Replay_End( dir );
+    return( FALSE );
+  }
+  Configure();
+  Set_Pixel_Len();
+
+  return( TRUE );
+} /* Regress_Replay() */
+
+/*------------------------------------------------------------------------*/
+
+/* Regress_Run()
+ *
+ * Decodes synthetic transmissions and recordings through the
+ * receive pipeline and compares the images to golden PGM files
+ * in a directory. The argument is the directory, optionally
+ * followed by ",bless" to create missing golden files from the
+ * decoded images, else they fail. Returns non-zero if the
+ * quality of any image has regressed
+ */
+  int
+Regress_Run( char *arg )
+{
+  /* Each case sets its pattern and only what it changes from a
+   * noiseless decode by the zero crossing detector. The fixed point
+   * cases are compared to the golden images of the floating point
+   * ones */
+  static const regress_case_t cases[] =
+  {
+    { .name = "gradient", .pattern = PATTERN_GRADIENT },
+    { .name = "checker", .pattern = PATTERN_CHECKER },
+    { .name = "lines_inimage", .pattern = PATTERN_LINES,
+      .enhance = ENHANCE_CONTRAST, .inimage = TRUE },
+    { .name = "checker_bilevel", .pattern = PATTERN_CHECKER,
+      .enhance = ENHANCE_BILEVEL, .detector = FM_Detect_Bilevel },
+    { .name = "checker_noisy", .pattern = PATTERN_CHECKER,
+      .noisy = TRUE, .enhance = ENHANCE_CONTRAST },
+    { .name = "gradient_fixed", .golden = "gradient",
+      .pattern = PATTERN_GRADIENT, .fixed = TRUE },
+    { .name = "bilevel_fixed", .golden = "checker_bilevel",
+      .pattern = PATTERN_CHECKER, .enhance = ENHANCE_BILEVEL,
+      .fixed = TRUE, .detector = FM_Detect_Bilevel },
+    { .name = "noisy_fixed", .golden = "checker_noisy",
+      .pattern = PATTERN_CHECKER, .noisy = TRUE,
+      .enhance = ENHANCE_CONTRAST, .fixed = TRUE },
+    { .name = "gradient_slant", .pattern = PATTERN_GRADIENT,
+      .clock_error = REGRESS_CLOCK_ERROR },
+    { .name = "slant_render", .pattern = PATTERN_GRADIENT,
+      .clock_error = REGRESS_CLOCK_ERROR, .render = TRUE },
+    { .name = "noisy_auto", .pattern = PATTERN_CHECKER, .noisy = TRUE,
+      .enhance = ENHANCE_CONTRAST, .auto_mode = TRUE },
+    { .name = "noisy_auto288", .pattern = PATTERN_CHECKER, .noisy = TRUE,
+      .enhance = ENHANCE_CONTRAST, .ioc = 288, .auto_mode = TRUE },
+    { .name = "noisy_afc", .pattern = PATTERN_CHECKER, .noisy = TRUE,
+      .enhance = ENHANCE_CONTRAST, .afc = TRUE },
+    { .name = "noisy_standby", .pattern = PATTERN_CHECKER, .noisy = TRUE,
+      .enhance = ENHANCE_CONTRAST, .standby = TRUE },
+    { .name = "noisy_replay", .pattern = PATTERN_CHECKER, .noisy = TRUE,
+      .enhance = ENHANCE_CONTRAST, .replay = REGRESS_RATE },
+    { .name = "noisy_resample", .pattern = PATTERN_CHECKER, .noisy = TRUE,
+      .enhance = ENHANCE_CONTRAST, .replay = REGRESS_RESAMPLE_RATE },
+    { .name = "recorded_12k", .recording = "recorded_12k.wav",
+      .enhance = ENHANCE_CONTRAST },
+  };
+
+  char file_name[ MAX_FILE_NAME ];
+  unsigned char *image, *golden = NULL, *rendered = NULL;
+  int lines, width, golden_width, golden_lines, cmp_lines;
+  regress_metrics_t metrics;
+  size_t cas;
+  FILE *fp;
+  int failed = 0;
+  gboolean pass, decoded, bless;
+  int ioc;
+  char *dir, *field;
+
+  /* Golden directory and the optional bless */
+  dir = strsep( &arg, "," );
+  bless = FALSE;
+  while( (field = strsep(&arg, ",")) )
+    if( strcmp(field, "bless") == 0 ) bless = TRUE;
+
+  Regress_Configure();
+
+  printf( "%s regression test: %d samples/sec, %.0f RPM, "
+      "%d pixels/line, %d lines\n", PACKAGE_STRING,
+      REGRESS_RATE, REGRESS_RPM, REGRESS_PIXELS, REGRESS_LINES );
+  printf( "Thresholds: PSNR %.0f dB, SSIM %.2f, "
+      "line sync offset %.1f pixels\n\n",
+      REGRESS_MIN_PSNR, REGRESS_MIN_SSIM, REGRESS_MAX_OFFSET );
+
+  for( cas = 0; cas < sizeof(cases) / sizeof(cases[0]); cas++ )
+  {
+    /* Keep results in order with decoder messages */
+    fflush( stdout );
+
+    /* Decode the case's transmission */
+    rc_data.image_enhance = cases[cas].enhance;
+    if( cases[cas].inimage )
+      SetFlag( INIMAGE_PHASING );
+    else
+      ClearFlag( INIMAGE_PHASING );
+    if( cases[cas].fixed )
+      SetFlag( FIXED_POINT );
+    else
+      ClearFlag( FIXED_POINT );
+    if( (cases[cas].clock_error != 0.0) && !cases[cas].render )
+      SetFlag( AUTO_DESLANT );
+    else
+      ClearFlag( AUTO_DESLANT );
+    if( cases[cas].standby )
+      SetFlag( LOW_POWER_STANDBY );
+    else
+      ClearFlag( LOW_POWER_STANDBY );
+    if( cases[cas].afc )
+    {
+      Afc_Reset();
+      SetFlag( AFC_ENABLE );
+    }
+    else
+      ClearFlag( AFC_ENABLE );
+    rc_data.sync_slant = 0.0;
+    ioc = cases[cas].ioc ? cases[cas].ioc : REGRESS_IOC;
+    rc_data.lines_per_min = REGRESS_RPM;
+    rc_data.ioc_value     = ioc;
+    rc_data.start_tone    =
+      ( ioc == 288 ) ? IOC288_START_TONE : IOC576_START_TONE;
+    Configure();
+    Set_Pixel_Len();
+
+    /* Configure() sets the start tone period only on a change
+     * of RPM or resolution, not of the IOC left by a case */
+    rc_data.start_tone_period = rc_data.lines_per_min / 60.0 *
+      (double)rc_data.pixels_per_line / (double)rc_data.start_tone;
+
+    /* Start from a clear decoder, whatever was decoded before */
+    Detect_Reset();
+    FM_Detector = cases[cas].detector ?
+      cases[cas].detector : FM_Detect_Zero_Crossing;
+    if( !cases[cas].recording ) Regress_Synth( &cases[cas] );
+
+    /* Record the transmission, or take a recording, to decode its replay */
+    if( (cases[cas].replay || cases[cas].recording) &&
+        !Regress_Replay(dir, &cases[cas]) )
+    {
+      printf( "%-16s FAIL no recording replayed\n", cases[cas].name );
+      failed++;
+      continue;
+    }
+
+    /* Start the decoder at other IOC and RPM, to detect the right ones */
+    if( cases[cas].auto_mode )
+    {
+      SetFlag( AUTO_IOC_RPM );
+      rc_data.lines_per_min = REGRESS_AUTO_RPM;
+      rc_data.ioc_value     = ( ioc == 288 ) ? 576 : 288;
+      rc_data.start_tone    =
+        ( ioc == 288 ) ? IOC576_START_TONE : IOC288_START_TONE;
+      Configure();
+    }
+    else
+      ClearFlag( AUTO_IOC_RPM );
+
+    /* Capture the discriminator output only, in dir/images */
+    free_ptr( (void **)&rendered );
+    if( cases[cas].render )
+    {
+      snprintf( rc_data.xwefax_dir,
+          sizeof(rc_data.xwefax_dir), "%s/", dir );
+      snprintf( file_name, sizeof(file_name), "%s/images", dir );
+      mkdir( file_name, 0755 );
+      SetFlag( SAVE_IMAGE );
+      SetFlag( SAVE_IMAGE_RAW );
+      ClearFlag( SAVE_IMAGE_PGM );
+      ClearFlag( SAVE_IMAGE_JPG );
+    }
+    else
+    {
+      ClearFlag( SAVE_IMAGE );
+      ClearFlag( SAVE_IMAGE_RAW );
+    }
+
+    decoded = Wefax_Decode_Headless( &image, &lines );
+    if( cases[cas].replay || cases[cas].recording )
+      Regress_Replay_End( dir );
+    if( !decoded )
+    {
+      printf( "%-16s FAIL no image decoded\n", cases[cas].name );
+      failed++;
+      continue;
+    }
+    width = rc_data.pixels_per_line;
+
+    /* The IOC and RPM detected must be those transmitted */
+    if( cases[cas].auto_mode && ((rc_data.ioc_value != ioc) ||
+          (rc_data.lines_per_min != REGRESS_RPM)) )
+    {
+      printf( "%-16s FAIL detected IOC %d and %.0f RPM\n",
+          cases[cas].name, rc_data.ioc_value, rc_data.lines_per_min );
+      failed++;
+      continue;
+    }
+
+    /* Re-render the capture with the slant of the clock error */
+    if( cases[cas].render )
+    {
+      gboolean ok = Raw_Render( Raw_File_Name(),
+          (double)REGRESS_PIXELS / (1.0 + cases[cas].clock_error) -
+          (double)REGRESS_PIXELS, 0.0, -1, &rendered, &width, &lines );
+      unlink( Raw_File_Name() );
+      rmdir( file_name );
+      if( !ok )
+      {
+        printf( "%-16s FAIL no image rendered\n", cases[cas].name );
+        failed++;
+        continue;
+      }
+      image = rendered;
+    }
+
+    /* Images are blessed and compared at the width transmitted,
+     * which the image decoded or rendered must have */
+    if( width != REGRESS_PIXELS )
+    {
+      printf( "%-16s FAIL image width %d\n", cases[cas].name, width );
+      failed++;
+      continue;
+    }
+
+    /* Create a missing golden image from the decoded one if
+     * blessed, else the case fails without its golden image */
+    snprintf( file_name, sizeof(file_name),
+        "%s/%s.pgm", dir,
+        cases[cas].golden ? cases[cas].golden : cases[cas].name );
+    if( !Regress_Load_Golden(file_name,
+          &golden, &golden_width, &golden_lines) )
+    {
+      if( !bless )
+      {
+        printf( "%-16s FAIL no golden image %s\n",
+            cases[cas].name, file_name );
+        failed++;
+        continue;
+      }
+      if( (fp = fopen(file_name, "w")) == NULL )
+      {
+        perror( file_name );
+        failed++;
+        continue;
+      }
+      if( !Save_Image_PGM(fp, "P5",
+            REGRESS_PIXELS, lines, 255, image) )
+      {
+        failed++;
+        continue;
+      }
+      printf( "%-16s %4d lines  NEW  %s\n",
+          cases[cas].name, lines, file_name );
+      continue;
+    }
+
+    if( golden_width != REGRESS_PIXELS )
+    {
+      printf( "%-16s FAIL golden image width %d\n",
+          cases[cas].name, golden_width );
+      failed++;
+      free_ptr( (void **)&golden );
+      continue;
+    }
+
+    /* Compare the lines common to both images */
+    cmp_lines = lines < golden_lines ? lines : golden_lines;
+    Regress_Compare( image, golden,
+        REGRESS_PIXELS, cmp_lines, &metrics );
+    free_ptr( (void **)&golden );
+
+    pass =
+      ( abs(lines - golden_lines) <= REGRESS_MAX_LINES ) &&
+      ( metrics.psnr   >= REGRESS_MIN_PSNR ) &&
+      ( metrics.ssim   >= REGRESS_MIN_SSIM ) &&
+      ( metrics.offset <= REGRESS_MAX_OFFSET );
+    if( !pass ) failed++;
+
+    printf( "%-16s %4d lines  %s  PSNR %5.1f dB  SSIM %.3f  "
+        "offset %.2f px\n", cases[cas].name, lines,
+        pass ? "pass" : "FAIL", metrics.psnr, metrics.ssim, metrics.offset );
+  }
+
+  free_ptr( (void **)&rendered );
+
+  printf( "\n%d of %d cases failed\n",
+      failed, (int)(sizeof(cases) / sizeof(cases[0])) );
+
+  return( failed ? 1 : 0 );
+} /* Regress_Run() */
+
+/*------------------------------------------------------------------------*/
+
@@ -0,0 +1,90 @@
+/*
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License as
+ *  published by the Free Software Foundation; either version 2 of
+ *  the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details:
+ *
+ *  http://www.gnu.org/copyleft/gpl.txt
+ */
+#ifndef REGRESS_H
+#define REGRESS_H   1
+
+#include "common.h"
+
+/* Parameters of regression test transmissions */
+#define REGRESS_RATE        48000
+#define REGRESS_RPM         120.0
+#define REGRESS_PIXELS      1200
+#define REGRESS_IOC         576
+#define REGRESS_PHASING     20
+#define REGRESS_LINES       200
+
+/* DSP rate the resampled regression transmission is decoded at */
+#define REGRESS_RESAMPLE_RATE 12000
+
+/* Impairments of the noisy regression transmission */
+#define REGRESS_NOISY_SNR     12.0
+#define REGRESS_NOISY_FADE    0.2
+#define REGRESS_NOISY_OFFSET  20.0
+
+/* Tuning offset of the regression transmission corrected by AFC */
+#define REGRESS_AFC_OFFSET    150.0
+
+/* Line rate error of the slanted regression transmission */
+#define REGRESS_CLOCK_ERROR   300.0E-6
+
+/* RPM the decoder starts at, for the cases that detect the IOC
+ * and RPM. It starts at the IOC other than that transmitted */
+#define REGRESS_AUTO_RPM    60.0
+
+/* Quality thresholds, below which a decode has regressed */
+#define REGRESS_MIN_PSNR    30.0
+#define REGRESS_MIN_SSIM    0.90
+#define REGRESS_MAX_OFFSET  1.0
+#define REGRESS_MAX_LINES   2
+
+/* PSNR of identical images, in dB */
+#define REGRESS_MAX_PSNR    99.0
+
+/* Size of SSIM blocks and range of line sync search, in pixels */
+#define REGRESS_SSIM_BLOCK  8
+#define REGRESS_MAX_SHIFT   8
+
+/* A regression case, decoded and compared to its golden image.
+ * Fields left out default to zero, NULL or FALSE */
+typedef struct
+{
+  const char *name;   /* Name of case */
+  const char *golden; /* Name of golden PGM file, NULL for name */
+  int pattern;        /* Pattern of synthesized image */
+  gboolean noisy;     /* Add noise, fading and frequency offset */
+  int enhance;        /* Image enhancement mode */
+  gboolean inimage;   /* Enable in-image phasing */
+  gboolean fixed;     /* Demodulate in fixed point arithmetic */
+  double clock_error; /* Line rate error, corrected by auto deslant */
+  gboolean render;    /* Compare the re-rendering of its raw capture */
+  int ioc;            /* IOC of transmission, 0 for REGRESS_IOC */
+  gboolean auto_mode; /* Detect the IOC and RPM of transmission */
+  gboolean afc;       /* Correct a large tuning offset with AFC */
+  gboolean standby;   /* Listen for the start tone in low power standby */
+  int replay;         /* DSP rate the replay of its recording is decoded at */
+  const char *recording; /* WAV file in the golden directory to decode */
+  /* FM detector, NULL for the zero crossing one */
+  gboolean ( *detector )( unsigned char *level );
+} regress_case_t;
+
+/* Quality metrics of a decoded image against its golden image */
+typedef struct
+{
+  double psnr;   /* Peak signal to noise ratio, dB */
+  double ssim;   /* Mean structural similarity */
+  double offset; /* Mean line sync offset, pixels */
+} regress_metrics_t;
+
+#endif
+
@@ -0,0 +1,504 @@
+/*
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License as
+ *  published by the Free Software Foundation; either version 2 of
+ *  the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details:
+ *
+ *  http://www.gnu.org/copyleft/gpl.txt
+ */
+
+#include "replay.h"
+#include "shared.h"
+#include "raw.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+
+/* State of the recording being replayed */
+static struct
+{
+  /* Mapping of the file and the samples in it */
+  uint8_t *map;
+  size_t map_size;
+  const uint8_t *data;
+
+  int
+    channels,   /* 1 for audio, 2 for stereo audio or I/Q */
+    bits,       /* Bits per sample */
+    frame,      /* Bytes per frame */
+    rate;       /* Frames per second, 0 if the DSP rate */
+
+  gboolean
+    iq,         /* Perseus I/Q samples */
+    loop,       /* Replay again from the seek point at the end */
+    fast,       /* Replay as fast as decoded, not in real time */
+    ended;      /* End of recording reported */
+
+  size_t
+    frames,     /* Frames in the recording */
+    start,      /* Frame of the seek point */
+    pos;        /* Next frame to replay */
+
+  double seek;  /* Seek point in seconds */
+
+  /* Time of the seek point and frames replayed
+   * since, to pace the replay in real time */
+  uint64_t clock, played;
+
+  /* One channel of stereo audio and silence after the end */
+  short span[ PERIOD_SIZE ];
+
+  char file_name[ MAX_FILE_NAME ];
+
+} replay;
+
+/*------------------------------------------------------------------------*/
+
+/* Replay_Get16()
+ *
+ * Reads a little endian 16 bit value from the file mapping
+ */
+  static uint16_t
+Replay_Get16( const uint8_t *ptr )
+{
+  return( (uint16_t)(ptr[0] | ptr[1] << 8) );
+} /* Replay_Get16() */
+
+/*------------------------------------------------------------------------*/
+
+/* Replay_Get32()
+ *
+ * Reads a little endian 32 bit value from the file mapping
+ */
+  static uint32_t
+Replay_Get32( const uint8_t *ptr )
+{
+  return( (uint32_t)ptr[0] | (uint32_t)ptr[1] << 8 |
+      (uint32_t)ptr[2] << 16 | (uint32_t)ptr[3] << 24 );
+} /* Replay_Get32() */
+
+/*------------------------------------------------------------------------*/
+
+/* Replay_Parse_WAV()
+ *
+ * Finds the format and data chunks of a RIFF WAV file in the
+ * mapping. Data of a size 0 or past the end of the file, as
+ * left by an interrupted recording, is taken to the end of file
+ */
+  static gboolean
+Replay_Parse_WAV( size_t *offset, size_t *size )
+{
+  const uint8_t *chunk;
+  size_t pos = 12, len;
+  int format = 0;
+
+
+  while( pos + 8 <= replay.map_size )
+  {
+    chunk = &replay.map[ pos ];
+    len   = Replay_Get32( &chunk[4] );
+
+    if( (memcmp(chunk, "fmt ", 4) == 0) && (len >= 16) &&
+        (pos + 8 + 16 <= replay.map_size) )
+    {
+      format = Replay_Get16( &chunk[8] );
+      replay.channels = Replay_Get16( &chunk[10] );
+      replay.rate     = (int)Replay_Get32( &chunk[12] );
+      replay.bits     = Replay_Get16( &chunk[22] );
+    }
+    else if( memcmp(chunk, "data", 4) == 0 )
+    {
+      *offset = pos + 8;
+      if( (len == 0) || (len > replay.map_size - *offset) )
+        len = replay.map_size - *offset;
+      *size = len;
+      break;
+    }
+
+    /* Chunks are padded to an even size */
+    pos += 8 + len + ( len & 1 );
+  } /* while( pos + 8 <= replay.map_size ) */
+
+  if( (format != REPLAY_FORMAT_PCM) &&
+      (format != REPLAY_FORMAT_EXTENSIBLE) )
+  {
+    fprintf( stderr, "xwefax: %s: not an integer PCM WAV file\n",
+        replay.file_name );
+    return( FALSE );
+  }
+  if( *offset == 0 )
+  {
+    fprintf( stderr, "xwefax: %s: no data in WAV file\n",
+        replay.file_name );
+    return( FALSE );
+  }
+
+  return( TRUE );
+} /* Replay_Parse_WAV() */
+
+/*------------------------------------------------------------------------*/
+
+/* Replay_Close()
+ *
+ * Unmaps the recording being replayed
+ */
+  void
+Replay_Close( void )
+{
+  if( replay.map != NULL )
+    munmap( replay.map, replay.map_size );
+  replay.map = NULL;
+  ClearFlag( FILE_SOURCE );
+} /* Replay_Close() */
+
+/*------------------------------------------------------------------------*/
+
+/* Replay_Open()
+ *
+ * Maps a recording to replay in place of the receiver. The argument
+ * is the file name, optionally followed by the seek point in seconds
+ * and by "loop" and "fast", separated by commas. A WAV file of 16 bit
+ * mono or stereo audio is replayed at its own rate, a stereo one at
+ * the Perseus rate as I/Q. Files without a WAV header are taken as 16
+ * bit mono audio at the DSP rate of xwefaxrc
+ */
+  gboolean
+Replay_Open( char *arg )
+{
+  struct stat st;
+  char *field;
+  size_t offset = 0, size = 0;
+  int fd;
+
+
+  Replay_Close();
+  replay.loop = replay.fast = FALSE;
+  replay.seek = 0.0;
+  replay.start = replay.pos = 0;
+
+  /* File name and options */
+  Strlcpy( replay.file_name, strsep(&arg, ","), sizeof(replay.file_name) );
+  while( (field = strsep(&arg, ",")) != NULL )
+  {
+    if( strcmp(field, "loop") == 0 )
+      replay.loop = TRUE;
+    else if( strcmp(field, "fast") == 0 )
+      replay.fast = TRUE;
+    else if( *field )
+      replay.seek = atof( field );
+  }
+
+  /* Map the file for sequential reading */
+  fd = open( replay.file_name, O_RDONLY );
+  if( fd < 0 )
+  {
+    perror( replay.file_name );
+    return( FALSE );
+  }
+  if( (fstat(fd, &st) < 0) || (st.st_size < 12) )
+  {
+    fprintf( stderr, "xwefax: %s: no samples to replay\n",
+        replay.file_name );
+    close( fd );
+    return( FALSE );
+  }
+  replay.map_size = (size_t)st.st_size;
+  replay.map = mmap( NULL, replay.map_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+  close( fd );
+  if( replay.map == MAP_FAILED )
+  {
+    perror( replay.file_name );
+    replay.map = NULL;
+    return( FALSE );
+  }
+  madvise( replay.map, replay.map_size, MADV_SEQUENTIAL );
+
+  if( memcmp(replay.map, RAW_MAGIC, RAW_MAGIC_LEN) == 0 )
+  {
+    fprintf( stderr, "xwefax: %s: a raw discriminator file, "
+        "re-render it with -R\n", replay.file_name );
+    Replay_Close();
+    return( FALSE );
+  }
+
+  /* A WAV file, or 16 bit mono audio at the DSP rate */
+  if( (memcmp(replay.map, "RIFF", 4) == 0) &&
+      (memcmp(&replay.map[8], "WAVE", 4) == 0) )
+  {
+    if( !Replay_Parse_WAV(&offset, &size) )
+    {
+      Replay_Close();
+      return( FALSE );
+    }
+  }
+  else
+  {
+    replay.channels = 1;
+    replay.bits     = 16;
+    replay.rate     = 0;
+    size = replay.map_size;
+  }
+
+  /* Perseus I/Q as recorded, else 16 bit audio */
+  replay.iq = ( replay.channels == 2 ) &&
+    ( replay.rate == PERSEUS_SAMPLE_RATE ) &&
+    ( (replay.bits == 16) || (replay.bits == 24) );
+  if( !replay.iq &&
+      ((replay.bits != 16) || (replay.channels < 1) ||
+       (replay.channels > 2) || (replay.rate < 0)) )
+  {
+    fprintf( stderr, "xwefax: %s: %d channels of %d bit samples, "
+        "not 16 bit audio or Perseus I/Q\n",
+        replay.file_name, replay.channels, replay.bits );
+    Replay_Close();
+    return( FALSE );
+  }
+
+  replay.data   = &replay.map[ offset ];
+  replay.frame  = replay.channels * replay.bits / 8;
+  replay.frames = size / (size_t)replay.frame;
+  if( replay.frames == 0 )
+  {
+    fprintf( stderr, "xwefax: %s: no samples to replay\n",
+        replay.file_name );
+    Replay_Close();
+    return( FALSE );
+  }
+
+  SetFlag( FILE_SOURCE );
+  return( TRUE );
+} /* Replay_Open() */
+
+/*------------------------------------------------------------------------*/
+
+/* Replay_Configure()
+ *
+ * Sets the receiver type and capture rate of the recording,
+ * in place of those of xwefaxrc. CAT is not used in replay
+ */
+  gboolean
+Replay_Configure( void )
+{
+  char mesg[ MESG_SIZE ];
+
+  if( replay.iq )
+  {
+#ifdef HAVE_LIBPERSEUS_SDR
+    rc_data.tcvr_type = PERSEUS;
+#else
+    snprintf( mesg, sizeof(mesg),
+        _("Cannot replay the Perseus I/Q of\n%s\n"
+          "xwefax is built without Perseus support"), replay.file_name );
+    Error_Dialog( mesg, QUIT );
+    return( FALSE );
+#endif
+  }
+  else if( (rc_data.tcvr_type == PERSEUS) ||
+      (rc_data.tcvr_type == NONE) )
+    rc_data.tcvr_type = RADIO;
+
+  /* The recording is captured at its own rate. The DSP rate
+   * follows it, unless xwefaxrc resamples to another one */
+  if( replay.rate )
+  {
+    if( replay.iq || (rc_data.dsp_rate == rc_data.capture_rate) )
+      rc_data.dsp_rate = replay.rate;
+    rc_data.capture_rate = replay.rate;
+  }
+  else
+    replay.rate = rc_data.capture_rate;
+
+  /* Seek point in frames */
+  replay.start = (size_t)( replay.seek * (double)replay.rate );
+  if( replay.start >= replay.frames )
+  {
+    snprintf( mesg, sizeof(mesg),
+        _("Seek point %.1f sec is past the end of\n%s"),
+        replay.seek, replay.file_name );
+    Error_Dialog( mesg, QUIT );
+    return( FALSE );
+  }
+
+  snprintf( mesg, sizeof(mesg), _("Replaying %s"), replay.file_name );
+  Show_Message( mesg, "black" );
+
+  return( TRUE );
+} /* Replay_Configure() */
+
+/*------------------------------------------------------------------------*/
+
+/* Replay_Attach()
+ *
+ * Starts the replay from the seek point, when the signal source is opened
+ */
+  void
+Replay_Attach( void )
+{
+  replay.pos    = replay.start;
+  replay.clock  = Perf_Clock();
+  replay.played = 0;
+  replay.ended  = FALSE;
+} /* Replay_Attach() */
+
+/*------------------------------------------------------------------------*/
+
+/* Replay_Ended_Idle_Cb()
+ *
+ * Idle callback that stops reception at the end of the recording
+ */
+  static gboolean
+Replay_Ended_Idle_Cb( gpointer data )
+{
+  GtkToggleButton *start;
+
+  Show_Message( _("Replay of recording ended"), "black" );
+  start = GTK_TOGGLE_BUTTON(
+      Builder_Get_Object(main_window_builder, "start_togglebutton") );
+  gtk_toggle_button_set_active( start, FALSE );
+
+  return( FALSE );
+} /* Replay_Ended_Idle_Cb() */
+
+/*------------------------------------------------------------------------*/
+
+/* Replay_Frames()
+ *
+ * Returns the next frames of the recording, up to len, and their count.
+ * At its end the replay is looped, else the end is reported once and
+ * no frames are returned. Frames are paced to the rate of recording,
+ * unless replaying fast
+ */
+  static const uint8_t *
+Replay_Frames( int len, int *count )
+{
+  const uint8_t *frames;
+  uint64_t due, now;
+  struct timespec ts;
+
+
+  if( replay.pos >= replay.frames )
+  {
+    if( !replay.loop )
+    {
+      if( !replay.ended && isFlagClear(HEADLESS) )
+        g_idle_add( Replay_Ended_Idle_Cb, NULL );
+      replay.ended = TRUE;
+      *count = 0;
+      return( NULL );
+    }
+    replay.pos = replay.start;
+  }
+
+  if( (size_t)len > replay.frames - replay.pos )
+    len = (int)( replay.frames - replay.pos );
+  frames = &replay.data[ replay.pos * (size_t)replay.frame ];
+  replay.pos += (size_t)len;
+  *count = len;
+
+  /* Sleep until the frames are due in real time */
+  replay.played += (uint64_t)len;
+  if( !replay.fast )
+  {
+    due = replay.clock + replay.played * 1000000000ull /
+      (uint64_t)replay.rate;
+    now = Perf_Clock();
+    if( due > now )
+    {
+      ts.tv_sec  = (time_t)( (due - now) / 1000000000ull );
+      ts.tv_nsec = (long)( (due - now) % 1000000000ull );
+      nanosleep( &ts, NULL );
+    }
+  }
+
+  return( frames );
+} /* Replay_Frames() */
+
+/*------------------------------------------------------------------------*/
+
+/* Replay_Span()
+ *
+ * Returns a span of audio samples of the recording and its length.
+ * Mono spans are taken in place from the mapping, the channel in use
+ * of stereo ones is copied out. After the end of the recording the
+ * span is silence, or NULL without the GUI to end the decoding
+ */
+  const short *
+Replay_Span( int *len )
+{
+  const uint8_t *frames;
+  int idx, chn;
+
+
+  frames = Replay_Frames( PERIOD_SIZE, len );
+  if( frames == NULL )
+  {
+    if( isFlagSet(HEADLESS) ) return( NULL );
+    memset( replay.span, 0, sizeof(replay.span) );
+    *len = PERIOD_SIZE;
+    return( replay.span );
+  }
+
+  /* Samples of a mono recording, if aligned */
+  if( (replay.channels == 1) && !((uintptr_t)frames & 1) )
+    return( (const short *)frames );
+
+  chn = ( replay.channels == 2 ) ? 2 * rc_data.use_chn : 0;
+  for( idx = 0; idx < *len; idx++ )
+    replay.span[idx] = (short)Replay_Get16( &frames[idx * replay.frame + chn] );
+
+  return( replay.span );
+} /* Replay_Span() */
+
+/*------------------------------------------------------------------------*/
+
+/* Replay_IQ()
+ *
+ * Fills buffers with len I/Q samples of the recording,
+ * as 32 bit (msb aligned) integers like the Perseus ones.
+ * After the end of the recording they are filled with zeros
+ */
+  void
+Replay_IQ( int32_t *i_buf, int32_t *q_buf, int len )
+{
+  const uint8_t *frames;
+  int idx, count, done = 0;
+
+
+  while( done < len )
+  {
+    frames = Replay_Frames( len - done, &count );
+    if( frames == NULL )
+    {
+      memset( &i_buf[done], 0, (size_t)(len - done) * sizeof(int32_t) );
+      memset( &q_buf[done], 0, (size_t)(len - done) * sizeof(int32_t) );
+      return;
+    }
+
+    if( replay.bits == 24 )
+      for( idx = 0; idx < count; idx++, frames += 6 )
+      {
+        i_buf[done + idx] = (int32_t)( (uint32_t)frames[0] << 8 |
+            (uint32_t)frames[1] << 16 | (uint32_t)frames[2] << 24 );
+        q_buf[done + idx] = (int32_t)( (uint32_t)frames[3] << 8 |
+            (uint32_t)frames[4] << 16 | (uint32_t)frames[5] << 24 );
+      }
+    else
+      for( idx = 0; idx < count; idx++, frames += 4 )
+      {
+        i_buf[done + idx] = (int32_t)( (uint32_t)frames[0] << 16 |
+            (uint32_t)frames[1] << 24 );
+        q_buf[done + idx] = (int32_t)( (uint32_t)frames[2] << 16 |
+            (uint32_t)frames[3] << 24 );
+      }
+
+    done += count;
+  } /* while( done < len ) */
+
+} /* Replay_IQ() */
+
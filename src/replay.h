@@ -0,0 +1,25 @@
+/*
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License as
+ *  published by the Free Software Foundation; either version 2 of
+ *  the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details:
+ *
+ *  http://www.gnu.org/copyleft/gpl.txt
+ */
+
+#ifndef REPLAY_H
+#define REPLAY_H    1
+
+#include "common.h"
+#include "perseus.h"
+
+/* WAV format tags of integer PCM samples */
+#define REPLAY_FORMAT_PCM         0x0001
+#define REPLAY_FORMAT_EXTENSIBLE  0xFFFE
+
+#endif
@@ -0,0 +1,202 @@
+/*
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License as
+ *  published by the Free Software Foundation; either version 2 of
+ *  the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details:
+ *
+ *  http://www.gnu.org/copyleft/gpl.txt
+ */
+
+#include "resample.h"
+#include "shared.h"
+
+/*------------------------------------------------------------------------*/
+
+/* Resample_Bessel_I0()
+ *
+ * Modified Bessel function of order 0, by its power series
+ */
+  static double
+Resample_Bessel_I0( double x )
+{
+  double sum = 1.0, term = 1.0, half = x / 2.0;
+  int idx;
+
+  for( idx = 1; idx < RESAMPLE_I0_TERMS; idx++ )
+  {
+    term *= half / (double)idx;
+    sum  += term * term;
+  }
+
+  return( sum );
+} /* Resample_Bessel_I0() */
+
+/*------------------------------------------------------------------------*/
+
+/* Resample_Design()
+ *
+ * Designs the Kaiser windowed sinc low pass filter of
+ * the resampler, at the up sampled rate, and splits it
+ * into its phases. It passes up to RESAMPLE_PASS_FREQ
+ * and stops at the Nyquist frequency of the lower rate
+ */
+  static gboolean
+Resample_Design( resampler_t *resampler )
+{
+  double fs, pass, stop, cutoff, trans, beta, center, t, w, sum;
+  double *proto = NULL;
+  int len, phase, tap, idx;
+  size_t alloc;
+
+  /* Transition band at the up sampled rate */
+  fs    = (double)resampler->in_rate * (double)resampler->up;
+  pass  = (double)RESAMPLE_PASS_FREQ;
+  stop  = (double)MIN( resampler->in_rate, resampler->out_rate ) / 2.0;
+  if( stop <= pass ) return( FALSE );
+  cutoff = ( pass + stop ) / 2.0 / fs;
+  trans  = ( stop - pass ) / fs;
+
+  /* Kaiser's estimate of the window shape and filter
+   * length, rounded up to whole aligned filter phases */
+  beta = 0.1102 * ( RESAMPLE_ATTEN - 8.7 );
+  len  = (int)ceil( (RESAMPLE_ATTEN - 7.95) / (14.36 * trans) ) + 1;
+  resampler->taps = ( len + resampler->up - 1 ) / resampler->up;
+  resampler->taps = ( resampler->taps + RESAMPLE_TAP_ALIGN - 1 ) /
+    RESAMPLE_TAP_ALIGN * RESAMPLE_TAP_ALIGN;
+  len = resampler->taps * resampler->up;
+
+  alloc = (size_t)len * sizeof(double);
+  if( !mem_alloc((void **)&proto, alloc) ) return( FALSE );
+  alloc = (size_t)len * sizeof(float);
+  if( !mem_realloc((void **)&resampler->coef, alloc) )
+  {
+    free_ptr( (void **)&proto );
+    return( FALSE );
+  }
+
+  /* Prototype filter, windowed sinc of the cutoff */
+  center = (double)( len - 1 ) / 2.0;
+  sum = 0.0;
+  for( idx = 0; idx < len; idx++ )
+  {
+    t = (double)idx - center;
+    w = t / center;
+    proto[idx] = 2.0 * cutoff;
+    if( t != 0.0 )
+      proto[idx] = sin( M_2PI * cutoff * t ) / ( M_PI * t );
+    proto[idx] *= Resample_Bessel_I0( beta * sqrt(1.0 - w * w) );
+    sum += proto[idx];
+  }
+
+  /* Split the filter into its phases, with unity
+   * gain at DC once up sampling stuffs zeros */
+  for( phase = 0; phase < resampler->up; phase++ )
+    for( tap = 0; tap < resampler->taps; tap++ )
+      resampler->coef[phase * resampler->taps + resampler->taps - 1 - tap] =
+        (float)( proto[phase + tap * resampler->up] *
+            (double)resampler->up / sum );
+
+  free_ptr( (void **)&proto );
+  return( TRUE );
+} /* Resample_Design() */
+
+/*------------------------------------------------------------------------*/
+
+/* Resample_Init()
+ *
+ * Sets up a resampler from one sample rate to another, for
+ * blocks of up to max_in samples. The filter is designed
+ * again only if the rates change, else it is just reset
+ */
+  gboolean
+Resample_Init(
+    resampler_t *resampler,
+    int in_rate, int out_rate, int max_in )
+{
+  int gcd, rem, a;
+  size_t alloc;
+
+  if( (in_rate <= 0) || (out_rate <= 0) || (max_in <= 0) )
+    return( FALSE );
+
+  if( (resampler->coef == NULL) ||
+      (resampler->in_rate  != in_rate) ||
+      (resampler->out_rate != out_rate) )
+  {
+    /* Factors of the rates by their greatest common divisor */
+    gcd = in_rate;
+    a   = out_rate;
+    while( a )
+    {
+      rem = gcd % a;
+      gcd = a;
+      a   = rem;
+    }
+    resampler->in_rate  = in_rate;
+    resampler->out_rate = out_rate;
+    resampler->up   = out_rate / gcd;
+    resampler->down = in_rate  / gcd;
+    if( (resampler->up > RESAMPLE_MAX_UP) || !Resample_Design(resampler) )
+    {
+      free_ptr( (void **)&resampler->coef );
+      return( FALSE );
+    }
+    resampler->max_in = 0;
+  }
+
+  /* History of the filter followed by a block of input */
+  if( resampler->max_in != max_in )
+  {
+    alloc = (size_t)( resampler->taps - 1 + max_in ) * sizeof(float);
+    if( !mem_realloc((void **)&resampler->hist, alloc) )
+    {
+      free_ptr( (void **)&resampler->coef );
+      return( FALSE );
+    }
+    resampler->max_in = max_in;
+  }
+  resampler->max_out = (int)( ((int64_t)max_in * resampler->up +
+        resampler->down - 1) / resampler->down ) + 1;
+
+  /* Start on silence */
+  bzero( (void *)resampler->hist,
+      (size_t)(resampler->taps - 1 + max_in) * sizeof(float) );
+  resampler->pos   = resampler->taps - 1;
+  resampler->phase = 0;
+
+  return( TRUE );
+} /* Resample_Init() */
+
+/*------------------------------------------------------------------------*/
+
+/* Resample()
+ *
+ * Resamples a block of input samples, of up to max_in,
+ * and returns the number of output samples, up to max_out
+ */
+  int
+Resample(
+    resampler_t *resampler,
+    const short *in, int len, short *out )
+{
+  float *hist = &resampler->hist[ resampler->taps - 1 ];
+  int idx, count;
+
+  for( idx = 0; idx < len; idx++ )
+    hist[idx] = (float)in[idx];
+  count = DSP_Kernels->resample( resampler, resampler->taps - 1 + len, out );
+
+  /* Keep the newest input as the history of the next block */
+  memmove( resampler->hist, &resampler->hist[len],
+      (size_t)(resampler->taps - 1) * sizeof(float) );
+  resampler->pos -= len;
+
+  return( count );
+} /* Resample() */
+
+/*------------------------------------------------------------------------*/
@@ -0,0 +1,38 @@
+/*
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License as
+ *  published by the Free Software Foundation; either version 2 of
+ *  the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details:
+ *
+ *  http://www.gnu.org/copyleft/gpl.txt
+ */
+
+#ifndef RESAMPLE_H
+#define RESAMPLE_H  1
+
+#include "common.h"
+
+/* Upper edge of the pass band kept by the resampler, Hz.
+ * It clears the WEFAX tones and the AFC's offset range */
+#define RESAMPLE_PASS_FREQ  3000
+
+/* Stop band attenuation of the anti-alias filter, dB */
+#define RESAMPLE_ATTEN      80.0
+
+/* Taps of each filter phase are padded to a multiple
+ * of this, the partial sums of the resample kernel */
+#define RESAMPLE_TAP_ALIGN  8
+
+/* Largest up sampling factor, which limits the
+ * filter phases of rates with a small common divisor */
+#define RESAMPLE_MAX_UP     1024
+
+/* Terms of the series of the Bessel function I0 */
+#define RESAMPLE_I0_TERMS   32
+
+#endif
@@ -0,0 +1,323 @@
+/*
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License as
+ *  published by the Free Software Foundation; either version 2 of
+ *  the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details:
+ *
+ *  http://www.gnu.org/copyleft/gpl.txt
+ */
+
+#include "schedule.h"
+#include "shared.h"
+#include <ctype.h>
+#include <time.h>
+
+/* State of the reception schedule */
+static struct
+{
+  schedule_slot_t slot[ SCHEDULE_MAX_SLOTS ];
+  int num_slots;
+
+  /* Slot being received, -1 if none */
+  int active;
+
+  /* Name of the schedule file, empty if none given */
+  char file_name[ MAX_FILE_NAME ];
+
+} schedule = { .num_slots = 0, .active = -1, .file_name = "" };
+
+/*------------------------------------------------------------------------*/
+
+/* Schedule_File()
+ *
+ * Sets the schedule file to load after the xwefaxrc file
+ */
+  void
+Schedule_File( const char *file_name )
+{
+  Strlcpy( schedule.file_name, file_name, sizeof(schedule.file_name) );
+} /* Schedule_File() */
+
+/*------------------------------------------------------------------------*/
+
+/* Schedule_Load()
+ *
+ * Reads the broadcast slots of the schedule file, one per line as
+ * "HH:MM <duration min> <freq Hz> <RPM> <IOC> <name>" in UTC.
+ * Lines that cannot be read are reported and skipped
+ */
+  static gboolean
+Schedule_Load( void )
+{
+  FILE *fp;
+  char line[ LINE_BUFF_LEN + 2 ];
+  char mesg[ MESG_SIZE ];
+  int hour, min, duration, freq, ioc, name, len, num_line;
+  double rpm;
+  schedule_slot_t *slot;
+
+
+  fp = fopen( schedule.file_name, "r" );
+  if( fp == NULL )
+  {
+    perror( schedule.file_name );
+    snprintf( mesg, sizeof(mesg),
+        _("Failed to open schedule file\n%s"), schedule.file_name );
+    Show_Message( mesg, "red" );
+    Error_Dialog( mesg, OK );
+    return( FALSE );
+  }
+
+  schedule.num_slots = 0;
+  num_line = 0;
+  while( fgets(line, sizeof(line), fp) != NULL )
+  {
+    num_line++;
+
+    /* Skip comments and blank lines */
+    if( (line[0] == '#') || (strspn(line, " \t\r\n") == strlen(line)) )
+      continue;
+
+    if( schedule.num_slots == SCHEDULE_MAX_SLOTS )
+    {
+      Show_Message( _("Too many slots in schedule file"), "red" );
+      break;
+    }
+
+    /* Read the slot and check its values */
+    name = 0;
+    if( (sscanf(line, "%d:%d %d %d %lf %d %n",
+            &hour, &min, &duration, &freq, &rpm, &ioc, &name) != 6) ||
+        (hour < 0) || (hour > 23) || (min < 0) || (min > 59) ||
+        (duration < 1) || (duration > SCHEDULE_MAX_DURATION) ||
+        (freq < 1)  || (rpm < 60.0) || (rpm > 1000.0) ||
+        ((ioc != IOC288) && (ioc != IOC576)) )
+    {
+      snprintf( mesg, sizeof(mesg),
+          _("Error in schedule file line %d"), num_line );
+      Show_Message( mesg, "red" );
+      continue;
+    }
+
+    slot = &schedule.slot[ schedule.num_slots++ ];
+    slot->start    = hour * 3600 + min * 60;
+    slot->duration = duration * 60;
+    slot->freq     = freq;
+    slot->rpm      = rpm;
+    slot->ioc      = ioc;
+
+    /* The rest of the line is the station name */
+    Strlcpy( slot->name, &line[name], sizeof(slot->name) );
+    for( len = (int)strlen(slot->name) - 1; len >= 0; len-- )
+      if( !isspace((unsigned char)slot->name[len]) ) break;
+    slot->name[ len + 1 ] = '\0';
+  } /* while( fgets(line, sizeof(line), fp) != NULL ) */
+
+  fclose( fp );
+
+  snprintf( mesg, sizeof(mesg),
+      _("Schedule loaded: %d slots"), schedule.num_slots );
+  Show_Message( mesg, "black" );
+
+  return( schedule.num_slots > 0 );
+} /* Schedule_Load() */
+
+/*------------------------------------------------------------------------*/
+
+/* Schedule_Offset()
+ *
+ * Returns the seconds from the start of a slot to the UTC
+ * time of day utc, negative within the prewarm interval
+ */
+  static int
+Schedule_Offset( const schedule_slot_t *slot, int utc )
+{
+  return( (utc - slot->start + SECS_PER_DAY + SCHEDULE_PREWARM_SECS) %
+      SECS_PER_DAY - SCHEDULE_PREWARM_SECS );
+} /* Schedule_Offset() */
+
+/*------------------------------------------------------------------------*/
+
+/* Schedule_Due()
+ *
+ * Returns the index of a slot due to be received
+ * at UTC time of day utc, or -1 if there is none
+ */
+  static int
+Schedule_Due( int utc )
+{
+  int idx, offset;
+
+  for( idx = 0; idx < schedule.num_slots; idx++ )
+  {
+    offset = Schedule_Offset( &schedule.slot[idx], utc );
+    if( offset < schedule.slot[idx].duration )
+      return( idx );
+  }
+
+  return( -1 );
+} /* Schedule_Due() */
+
+/*------------------------------------------------------------------------*/
+
+/* Schedule_Begin()
+ *
+ * Configures the decoder for a slot, tunes the receiver and starts
+ * reception, so that the sound card or Perseus is opened and the
+ * decoder is listening for the Start Tone before the slot starts
+ */
+  static void
+Schedule_Begin( int idx )
+{
+  schedule_slot_t *slot = &schedule.slot[ idx ];
+  GtkToggleButton *start;
+  GtkLabel *label;
+  char mesg[ MESG_SIZE ];
+
+
+  schedule.active = idx;
+
+  /* Wefax parameters of the slot */
+  rc_data.station_freq  = slot->freq;
+  rc_data.lines_per_min = slot->rpm;
+  rc_data.ioc_value     = slot->ioc;
+  if( slot->ioc == IOC576 )
+  {
+    rc_data.start_tone      = IOC576_START_TONE;
+    rc_data.pixels_per_line = PIX1200;
+  }
+  else
+  {
+    rc_data.start_tone      = IOC288_START_TONE;
+    rc_data.pixels_per_line = PIX600;
+  }
+
+  /* Period of start and stop tones in pixels */
+  double temp = rc_data.lines_per_min / 60.0; /* lines/sec */
+  rc_data.start_tone_period =
+    temp * (double)rc_data.pixels_per_line / (double)rc_data.start_tone;
+  rc_data.stop_tone_period =
+    temp * (double)rc_data.pixels_per_line / (double)WEFAX_STOP_TONE;
+
+  Configure();
+  Set_Menu_Items();
+
+  /* Set the label of wefax image frame */
+  label = GTK_LABEL( Builder_Get_Object(main_window_builder, "image_label") );
+  gtk_label_set_text( label, slot->name );
+
+  snprintf( mesg, sizeof(mesg), _("Scheduled %s at %02d:%02d UTC"),
+      slot->name, slot->start / 3600, (slot->start / 60) % 60 );
+  Show_Message( mesg, "green" );
+
+  /* Set Rx freq and mode */
+  g_idle_add( Set_Rx_Freq_Idle_Cb, NULL );
+
+  /* Start reception unless already receiving */
+  start = GTK_TOGGLE_BUTTON(
+      Builder_Get_Object(main_window_builder, "start_togglebutton") );
+  if( !gtk_toggle_button_get_active(start) )
+    gtk_toggle_button_set_active( start, TRUE );
+
+} /* Schedule_Begin() */
+
+/*------------------------------------------------------------------------*/
+
+/* Schedule_End()
+ *
+ * Stops reception at the end of a slot, which
+ * closes the sound card or Perseus and CAT
+ */
+  static void
+Schedule_End( void )
+{
+  GtkToggleButton *start;
+
+  schedule.active = -1;
+  start = GTK_TOGGLE_BUTTON(
+      Builder_Get_Object(main_window_builder, "start_togglebutton") );
+  gtk_toggle_button_set_active( start, FALSE );
+  Show_Message( _("Scheduled slot ended"), "black" );
+
+} /* Schedule_End() */
+
+/*------------------------------------------------------------------------*/
+
+/* Schedule_Tick()
+ *
+ * Timeout callback that starts and stops reception by the schedule
+ */
+  static gboolean
+Schedule_Tick( gpointer data )
+{
+  schedule_slot_t *slot;
+  struct tm tm;
+  time_t now;
+  int utc, offset, due;
+  gboolean decoding;
+
+
+  now = time( NULL );
+  gmtime_r( &now, &tm );
+  utc = tm.tm_hour * 3600 + tm.tm_min * 60 + tm.tm_sec;
+  due = Schedule_Due( utc );
+
+  /* Nothing to do while the active slot is on */
+  if( schedule.active >= 0 )
+  {
+    slot   = &schedule.slot[ schedule.active ];
+    offset = Schedule_Offset( slot, utc );
+    if( offset < slot->duration ) return( TRUE );
+
+    /* Let an image being decoded complete */
+    decoding = isFlagClear( RECEIVE_STOP ) &&
+      ( (wefax_action == ACTION_PHASING) ||
+        (wefax_action == ACTION_DECODE) );
+    if( decoding && (offset < slot->duration + SCHEDULE_OVERRUN_SECS) )
+      return( TRUE );
+
+    /* Go on to a slot that follows at once, without closing the
+     * devices, unless an image is still being decoded. Else stop and
+     * let Wefax_Control() close them before the next slot is begun */
+    if( (due >= 0) && !decoding && isFlagClear(RECEIVE_STOP) )
+    {
+      Schedule_Begin( due );
+      return( TRUE );
+    }
+
+    Schedule_End();
+    return( TRUE );
+  } /* if( schedule.active >= 0 ) */
+
+  /* Begin a slot once Wefax_Control() has stopped reception */
+  if( (due >= 0) &&
+      (isFlagClear(RECEIVE_STOP) || (wefax_action == ACTION_STOP)) )
+    Schedule_Begin( due );
+
+  return( TRUE );
+} /* Schedule_Tick() */
+
+/*------------------------------------------------------------------------*/
+
+/* Schedule_Start()
+ *
+ * Idle callback that loads the schedule file, if one was given,
+ * and starts the timer that receives its slots unattended
+ */
+  gboolean
+Schedule_Start( gpointer data )
+{
+  if( schedule.file_name[0] == '\0' ) return( FALSE );
+
+  if( Schedule_Load() )
+    g_timeout_add( SCHEDULE_TICK_MSEC, Schedule_Tick, NULL );
+
+  return( FALSE );
+} /* Schedule_Start() */
+
+/*------------------------------------------------------------------------*/
@@ -0,0 +1,55 @@
+/*
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License as
+ *  published by the Free Software Foundation; either version 2 of
+ *  the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details:
+ *
+ *  http://www.gnu.org/copyleft/gpl.txt
+ */
+
+#ifndef SCHEDULE_H
+#define SCHEDULE_H    1
+
+#include "common.h"
+#include "stations.h"
+
+/* Maximum number of broadcast slots in a schedule file */
+#define SCHEDULE_MAX_SLOTS      256
+
+/* Reception is started this many seconds before a slot, so
+ * the receiver, sound card and decoder are up at its start */
+#define SCHEDULE_PREWARM_SECS   10
+
+/* An image still being decoded at the end of its slot
+ * is given up to this many seconds more to complete */
+#define SCHEDULE_OVERRUN_SECS   300
+
+/* Longest slot accepted, in minutes */
+#define SCHEDULE_MAX_DURATION   720
+
+/* Period of the schedule timer in mSec */
+#define SCHEDULE_TICK_MSEC      1000
+
+#define SECS_PER_DAY            86400
+
+/* A broadcast slot of the schedule, repeated daily */
+typedef struct
+{
+  int
+    start,      /* Start time in seconds of the UTC day */
+    duration,   /* Duration of the slot in seconds */
+    freq,       /* Receiver frequency in Hz */
+    ioc;        /* IOC value of the charts */
+
+  double rpm;   /* Lines per minute of the charts */
+
+  char name[ STATIONS_NAME_WIDTH + 1 ];
+
+} schedule_slot_t;
+
+#endif
@@ -17,32 +17,21 @@
 /* Runtime config data */
 rc_data_t rc_data;
 
-/* Pixel buffer */
-guchar *pixel_buf;
-
-/* Pixel buffer for display */
-GdkPixbuf *wefax_pixbuf = NULL;
+/* DSP kernels selected for the CPU */
+const dsp_kernels_t *DSP_Kernels = NULL;
 
 /* Buffer for pixels of one image line */
 unsigned char *line_buffer = NULL;
 int line_count;
 int linebuff_input, linebuff_output;
 
-/* dft in/out buffers */
-int
-  *dft_in_r  = NULL,
-  *dft_out_r = NULL,
-  *dft_out_i = NULL;
-
-/* Pixbuf rowstride and num of channels */
-gint rowstride, n_channels;
-
 /* Tree list store and treeview for stations window */
 GtkListStore *stations_list_store = NULL;
 GtkTreeView  *stations_treeview   = NULL;
 
 GtkWidget
   *stations_window      = NULL, /* Stations tree list window */
+  *perf_window          = NULL, /* Performance counters window */
   *popup_menu           = NULL, /* Popup main menu */
   *main_window          = NULL, /* Xwefax's top window */
   *scope_drawingarea    = NULL, /* Signal Scope widget */
@@ -54,6 +43,7 @@ GtkWidget
 /* Gtk builders for some above that need to be global */
 GtkBuilder
   *stations_window_builder = NULL,
+  *perf_window_builder     = NULL,
   *popup_menu_builder      = NULL,
   *main_window_builder     = NULL;
 
@@ -78,9 +68,6 @@ int
 /* Text buffer for text view */
 GtkTextBuffer *text_buffer = NULL;
 
-/* Pixbuf rowstride and num of channels */
-gint rowstride, n_channels;
-
 /* Image files name  */
 char image_file[MAX_FILE_NAME];
 
@@ -21,34 +21,18 @@
 /* Runtime config data */
 extern rc_data_t rc_data;
 
-/* Pixel buffer */
-extern guchar *pixel_buf;
-
-/* Pixel buffer for display */
-extern GdkPixbuf *wefax_pixbuf;
-
 /* Buffer for pixels of one image line */
 extern unsigned char *line_buffer;
 extern int line_count;
 extern int linebuff_input, linebuff_output;
 
-/* dft in/out buffers */
-extern int
-  *dft_in_r,
-  *dft_out_r,
-  *dft_out_i;
-
-/* Pixbuf rowstride and num of channels */
-extern gint
-  rowstride,
-  n_channels;
-
 /* Tree list store */
 extern GtkListStore *stations_list_store;
 extern GtkTreeView  *stations_treeview;
 
 extern GtkWidget
   *stations_window,      /* Stations list window */
+  *perf_window,          /* Performance counters window */
   *popup_menu,           /* Popup main menu */
   *main_window,          /* xwefax's top window */
   *scope_drawingarea,    /* Signal scope widget */
@@ -60,6 +44,7 @@ extern GtkWidget
 /* Gtk builders for some above that need to be global */
 extern GtkBuilder
   *stations_window_builder,
+  *perf_window_builder,
   *popup_menu_builder,
   *main_window_builder;
 
@@ -81,11 +66,6 @@ extern int gauge_input, gauge_level1, gauge_level2;
 /* Text buffer for text view */
 extern GtkTextBuffer *text_buffer;
 
-/* Pixbuf rowstride and num of channels */
-extern gint
-  rowstride,
-  n_channels;
-
 /* Image files name  */
 extern char image_file[MAX_FILE_NAME];
 
@@ -98,6 +78,9 @@ extern int *bin_ave;
 /* What action the WEFAX decoder should enter */
 extern int wefax_action;
 
+/* DSP kernels selected for the CPU */
+extern const dsp_kernels_t *DSP_Kernels;
+
 /* Fm Detector function pointer */
 extern gboolean ( *FM_Detector ) ( unsigned char *level );
 
@@ -105,7 +88,6 @@ extern gboolean ( *FM_Detector ) ( unsigned char *level );
 extern sem_t pback_semaphore;
 
 #define SCOPE_BACKGND   0.0, 0.3, 0.0
-#define PIXBUF_BACKGND  0xb0b0b0ff
 
 #endif
 
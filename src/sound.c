@@ -17,11 +17,31 @@
 
 static int
   recv_buffer_size, /* Recv DSP signal samples buffer   */
-  recv_buffer_idx;  /* Index to Rx signal samples buffer*/
+  recv_buffer_idx,  /* Index to Rx signal samples buffer*/
+  signal_len;       /* Length of signal samples buffer  */
 
 /* Receive samples buffer */
 static short *recv_buffer = NULL;
 
+/* Samples of the channel in use and of the other channel,
+ * split from the receive buffer in stereo mode, or served
+ * by another instance to a client */
+static short *chn_buffer = NULL, *other_buffer = NULL;
+
+/* Samples captured at the capture rate, the receive buffer
+ * in mono mode else the channel in use, or a span of a
+ * recording mapped for replay */
+static const short *capture_buffer = NULL;
+
+/* Signal samples, those captured or resampled from them */
+static const short *signal_buffer = NULL;
+
+/* Resamplers of the channel in use and of the other channel
+ * from the capture rate to the DSP rate, and their output */
+static resampler_t signal_resampler, other_resampler;
+static short *resample_buffer = NULL, *other_resample_buffer = NULL;
+static gboolean resample_signal = FALSE;
+
 /* ALSA pcm capture and mixer handles */
 static snd_pcm_t *capture_handle  = NULL;
 static snd_mixer_t *mixer_handle  = NULL;
@@ -93,11 +113,11 @@ Open_PCM(
 
   /* Set sample rate */
   *error = snd_pcm_hw_params_set_rate(
-      *handle, hw_params, (unsigned int)rc_data.dsp_rate, EXACT_VAL );
+      *handle, hw_params, (unsigned int)rc_data.capture_rate, EXACT_VAL );
   if( *error < 0 )
   {
     snprintf( mesg, MESG_SIZE,
-        _("Cannot set sample rate to %d"), rc_data.dsp_rate );
+        _("Cannot set sample rate to %d"), rc_data.capture_rate );
     return( FALSE );
   }
 
@@ -317,6 +337,46 @@ Set_Capture_Level( int level, char *mesg, int *error )
 
 /*------------------------------------------------------------------------*/
 
+/* Open_Resampler()
+ *
+ * Sets up the resampling of the captured samples to the
+ * DSP rate, if the capture rate differs. Samples served
+ * by another instance are already at the DSP rate
+ */
+  static gboolean
+Open_Resampler( char *mesg )
+{
+  size_t alloc;
+
+  resample_signal = ( rc_data.capture_rate != rc_data.dsp_rate ) &&
+    isFlagClear( CHANNEL_CLIENT );
+  if( !resample_signal ) return( TRUE );
+
+  if( !Resample_Init(&signal_resampler,
+        rc_data.capture_rate, rc_data.dsp_rate, PERIOD_SIZE) ||
+      ((rc_data.num_chn == 2) && isFlagClear(FILE_SOURCE) &&
+       !Resample_Init(&other_resampler,
+         rc_data.capture_rate, rc_data.dsp_rate, PERIOD_SIZE)) )
+  {
+    snprintf( mesg, MESG_SIZE,
+        _("Cannot resample %d to %d samples/sec"),
+        rc_data.capture_rate, rc_data.dsp_rate );
+    return( FALSE );
+  }
+
+  alloc = (size_t)signal_resampler.max_out * sizeof(short);
+  if( !mem_realloc((void **)&resample_buffer, alloc) ||
+      !mem_realloc((void **)&other_resample_buffer, alloc) )
+  {
+    Strlcat( mesg, _("Memory allocation failed - Quit"), MESG_SIZE );
+    return( FALSE );
+  }
+
+  return( TRUE );
+} /* Open_Resampler() */
+
+/*------------------------------------------------------------------------*/
+
 /* Open_Capture()
  *
  * Opens sound card for Capture
@@ -324,9 +384,48 @@ Set_Capture_Level( int level, char *mesg, int *error )
   gboolean
 Open_Capture( char *mesg, int *error )
 {
+  size_t alloc;
+
   /* Return if Capture is setup */
   if( isFlagSet(CAPTURE_SETUP) ) return( TRUE );
 
+  /* Index to signal samples buffer (set to end) */
+  signal_len = PERIOD_SIZE;
+  recv_buffer_idx = signal_len;
+
+  /* Resample to the DSP rate if captured at another */
+  *error = 0;
+  if( !Open_Resampler(mesg) ) return( FALSE );
+
+  /* Take samples from the recording mapped for replay */
+  if( isFlagSet(FILE_SOURCE) )
+  {
+    Replay_Attach();
+    Show_Message( _("Replaying recording ..."), "green" );
+    SetFlag( CAPTURE_SETUP );
+    return( TRUE );
+  }
+
+  /* Take samples from the instance serving the channel */
+  if( isFlagSet(CHANNEL_CLIENT) )
+  {
+    if( !Channel_Attach(mesg) ) return( FALSE );
+
+    alloc = PERIOD_SIZE * sizeof(short);
+    if( (chn_buffer == NULL) &&
+        !mem_alloc((void **)&chn_buffer, alloc) )
+    {
+      Strlcat( mesg, _("Memory allocation failed - Quit"), MESG_SIZE );
+      return( FALSE );
+    }
+    capture_buffer = chn_buffer;
+
+    Show_Message( _("Attached to served channel OK"), "green" );
+    Record_Source( 1, 16, rc_data.dsp_rate );
+    SetFlag( CAPTURE_SETUP );
+    return( TRUE );
+  } /* if( isFlagSet(CHANNEL_CLIENT) ) */
+
   /* Open & setup pcm for Capture */
   Show_Message( _("Opening Capture Device ..."), "black" );
   if( !Open_PCM(
@@ -338,26 +437,44 @@ Open_Capture( char *mesg, int *error )
   /* Size of receive samples buffer in 'shorts' */
   recv_buffer_size = PERIOD_SIZE * rc_data.num_chn;
 
-  /* Index to recv samples buffer (set to end) */
-  recv_buffer_idx = recv_buffer_size;
+  /* Allocate memory to receive samples buffer,
+   * its size changes with stereo/mono mode */
+  alloc = (size_t)recv_buffer_size * sizeof(short);
+  if( !mem_realloc((void **)&recv_buffer, alloc) )
+  {
+    Strlcat( mesg, _("Memory allocation failed - Quit"), MESG_SIZE );
+    return( FALSE );
+  }
+  memset( recv_buffer, 0, alloc );
 
-  /* Allocate memory to receive samples buffer */
-  if( recv_buffer == NULL )
+  /* Channel buffers in stereo mode, the other
+   * channel is served to another instance */
+  if( rc_data.num_chn == 2 )
   {
-    size_t alloc = (size_t)recv_buffer_size * sizeof(short);
-    if( !mem_alloc((void **)&recv_buffer, alloc) )
+    alloc = PERIOD_SIZE * sizeof(short);
+    if( ((chn_buffer == NULL) &&
+          !mem_alloc((void **)&chn_buffer, alloc)) ||
+        ((other_buffer == NULL) &&
+         !mem_alloc((void **)&other_buffer, alloc)) )
     {
       Strlcat( mesg, _("Memory allocation failed - Quit"), MESG_SIZE );
       return( FALSE );
     }
-    memset( recv_buffer, 0, alloc );
+    capture_buffer = chn_buffer;
+
+    if( !Channel_Serve_Open(1 - rc_data.use_chn, rc_data.dsp_rate) )
+      Show_Message( _("Failed to serve the other channel"), "red" );
   }
+  else capture_buffer = recv_buffer;
 
   /* Open mixer & set playback voulume, abort on failure.
    * Failure to set volume level is not considered fatal */
   if( !Open_Mixer(mesg, error) ) return( FALSE );
   Set_Capture_Level( rc_data.cap_lev, mesg, error );
   Show_Message( _("Capture Device opened OK"), "green" );
+
+  /* Record the audio of the channel in use */
+  Record_Source( 1, 16, rc_data.dsp_rate );
   SetFlag( CAPTURE_SETUP );
 
   return( TRUE );
@@ -400,6 +517,8 @@ Close_Capture( void )
   hw_params = NULL;
 
   Close_Mixer();
+  Channel_Close();
+  Record_Source( 0, 0, 0 );
 
   ClearFlag(CAPTURE_SETUP);
 } /* Close_Capture() */
@@ -452,6 +571,56 @@ Xrun_Recovery( snd_pcm_t *handle, int error )
 
 /*------------------------------------------------------------------------*/
 
+/* Sound_Read_Period()
+ *
+ * Reads a period of audio samples from the sound card. In
+ * stereo mode both channels are split from it in one pass,
+ * the other channel is served to another xwefax instance
+ */
+  static gboolean
+Sound_Read_Period( void )
+{
+  snd_pcm_sframes_t error;
+  int idx, other, len;
+
+  /* Read audio samples from DSP, abort on error */
+  PERF_BEGIN( PERF_SOUND_READ );
+  error = snd_pcm_readi( capture_handle, recv_buffer, PERIOD_SIZE );
+  PERF_END( PERF_SOUND_READ );
+  if( error != PERIOD_SIZE )
+  {
+    fprintf( stderr, "xwefax: Signal_Sample(): %s\n",
+        snd_strerror((int)error) );
+
+    /* Try to recover from error */
+    if( !Xrun_Recovery(capture_handle, (int)error) )
+      return( FALSE );
+  } /* if( error  ) */
+
+  /* Split channels and serve the other one, at the DSP rate */
+  if( rc_data.num_chn == 2 )
+  {
+    other = 1 - rc_data.use_chn;
+    for( idx = 0; idx < PERIOD_SIZE; idx++ )
+    {
+      chn_buffer[idx]   = recv_buffer[2 * idx + rc_data.use_chn];
+      other_buffer[idx]  = recv_buffer[2 * idx + other];
+    }
+
+    if( resample_signal )
+    {
+      len = Resample( &other_resampler,
+          other_buffer, PERIOD_SIZE, other_resample_buffer );
+      Channel_Serve( other, other_resample_buffer, len );
+    }
+    else Channel_Serve( other, other_buffer, PERIOD_SIZE );
+  }
+
+  return( TRUE );
+} /* Sound_Read_Period() */
+
+/*------------------------------------------------------------------------*/
+
 /*  Signal_Sample()
  *
  *  Gets the next DSP sample of the signal input.
@@ -460,33 +629,64 @@ Xrun_Recovery( snd_pcm_t *handle, int error )
   gboolean
 Sound_Signal_Sample( short *sample_val )
 {
-  snd_pcm_sframes_t error;
-
   /* Three consecutive signal samples */
   static int s1 = 0, s2 = 0, s3 = 0;
 
-  /* Refill recv DSP samples buffer when needed */
-  if( recv_buffer_idx >= recv_buffer_size )
+  /* Replay the signal heard in standby first */
+  if( Standby_Replay(sample_val) ) return( TRUE );
+
+  /* Take samples from the signal synthesizer if enabled */
+  if( isFlagSet(SYNTH_SOURCE) )
   {
-    /* Read audio samples from DSP, abort on error */
-    error = snd_pcm_readi( capture_handle, recv_buffer, PERIOD_SIZE );
-    if( error != PERIOD_SIZE )
-    {
-      fprintf( stderr, "xwefax: Signal_Sample(): %s\n",
-          snd_strerror((int)error) );
+    if( !Synth_Sample(sample_val) ) return( FALSE );
+    if( isFlagSet(AFC_ENABLE) ) Afc_Shift( sample_val );
+    DFT_Input_Data( *sample_val );
+    return( TRUE );
+  }
 
-      /* Try to recover from error */
-      if( !Xrun_Recovery(capture_handle, (int)error) )
+  /* Refill signal samples buffer when needed. A short span
+   * of a recording may resample to no samples, so refill
+   * until there are some */
+  while( recv_buffer_idx >= signal_len )
+  {
+    /* Take a span of the recording replayed */
+    if( isFlagSet(FILE_SOURCE) )
+    {
+      capture_buffer = Replay_Span( &signal_len );
+      if( capture_buffer == NULL ) return( FALSE );
+    }
+    else
+    {
+      /* Read the samples served by another instance */
+      if( isFlagSet(CHANNEL_CLIENT) )
+      {
+        if( !Channel_Read(chn_buffer, PERIOD_SIZE) )
+          return( FALSE );
+      }
+      else if( !Sound_Read_Period() )
         return( FALSE );
-    } /* if( error  ) */
+      signal_len = PERIOD_SIZE;
+    }
+
+    /* Resample to the DSP rate */
+    if( resample_signal )
+    {
+      signal_len = Resample( &signal_resampler,
+          capture_buffer, signal_len, resample_buffer );
+      signal_buffer = resample_buffer;
+    }
+    else signal_buffer = capture_buffer;
+    PERF_CAPTURE( Perf_Clock(), signal_len );
+    recv_buffer_idx = 0;
 
-    /* Start buffer index according to stereo/mono mode */
-    recv_buffer_idx = rc_data.use_chn;
+    /* Tee the samples to the recording */
+    if( isFlagSet(RECORD_SIGNAL) )
+      Record_Samples( signal_buffer, signal_len );
 
-  } /* End of if( recv_buffer_idx >= recv_buffer_size ) */
+  } /* End of while( recv_buffer_idx >= signal_len ) */
 
   /* Get next signal sample */
-  s3 = (int)recv_buffer[recv_buffer_idx];
+  s3 = (int)signal_buffer[recv_buffer_idx];
 
   /* There seems to be a glitch somewhere in my sound system
    * which produces a rogue DSP sample from time to time, that
@@ -504,121 +704,11 @@ Sound_Signal_Sample( short *sample_val )
   s1 = s2;
   s2 = s3;
 
-  /* Increment according to mono/stereo mode */
-  recv_buffer_idx += rc_data.num_chn;
-
-  /* Produces simulated alternate black/white lines
-  {
-    static double ww = M_2PI * 2300.0 / 48000.0;
-    static double wb = M_2PI * 1500.0 / 48000.0;
-    static double w = 0.0;
-    static int cn = 2400 * 20;
-    static int idx = 0, lc = 0;
+  recv_buffer_idx++;
+  PERF_SAMPLE();
 
-    if( lc )
-    {
-      idx++;
-      if( idx >= cn )
-      {
-        idx = 0;
-        lc = 0;
-      }
-      *sample_val = (short)( 30000.0 * sin(w) );
-      w += ww;
-      if( w > M_2PI ) w -= M_2PI;
-    }
-    else
-    {
-      idx++;
-      if( idx >= cn )
-      {
-        idx = 0;
-        lc = 1;
-      }
-      *sample_val = (short)(30000.0 * sin(w));
-      w += wb;
-      if( w > M_2PI ) w -= M_2PI;
-    }
-  } */
-
-  /* Produces simulated phasing lines
-  {
-    static double ww = M_2PI * 2300.0 / 48000.0;
-    static double wb = M_2PI * 1500.0 / 48000.0;
-    static double w = 0.0;
-    static int cn1 = 55 * 20;
-    static int cn2 = 1145 * 20;
-    static int idx = 0, lc = 0;
-
-    if( lc )
-    {
-      idx++;
-      if( idx >= cn1 )
-      {
-        idx = 0;
-        lc = 0;
-      }
-      *sample_val = (short)( 30000.0 * sin(w) );
-      w += ww;
-      if( w > M_2PI ) w -= M_2PI;
-    }
-    else
-    {
-      idx++;
-      if( idx >= cn2 )
-      {
-        idx = 0;
-        lc = 1;
-      }
-      *sample_val = (short)(30000.0 * sin(w));
-      w += wb;
-      if( w > M_2PI ) w -= M_2PI;
-    }
-  } */
-
-  /* Produces a checkerboard pattern
-  {
-    static double ww = M_2PI * 2300.0 / 48000.0;
-    static double wb = M_2PI * 1500.0 / 48000.0;
-    static double w = 0.0;
-    static int idx = 0, col = 0, pix = 0;
-    double npix = 2;
-
-    if( col )
-    {
-      *sample_val = (short)( 30000.0 * sin(w) );
-      w += ww;
-      if( w > M_2PI ) w -= M_2PI;
-
-      idx++;
-      if( (double)idx >= npix * (double)rc_data.pixel_len )
-      {
-        idx = 0;
-        col = 0;
-        pix++;
-      }
-    }
-    else
-    {
-      *sample_val = (short)( 30000.0 * sin(w) );
-      w += wb;
-      if( w > M_2PI ) w -= M_2PI;
-
-      idx++;
-      if( (double)idx >= npix * (double)rc_data.pixel_len )
-      {
-        idx = 0;
-        col = 1;
-        pix++;
-      }
-    }
-    if( pix >= rc_data.pixels_per_line )
-    {
-      pix = 0;
-      if( col ) col = 0;
-      else col = 1;
-    }
-  } */
+  /* Correct the frequency offset of the signal */
+  if( isFlagSet(AFC_ENABLE) ) Afc_Shift( sample_val );
 
   /* Decimate sample values for the DFT */
   DFT_Input_Data( *sample_val );
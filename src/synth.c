@@ -0,0 +1,269 @@
+/*
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License as
+ *  published by the Free Software Foundation; either version 2 of
+ *  the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details:
+ *
+ *  http://www.gnu.org/copyleft/gpl.txt
+ */
+#include "synth.h"
+#include "shared.h"
+
+/* Parameters of current transmission */
+static synth_params_t synth;
+
+/* Duration of a line in samples, start sample of each
+ * segment and index of current sample in transmission */
+static double samples_per_line;
+static long
+  segment_start[ SEGMENT_DONE + 1 ],
+  sample_idx = 0;
+
+/* Phase of FM carrier and fading oscillator */
+static double carrier_phase, fade_phase;
+
+/* Standard deviation of noise and state of its generator */
+static double noise_sigma, noise_spare;
+static uint32_t noise_state;
+static gboolean have_spare;
+
+/*------------------------------------------------------------------------*/
+
+/* Noise()
+ *
+ * Returns a sample of gaussian noise of unit deviation,
+ * from a seeded xorshift generator and Box-Muller method
+ */
+  static double
+Noise( void )
+{
+  double u1, u2, mag;
+
+  if( have_spare )
+  {
+    have_spare = FALSE;
+    return( noise_spare );
+  }
+
+  do
+  {
+    noise_state ^= noise_state << 13;
+    noise_state ^= noise_state >> 17;
+    noise_state ^= noise_state << 5;
+    u1 = (double)noise_state / 4294967296.0;
+  }
+  while( u1 <= 0.0 );
+
+  noise_state ^= noise_state << 13;
+  noise_state ^= noise_state >> 17;
+  noise_state ^= noise_state << 5;
+  u2 = (double)noise_state / 4294967296.0;
+
+  mag = sqrt( -2.0 * log(u1) );
+  noise_spare = mag * sin( M_2PI * u2 );
+  have_spare = TRUE;
+
+  return( mag * cos(M_2PI * u2) );
+} /* Noise() */
+
+/*------------------------------------------------------------------------*/
+
+/* Synth_Init()
+ *
+ * Sets up the synthesizer for a new transmission
+ */
+  void
+Synth_Init( const synth_params_t *params )
+{
+  double len;
+  int seg;
+
+  synth = *params;
+  samples_per_line = (double)synth.sample_rate * 60.0 / synth.lines_per_min;
+  samples_per_line *= 1.0 + synth.clock_error;
+
+  /* Start sample of each segment of the transmission */
+  segment_start[ SEGMENT_START ] = 0;
+  for( seg = SEGMENT_START; seg < SEGMENT_DONE; seg++ )
+  {
+    switch( seg )
+    {
+      case SEGMENT_START:
+        len = SYNTH_START_SECS * (double)synth.sample_rate;
+        break;
+      case SEGMENT_PHASING:
+        len = synth.phasing_lines * samples_per_line;
+        break;
+      case SEGMENT_IMAGE:
+        len = synth.image_lines * samples_per_line;
+        break;
+      case SEGMENT_STOP:
+        len = SYNTH_STOP_SECS * (double)synth.sample_rate;
+        break;
+      default:
+        len = SYNTH_BLACK_SECS * (double)synth.sample_rate;
+    }
+    segment_start[ seg + 1 ] = segment_start[ seg ] + (long)len;
+  }
+
+  /* Noise deviation for the SNR over the signal's power */
+  if( synth.snr < SYNTH_NO_NOISE )
+    noise_sigma = SYNTH_AMPLITUDE / sqrt( 2.0 ) * pow( 10.0, -synth.snr / 20.0 );
+  else
+    noise_sigma = 0.0;
+  noise_state = SYNTH_NOISE_SEED;
+  have_spare  = FALSE;
+
+  sample_idx    = 0;
+  carrier_phase = 0.0;
+  fade_phase    = 0.0;
+
+} /* Synth_Init() */
+
+/*------------------------------------------------------------------------*/
+
+/* Synth_Pixel()
+ *
+ * Returns the level of a pixel of the image content
+ */
+  unsigned char
+Synth_Pixel( int line, int pixel )
+{
+  /* Black in-image phasing pulse at start of lines */
+  if( pixel < PHASING_PULSE_LEN ) return( 0 );
+
+  switch( synth.pattern )
+  {
+    case PATTERN_LINES:
+      return( (line / SYNTH_BAND_LINES) & 1 ? 255 : 0 );
+
+    case PATTERN_CHECKER:
+      return( ((line / SYNTH_CHECKER_SIZE) +
+            (pixel / SYNTH_CHECKER_SIZE)) & 1 ? 255 : 0 );
+
+    case PATTERN_GRADIENT:
+      return( (unsigned char)( 255 * (pixel - PHASING_PULSE_LEN) /
+            (synth.pixels_per_line - PHASING_PULSE_LEN - 1) ) );
+  }
+
+  return( 0 );
+} /* Synth_Pixel() */
+
+/*------------------------------------------------------------------------*/
+
+/* Synth_Segment()
+ *
+ * Returns the segment of the transmission being synthesized
+ */
+  int
+Synth_Segment( void )
+{
+  int seg;
+
+  for( seg = SEGMENT_START; seg < SEGMENT_DONE; seg++ )
+    if( sample_idx < segment_start[seg + 1] )
+      break;
+
+  return( seg );
+} /* Synth_Segment() */
+
+/*------------------------------------------------------------------------*/
+
+/* Synth_Length()
+ *
+ * Returns the length of the transmission in samples
+ */
+  long
+Synth_Length( void )
+{
+  return( segment_start[SEGMENT_DONE] );
+} /* Synth_Length() */
+
+/*------------------------------------------------------------------------*/
+
+/* Synth_Sample()
+ *
+ * Returns the next sample of the synthetic transmission,
+ * FALSE when the transmission has ended
+ */
+  gboolean
+Synth_Sample( short *sample_val )
+{
+  static int seg = SEGMENT_START;
+  double pos, tone, freq, gain, val;
+  int level, line;
+
+  if( sample_idx >= segment_start[SEGMENT_DONE] )
+    return( FALSE );
+
+  /* Current segment and position in it */
+  while( sample_idx < segment_start[seg] ) seg--;
+  while( sample_idx >= segment_start[seg + 1] ) seg++;
+  pos = (double)( sample_idx - segment_start[seg] );
+
+  /* Pixel level of the current sample */
+  switch( seg )
+  {
+    case SEGMENT_START: /* Black-white alternation at start tone */
+      tone = ( synth.ioc_value == 288 ) ?
+        IOC288_START_TONE : IOC576_START_TONE;
+      level = (long)( 2.0 * tone * pos / synth.sample_rate ) & 1 ? 255 : 0;
+      break;
+
+    case SEGMENT_PHASING: /* White phasing pulse on black lines */
+      line  = (int)( pos / samples_per_line );
+      pos  -= line * samples_per_line;
+      level = pos * synth.pixels_per_line / samples_per_line <
+        PHASING_PULSE_LEN ? 255 : 0;
+      break;
+
+    case SEGMENT_IMAGE:
+      line  = (int)( pos / samples_per_line );
+      pos  -= line * samples_per_line;
+      level = Synth_Pixel( line,
+          (int)(pos * synth.pixels_per_line / samples_per_line) );
+      break;
+
+    case SEGMENT_STOP: /* Black-white alternation at stop tone */
+      level = (long)( 2.0 * WEFAX_STOP_TONE * pos / synth.sample_rate )
+        & 1 ? 255 : 0;
+      break;
+
+    default:
+      level = 0;
+  }
+
+  /* Frequency modulate the carrier by pixel level */
+  freq  = synth.black_freq + synth.freq_offset +
+    (double)( synth.white_freq - synth.black_freq ) * level / 255.0;
+  carrier_phase += M_2PI * freq / synth.sample_rate;
+  if( carrier_phase >= M_2PI ) carrier_phase -= M_2PI;
+
+  /* Slow amplitude fading */
+  gain = 1.0;
+  if( synth.fade_freq > 0.0 )
+  {
+    gain -= SYNTH_FADE_DEPTH * 0.5 * ( 1.0 - cos(fade_phase) );
+    fade_phase += M_2PI * synth.fade_freq / synth.sample_rate;
+    if( fade_phase >= M_2PI ) fade_phase -= M_2PI;
+  }
+
+  val = SYNTH_AMPLITUDE * gain * sin( carrier_phase );
+  if( noise_sigma > 0.0 ) val += noise_sigma * Noise();
+
+  /* Clip to range of samples */
+  if( val >  32767.0 ) val =  32767.0;
+  if( val < -32768.0 ) val = -32768.0;
+  *sample_val = (short)val;
+
+  sample_idx++;
+  return( TRUE );
+} /* Synth_Sample() */
+
+/*------------------------------------------------------------------------*/
+
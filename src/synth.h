@@ -0,0 +1,41 @@
+/*
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License as
+ *  published by the Free Software Foundation; either version 2 of
+ *  the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details:
+ *
+ *  http://www.gnu.org/copyleft/gpl.txt
+ */
+#ifndef SYNTH_H
+#define SYNTH_H     1
+
+#include "common.h"
+
+/* Duration of start tone, stop tone and
+ * of the black signal after it, in seconds */
+#define SYNTH_START_SECS    5
+#define SYNTH_STOP_SECS     5
+#define SYNTH_BLACK_SECS    10
+
+/* Peak amplitude of synthesized signal, with headroom for noise */
+#define SYNTH_AMPLITUDE     16000.0
+
+/* Depth of amplitude fading, as a fraction of the amplitude */
+#define SYNTH_FADE_DEPTH    0.5
+
+/* Lines in each band of the alternate lines pattern */
+#define SYNTH_BAND_LINES    20
+
+/* Size of squares in checkerboard pattern, in pixels */
+#define SYNTH_CHECKER_SIZE  16
+
+/* Seed of noise generator, for reproducible signals */
+#define SYNTH_NOISE_SEED    0x5eed1234u
+
+#endif
+
@@ -14,6 +14,35 @@
 
 #include "utils.h"
 
+/* Offset in xwefaxrc of the spectrum settings, 0 if not loaded */
+static long spectrum_offset = 0;
+
+/* Spectrum settings selectable in the menu */
+static const int
+  fft_sizes[ NUM_FFT ]    = { FFT512, FFT1024, FFT2048, FFT4096 },
+  fft_windows[ NUM_WIN ]  =
+  { WINDOW_RECTANGULAR, WINDOW_HANN, WINDOW_BLACKMAN_HARRIS },
+  fft_overlaps[ NUM_OVL ] = { OVL0, OVL50, OVL75 },
+  fft_averages[ NUM_AVE ] = { AVE1, AVE2, AVE4, AVE8, AVE16 };
+
+/*------------------------------------------------------------------*/
+
+/* Value_Index()
+ *
+ * Returns the index of a value in a list of values, or -1 if none
+ */
+  static int
+Value_Index( int value, const int *values, int num )
+{
+  int idx;
+
+  for( idx = 0; idx < num; idx++ )
+    if( values[idx] == value )
+      return( idx );
+
+  return( -1 );
+} /* Value_Index() */
+
 /*------------------------------------------------------------------*/
 
 /*  Load_Line()
@@ -214,10 +243,13 @@ Load_Config( gpointer data )
     return( FALSE );
   Strlcpy( rc_data.pcm_dev, line, sizeof(rc_data.pcm_dev) );
 
-  /* Read DSP rate Samples/sec, abort if EOF */
+  /* Read capture and DSP rates Samples/sec, abort if EOF.
+   * The DSP rate is that of capture unless given after it */
   if( Load_Line(line, xwefaxrc, _("DSP Rate") ) != SUCCESS )
     return( FALSE );
-  rc_data.dsp_rate = atoi( line );
+  if( sscanf(line, "%d %d",
+        &rc_data.capture_rate, &rc_data.dsp_rate) < 2 )
+    rc_data.dsp_rate = rc_data.capture_rate;
 
   /* Read ALSA "channel", abort if EOF */
   if( Load_Line(line, xwefaxrc, _("ALSA Channel") ) != SUCCESS )
@@ -278,12 +310,29 @@ Load_Config( gpointer data )
   {
     rc_data.tcvr_type = PERSEUS;
     rc_data.dsp_rate  = PERSEUS_SAMPLE_RATE;
+    rc_data.capture_rate = PERSEUS_SAMPLE_RATE;
+
+    /* A channel of another instance's Perseus is read like
+     * a sound card channel, at the rate it is decimated to */
+    if( isFlagSet(CHANNEL_CLIENT) )
+    {
+      rc_data.tcvr_type    = RADIO;
+      rc_data.capture_rate = PERSEUS_CHANNEL_RATE;
+      rc_data.dsp_rate     = PERSEUS_CHANNEL_RATE;
+    }
   }
 #endif
 
   if( strcmp(line, "RADIO") == 0 )
     rc_data.tcvr_type = RADIO;
 
+  /* A recording replayed sets the receiver type and DSP rate */
+  if( isFlagSet(FILE_SOURCE) && !Replay_Configure() )
+  {
+    fclose( xwefaxrc );
+    return( FALSE );
+  }
+
   if( rc_data.tcvr_type == NONE )
   {
     fclose( xwefaxrc );
@@ -336,7 +385,8 @@ Load_Config( gpointer data )
 
   /* Enable Transceiver CAT */
   if( (rc_data.tcvr_type == NONE) ||
-      (rc_data.tcvr_type == PERSEUS) )
+      (rc_data.tcvr_type == PERSEUS) ||
+      isFlagSet(FILE_SOURCE) )
     ClearFlag( ENABLE_CAT );
   else
     SetFlag( ENABLE_CAT );
@@ -480,6 +530,37 @@ Load_Config( gpointer data )
     return( FALSE );
   rc_data.image_enhance = atoi( line );
 
+  /* Spectrum settings follow here, where they are saved to */
+  spectrum_offset = ftell( xwefaxrc );
+
+  /* Read spectrum FFT size, window, overlap and averaging, abort if EOF */
+  if( Load_Line(line, xwefaxrc, _("Spectrum FFT Size")) != SUCCESS )
+    return( FALSE );
+  rc_data.fft_size = atoi( line );
+  if( Load_Line(line, xwefaxrc, _("Spectrum FFT Window")) != SUCCESS )
+    return( FALSE );
+  rc_data.fft_window = atoi( line );
+  if( Load_Line(line, xwefaxrc, _("Spectrum FFT Overlap")) != SUCCESS )
+    return( FALSE );
+  rc_data.fft_overlap = atoi( line );
+  if( Load_Line(line, xwefaxrc, _("Spectrum FFT Averaging")) != SUCCESS )
+    return( FALSE );
+  rc_data.fft_average = atoi( line );
+  if( (Value_Index(rc_data.fft_size, fft_sizes, NUM_FFT) < 0) ||
+      (Value_Index(rc_data.fft_window, fft_windows, NUM_WIN) < 0) ||
+      (Value_Index(rc_data.fft_overlap, fft_overlaps, NUM_OVL) < 0) ||
+      (Value_Index(rc_data.fft_average, fft_averages, NUM_AVE) < 0) )
+  {
+    fclose( xwefaxrc );
+    Show_Message(
+        _("Error reading Spectrum Settings\n"\
+          "Quit and correct xwefaxrc"), "red" );
+    Error_Dialog(
+        _("Error reading Spectrum Settings\n"\
+          "Quit and correct xwefaxrc"), QUIT );
+    return( FALSE );
+  }
+
   /* Form the xwefax home directory */
   snprintf( rc_data.xwefax_dir,
       sizeof(rc_data.xwefax_dir),
@@ -496,6 +577,8 @@ Load_Config( gpointer data )
   /* Initialize xwefax runtime config */
   Configure();
   Set_Menu_Items();
+  Spectrum_Configure();
+  ClearFlag( SAVE_SPECTRUM );
   fclose( xwefaxrc );
   FM_Detector = FM_Detect_Zero_Crossing;
   strncpy( rc_data.station_sideband, "USB",
@@ -650,7 +733,7 @@ New_Phasing_Lines( void )
   void
 New_Image_Enhance( void )
 {
-  int ime[ NUM_IME ] = { IME0, IME1, IME2 };
+  int ime[ NUM_IME ] = { IME0, IME1, IME2, IME3 };
 
   char name[8];
   int idx;
@@ -673,6 +756,194 @@ New_Image_Enhance( void )
 
 /*------------------------------------------------------------------*/
 
+/* New_Image_Zoom()
+ *
+ * Sets the image viewer's zoom on new zoom selected by the user
+ */
+  void
+New_Image_Zoom( void )
+{
+  int zoom[ NUM_ZOOM ] = { ZOOM_1, ZOOM_2, ZOOM_4, ZOOM_8, ZOOM_FIT };
+
+  char name[8];
+  int idx;
+
+  /* Find active zoom menu item */
+  for( idx = 0; idx < NUM_ZOOM; idx++ )
+  {
+    if( zoom[idx] == ZOOM_FIT )
+      Strlcpy( name, "zoomfit", sizeof(name) );
+    else
+      snprintf( name, sizeof(name), "zoom%d", 1 << zoom[idx] );
+    if( gtk_check_menu_item_get_active(GTK_CHECK_MENU_ITEM(
+            Builder_Get_Object(popup_menu_builder, name))) )
+      break;
+  }
+  if( idx == NUM_ZOOM ) return;
+
+  Viewer_Set_Zoom( zoom[idx] );
+
+} /* New_Image_Zoom() */
+
+/*------------------------------------------------------------------*/
+
+/* Active_Menu_Item()
+ *
+ * Returns the index of the active item in a group of
+ * radio menu items named prefix<value>, or -1 if none
+ */
+  static int
+Active_Menu_Item( const char *prefix, const int *values, int num )
+{
+  char name[8];
+  int idx;
+
+  for( idx = 0; idx < num; idx++ )
+  {
+    snprintf( name, sizeof(name), "%s%d", prefix, values[idx] );
+    name[7] = '\0';
+    if( gtk_check_menu_item_get_active(GTK_CHECK_MENU_ITEM(
+            Builder_Get_Object(popup_menu_builder, name))) )
+      return( idx );
+  }
+
+  return( -1 );
+} /* Active_Menu_Item() */
+
+/*------------------------------------------------------------------*/
+
+/* New_Spectrum_Settings()
+ *
+ * Initializes the spectrum engine on new FFT size, window,
+ * overlap or averaging selected by the user, and marks
+ * them to be saved to xwefaxrc
+ */
+  void
+New_Spectrum_Settings( void )
+{
+  int fft_idx, win_idx, ovl_idx, ave_idx;
+
+  /* Find active spectrum menu items */
+  fft_idx = Active_Menu_Item( "fft", fft_sizes,    NUM_FFT );
+  win_idx = Active_Menu_Item( "win", fft_windows,  NUM_WIN );
+  ovl_idx = Active_Menu_Item( "ovl", fft_overlaps, NUM_OVL );
+  ave_idx = Active_Menu_Item( "ave", fft_averages, NUM_AVE );
+  if( (fft_idx < 0) || (win_idx < 0) || (ovl_idx < 0) || (ave_idx < 0) )
+    return;
+
+  /* Enter user selected spectrum settings */
+  rc_data.fft_size    = fft_sizes[ fft_idx ];
+  rc_data.fft_window  = fft_windows[ win_idx ];
+  rc_data.fft_overlap = fft_overlaps[ ovl_idx ];
+  rc_data.fft_average = fft_averages[ ave_idx ];
+  Spectrum_Configure();
+  SetFlag( SAVE_SPECTRUM );
+
+} /* New_Spectrum_Settings() */
+
+/*------------------------------------------------------------------*/
+
+/* Save_Spectrum_Settings()
+ *
+ * Saves the spectrum settings to xwefaxrc, replacing the
+ * values that Load_Config() read them from and keeping
+ * the rest of the file as it is
+ */
+  gboolean
+Save_Spectrum_Settings( void )
+{
+  char rc_fpath[64]; /* File path to xwefaxrc */
+  char *buff = NULL; /* Contents of xwefaxrc */
+  int values[ 4 ], val_idx = 0, chr;
+  long size, idx, end;
+  FILE *xwefaxrc;
+
+  ClearFlag( SAVE_SPECTRUM );
+  if( !spectrum_offset ) return( FALSE );
+
+  values[0] = rc_data.fft_size;
+  values[1] = rc_data.fft_window;
+  values[2] = rc_data.fft_overlap;
+  values[3] = rc_data.fft_average;
+
+  /* Read in xwefaxrc file */
+  snprintf( rc_fpath, sizeof(rc_fpath),
+      "%s/xwefax/xwefaxrc", getenv("HOME") );
+  xwefaxrc = fopen( rc_fpath, "r" );
+  if( xwefaxrc == NULL )
+  {
+    perror( rc_fpath );
+    Show_Message( _("Failed to open xwefaxrc file"), "red" );
+    return( FALSE );
+  }
+  fseek( xwefaxrc, 0, SEEK_END );
+  size = ftell( xwefaxrc );
+  rewind( xwefaxrc );
+  if( (size < spectrum_offset) || !mem_alloc((void **)&buff, (size_t)size) ||
+      (fread(buff, 1, (size_t)size, xwefaxrc) != (size_t)size) )
+  {
+    fclose( xwefaxrc );
+    free_ptr( (void **)&buff );
+    Show_Message( _("Failed to read xwefaxrc file"), "red" );
+    return( FALSE );
+  }
+  fclose( xwefaxrc );
+
+  /* Write it back with the new spectrum settings */
+  if( !Open_File(&xwefaxrc, rc_fpath, "w") )
+  {
+    free_ptr( (void **)&buff );
+    return( FALSE );
+  }
+  fwrite( buff, 1, (size_t)spectrum_offset, xwefaxrc );
+  for( idx = spectrum_offset; idx < size; idx = end )
+  {
+    /* Find the end of line */
+    for( end = idx; (end < size) && (buff[end] != LF); end++ );
+    if( end < size ) end++;
+
+    /* Replace the value lines, copy comments */
+    chr = buff[idx];
+    if( (val_idx < 4) && (chr != '#') && (chr != ' ') &&
+        (chr != HT) && (chr != CR) && (chr != LF) )
+      fprintf( xwefaxrc, "%d\n", values[val_idx++] );
+    else
+      fwrite( &buff[idx], 1, (size_t)(end - idx), xwefaxrc );
+  }
+  fclose( xwefaxrc );
+  free_ptr( (void **)&buff );
+
+  Show_Message( _("Spectrum settings saved to xwefaxrc"), "green" );
+
+  return( TRUE );
+} /* Save_Spectrum_Settings() */
+
+/*------------------------------------------------------------------*/
+
+/* New_Record_Settings()
+ *
+ * Sets the rotation of signal recordings and the
+ * packing of Perseus I/Q samples selected by the user
+ */
+  void
+New_Record_Settings( void )
+{
+  int rec[ NUM_REC ] = { RECORD_OFF, RECORD_BY_CHART, RECORD_HOURLY };
+  int rec_idx;
+  gboolean iq16;
+
+  /* Find active recording menu items */
+  rec_idx = Active_Menu_Item( "rec", rec, NUM_REC );
+  if( rec_idx < 0 ) return;
+  iq16 = gtk_check_menu_item_get_active( GTK_CHECK_MENU_ITEM(
+        Builder_Get_Object(popup_menu_builder, "rec_iq16")) );
+
+  Record_Mode( rec[rec_idx], iq16 );
+
+} /* New_Record_Settings() */
+
+/*------------------------------------------------------------------*/
+
 /*  Configure()
  *
  *  Initializes xwefax after change of parameters
@@ -726,52 +997,34 @@ Configure( void )
     }
     bzero( line_buffer, (size_t)rc_data.line_buffer_size );
 
-    /* Create pixbuff for WEFAX images */
-    if( wefax_pixbuf != NULL )
+    /* The image viewer is only needed with the GUI */
+    if( isFlagClear(HEADLESS) )
     {
-      g_object_unref( wefax_pixbuf );
-      wefax_pixbuf = NULL;
-    }
-    wefax_pixbuf = gdk_pixbuf_new(
-        GDK_COLORSPACE_RGB, FALSE, 8,
-        pixels_per_line, rc_data.image_lines );
+      /* Globalize drawingarea to be displayed */
+      wefax_drawingarea =
+        Builder_Get_Object( main_window_builder, "wefax_drawingarea" );
 
-    /* Error, not enough memory */
-    if( wefax_pixbuf == NULL)
-    {
-      Show_Message(
-          _("Failed to Allocate Memory to Pixbuf\n"
-            "Please Quit and correct"), "red" );
-      Error_Dialog(
-          _("Failed to Allocate Memory to Pixbuf\n"
-            "Please Quit and correct"), QUIT );
-      return;
-    }
+      /* Create mip pyramid of image viewer, sizes drawingarea */
+      if( !Viewer_Configure(pixels_per_line, rc_data.image_lines) )
+      {
+        Show_Message(
+            _("Failed to Allocate Memory to Image Viewer\n"
+              "Please Quit and correct"), "red" );
+        Error_Dialog(
+            _("Failed to Allocate Memory to Image Viewer\n"
+              "Please Quit and correct"), QUIT );
+        return;
+      }
+      gtk_widget_show( wefax_drawingarea );
 
-    /* Fill pixbuf with background color */
-    gdk_pixbuf_fill( wefax_pixbuf, PIXBUF_BACKGND );
-
-    /* Get details of pixbuf */
-    pixel_buf  = gdk_pixbuf_get_pixels( wefax_pixbuf );
-    rowstride  = gdk_pixbuf_get_rowstride( wefax_pixbuf );
-    n_channels = gdk_pixbuf_get_n_channels( wefax_pixbuf );
-
-    /* Globalize drawingarea to be displayed */
-    wefax_drawingarea =
-      Builder_Get_Object( main_window_builder, "wefax_drawingarea" );
-    gtk_widget_set_size_request(
-        wefax_drawingarea,
-        pixels_per_line,
-        rc_data.image_lines );
-    gtk_widget_show( wefax_drawingarea );
-
-    /* Set window size as required */
-    image_scroller =
-      Builder_Get_Object( main_window_builder, "image_scrolledwindow" );
-    gtk_widget_set_size_request(
-        image_scroller, -1,
-        rc_data.window_height );
-    gtk_window_resize( GTK_WINDOW(main_window), 10, 10 );
+      /* Set window size as required */
+      image_scroller =
+        Builder_Get_Object( main_window_builder, "image_scrolledwindow" );
+      gtk_widget_set_size_request(
+          image_scroller, -1,
+          rc_data.window_height );
+      gtk_window_resize( GTK_WINDOW(main_window), 10, 10 );
+    } /* if( isFlagClear(HEADLESS) ) */
 
     /* Re-initialize line buffer indices */
     linebuff_input  = 0;
@@ -786,20 +1039,10 @@ Configure( void )
   if( new_lpm || new_ppl )
   {
     /* Length (duration) of an image pixel in DSP samples */
-    double temp = rc_data.lines_per_min / 60.0; /* lines/sec */
-    if( temp != 0.0 )
-      temp = (double)rc_data.dsp_rate / temp; /* samples/line  */
-
-    /* Add sync slant correction to pixel length */
-    rc_data.pixel_len = temp;
-    temp = (double)rc_data.pixels_per_line + rc_data.sync_slant;
-
-    /* Samples/pixel as a float */
-    if( temp != 0.0 )
-      rc_data.pixel_len = rc_data.pixel_len / temp;
+    Set_Pixel_Len();
 
     /* Period of start and stop tones in pixels */
-    temp = lines_per_min / 60.0; /* lines/sec */
+    double temp = lines_per_min / 60.0; /* lines/sec */
     rc_data.start_tone_period =
       temp * (double)pixels_per_line / (double)rc_data.start_tone;
     rc_data.stop_tone_period =
@@ -914,7 +1157,10 @@ Save_Image_PGM(
     size = (size_t)(width * height);
 
   /* Write image buffer to file, abort on error */
-  if( fwrite(buffer, 1, size, fp) != size )
+  PERF_BEGIN( PERF_SAVE_PGM );
+  size_t written = fwrite( buffer, 1, size, fp );
+  PERF_END( PERF_SAVE_PGM );
+  if( written != size )
   {
     fclose( fp );
     perror( "xwefax: Error writing Image to file" );
@@ -960,12 +1206,14 @@ Save_Image_JPEG( FILE *fp, int width, int height, uint8_t *buffer )
   memcpy( buff, buffer, siz );
 
   /* Create a jpeg encoder */
+  PERF_BEGIN( PERF_SAVE_JPEG );
   jpec_enc_t *enc =
     jpec_enc_new( buff, (uint16_t)wdt, (uint16_t)hgt );
 
   /* Run encoder to create jpeg image */
   const uint8_t *jpeg = jpec_enc_run( enc, &len );
   siz = (size_t)len;
+  PERF_END( PERF_SAVE_JPEG );
 
   /* Write image buffer to file, abort on error */
   if( fwrite(jpeg, sizeof(uint8_t), siz, fp) != siz )
@@ -995,11 +1243,47 @@ Save_Image_JPEG( FILE *fp, int width, int height, uint8_t *buffer )
 Usage( void )
 {
   fprintf( stderr, "%s\n",
-      _("Usage: xwefax [-hv]") );
+      _("Usage: xwefax [-bfhv] [-c <chn>] [-o <offset>] [-s <file>]") );
+
+  fprintf( stderr, "%s\n",
+      _("              [-R <raw>[,<slant>[,<phase>[,<enhance>]]]]") );
+
+  fprintf( stderr, "%s\n",
+      _("              [-p <file>[,<seek>][,loop][,fast]]") );
+
+  fprintf( stderr, "%s\n",
+      _("              [-r <dir>[,bless]]") );
+
+  fprintf( stderr, "%s\n",
+      _("       -b: Run DSP benchmarks on synthetic signals and exit"));
+
+  fprintf( stderr, "%s\n",
+      _("       -c: Decode channel <chn> served by another instance"));
+
+  fprintf( stderr, "%s\n",
+      _("       -f: Demodulate in fixed point (integer) arithmetic"));
 
   fprintf( stderr, "%s\n",
       _("       -h: Print this usage information and exit"));
 
+  fprintf( stderr, "%s\n",
+      _("       -o: Serve a Perseus channel <offset> Hz from the station"));
+
+  fprintf( stderr, "%s\n",
+      _("       -p: Replay recording <file> from <seek> sec, in place of Rx"));
+
+  fprintf( stderr, "%s\n",
+      _("       -r: Run regression tests against golden images in <dir>"));
+
+  fprintf( stderr, "%s\n",
+      _("           with bless, create the golden images that are missing"));
+
+  fprintf( stderr, "%s\n",
+      _("       -R: Re-render the image of <raw> discriminator file to PGM"));
+
+  fprintf( stderr, "%s\n",
+      _("       -s: Receive unattended by the broadcast schedule <file>"));
+
   fprintf( stderr, "%s\n",
       _("       -v: Print version number and exit"));
 
@@ -1019,6 +1303,13 @@ Show_Message( char *mesg, char *attr )
   static GtkTextIter iter;
   static gboolean first_call = TRUE;
 
+  /* Print to stderr if there is no GUI */
+  if( isFlagSet(HEADLESS) )
+  {
+    fprintf( stderr, "xwefax: %s\n", mesg );
+    return;
+  }
+
   /* Initialize */
   if( first_call )
   {
@@ -1120,39 +1411,50 @@ Cleanup( void )
 
 /*------------------------------------------------------------------------*/
 
-/* Functions for testing and setting/clearing flags */
+/* Functions for testing and setting/clearing flags. Flags are
+ * shared by the GUI, the Perseus and the worker threads, so they
+ * are set and cleared atomically with release semantics, and read
+ * with acquire semantics to see the data written before them */
+
+/* Atomic words holding the single-bit flags of each subsystem */
+static flag_word_t Flags[ NUM_FLAG_GROUPS ];
 
-/* An int variable holding the single-bit flags */
-static int Flags = 0;
+#define FLAG_WORD( flag )  ( &Flags[(flag) >> FLAGS_GROUP_SHIFT].word )
+#define FLAG_BITS( flag )  ( (unsigned int)(flag) & FLAGS_BITS )
 
   int
 isFlagSet(int flag)
 {
-  return (Flags & flag);
+  return( (int)(atomic_load_explicit(FLAG_WORD(flag),
+          memory_order_acquire) & FLAG_BITS(flag)) );
 }
 
   int
 isFlagClear(int flag)
 {
-  return (~Flags & flag);
+  return( (int)(~atomic_load_explicit(FLAG_WORD(flag),
+          memory_order_acquire) & FLAG_BITS(flag)) );
 }
 
   void
 SetFlag(int flag)
 {
-  Flags |= flag;
+  atomic_fetch_or_explicit( FLAG_WORD(flag),
+      FLAG_BITS(flag), memory_order_acq_rel );
 }
 
   void
 ClearFlag(int flag)
 {
-  Flags &= ~flag;
+  atomic_fetch_and_explicit( FLAG_WORD(flag),
+      ~FLAG_BITS(flag), memory_order_acq_rel );
 }
 
   void
 ToggleFlag(int flag)
 {
-  Flags ^= flag;
+  atomic_fetch_xor_explicit( FLAG_WORD(flag),
+      FLAG_BITS(flag), memory_order_acq_rel );
 }
 
 /*------------------------------------------------------------------*/
@@ -18,7 +18,12 @@
 #include "shared.h"
 #include "interface.h"
 #include "perseus.h"
+#include "record.h"
 #include "sound.h"
+#include <stdatomic.h>
+
+/* Size of a CPU cache line, to keep flag words apart */
+#define CACHE_LINE_SIZE 64
 
 /* Choices of RPM values in menu */
 #define RPM60       60
@@ -52,8 +57,39 @@ enum
   IME0 = 0,
   IME1,
   IME2,
+  IME3,
   NUM_IME
 };
 
+/* Choices of spectrum FFT size in menu */
+#define FFT512      512
+#define FFT1024     1024
+#define FFT2048     2048
+#define FFT4096     4096
+#define NUM_FFT     4
+
+/* Choices of spectrum window function in menu */
+#define NUM_WIN     3
+
+/* Choices of spectrum FFT overlap (percent) in menu */
+#define OVL0        0
+#define OVL50       50
+#define OVL75       75
+#define NUM_OVL     3
+
+/* Choices of spectrum averaged segments in menu */
+#define AVE1        1
+#define AVE2        2
+#define AVE4        4
+#define AVE8        8
+#define AVE16       16
+#define NUM_AVE     5
+
+/* An atomic word of flags, alone in its cache line */
+typedef struct
+{
+  _Alignas( CACHE_LINE_SIZE ) atomic_uint word;
+} flag_word_t;
+
 #endif
 
@@ -0,0 +1,468 @@
+/*
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License as
+ *  published by the Free Software Foundation; either version 2 of
+ *  the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details:
+ *
+ *  http://www.gnu.org/copyleft/gpl.txt
+ */
+
+#include "viewer.h"
+#include "shared.h"
+
+/* The mip pyramid of the WEFAX image */
+static viewer_level_t levels[ VIEWER_LEVELS ];
+
+static int
+  viewer_zoom  = ZOOM_1, /* Zoom selected by the user */
+  viewer_level = 0,      /* Pyramid level used for drawing */
+  viewer_lines = 0;      /* Number of image lines entered */
+
+/* Scale of displayed image to the full size image */
+static double viewer_scale = 1.0;
+
+/* Image lines and scroller allocation the fit zoom is for */
+static int fit_lines = 0, fit_width = 0, fit_height = 0;
+
+/*------------------------------------------------------------------------*/
+
+/* Mark_Dirty()
+ *
+ * Marks a row of a pyramid level for rendering to its tile
+ */
+  static void
+Mark_Dirty( viewer_level_t *level, int row )
+{
+  viewer_tile_t *tile = &level->tiles[ row / VIEWER_TILE_ROWS ];
+
+  row %= VIEWER_TILE_ROWS;
+  if( tile->dirty_to < tile->dirty_from )
+  {
+    tile->dirty_from = tile->dirty_to = row;
+    return;
+  }
+  if( tile->dirty_from > row ) tile->dirty_from = row;
+  if( tile->dirty_to   < row ) tile->dirty_to   = row;
+
+} /* Mark_Dirty() */
+
+/*------------------------------------------------------------------------*/
+
+/* Free_Levels()
+ *
+ * Frees the pixels and tiles of the mip pyramid
+ */
+  static void
+Free_Levels( void )
+{
+  int lev, idx;
+
+  for( lev = 0; lev < VIEWER_LEVELS; lev++ )
+  {
+    for( idx = 0; idx < levels[lev].num_tiles; idx++ )
+      if( levels[lev].tiles[idx].surface != NULL )
+        cairo_surface_destroy( levels[lev].tiles[idx].surface );
+    free_ptr( (void **)&levels[lev].tiles );
+    free_ptr( (void **)&levels[lev].pixels );
+    levels[lev].num_tiles = 0;
+  }
+
+} /* Free_Levels() */
+
+/*------------------------------------------------------------------------*/
+
+/* Fit_Changed()
+ *
+ * Returns TRUE if the image lines to fit, rounded up to
+ * VIEWER_FIT_STEP, or the image scroller's allocation
+ * have changed since the fit zoom scale was calculated
+ */
+  static gboolean
+Fit_Changed( GtkAllocation *alloc, int *lines )
+{
+  if( wefax_drawingarea == NULL ) return( FALSE );
+
+  gtk_widget_get_allocation( gtk_widget_get_parent(
+        gtk_widget_get_parent(wefax_drawingarea)), alloc );
+
+  /* All the image's lines if none decoded yet */
+  *lines = ( viewer_lines + VIEWER_FIT_STEP - 1 ) /
+    VIEWER_FIT_STEP * VIEWER_FIT_STEP;
+  if( (*lines == 0) || (*lines > levels[0].height) )
+    *lines = levels[0].height;
+
+  return( (*lines != fit_lines) ||
+      (alloc->width != fit_width) || (alloc->height != fit_height) );
+} /* Fit_Changed() */
+
+/*------------------------------------------------------------------------*/
+
+/* Set_Viewer_Scale()
+ *
+ * Calculates the display scale and pyramid level for the
+ * selected zoom and sets the size of the image drawingarea
+ */
+  static void
+Set_Viewer_Scale( void )
+{
+  GtkAllocation alloc;
+  double fit;
+  int lines;
+
+  if( wefax_drawingarea == NULL ) return;
+
+  if( viewer_zoom == ZOOM_FIT )
+  {
+    /* Fit the decoded lines into the image scroller */
+    Fit_Changed( &alloc, &lines );
+    fit_lines  = lines;
+    fit_width  = alloc.width;
+    fit_height = alloc.height;
+    fit = (double)alloc.height / (double)lines;
+    if( fit > (double)alloc.width / (double)levels[0].width )
+      fit = (double)alloc.width / (double)levels[0].width;
+    if( fit > 1.0 ) fit = 1.0;
+    viewer_scale = fit;
+  }
+  else
+  {
+    viewer_scale = 1.0 / (double)( 1 << viewer_zoom );
+    lines = levels[0].height;
+  }
+
+  /* Use the smallest level with enough resolution */
+  for( viewer_level = VIEWER_LEVELS - 1; viewer_level > 0; viewer_level-- )
+    if( viewer_scale * (double)(1 << viewer_level) <= 1.0 )
+      break;
+
+  /* The drawingarea is as high as the lines scaled */
+  gtk_widget_set_size_request(
+      wefax_drawingarea,
+      (int)( (double)levels[0].width * viewer_scale + 0.5 ),
+      (int)( (double)lines * viewer_scale + 0.5 ) );
+  gtk_widget_queue_draw( wefax_drawingarea );
+
+} /* Set_Viewer_Scale() */
+
+/*------------------------------------------------------------------------*/
+
+/* Viewer_Configure()
+ *
+ * Allocates the mip pyramid for images of the given size
+ */
+  gboolean
+Viewer_Configure( int width, int height )
+{
+  int lev;
+
+  Free_Levels();
+  for( lev = 0; lev < VIEWER_LEVELS; lev++ )
+  {
+    levels[lev].width  = width;
+    levels[lev].height = height;
+    levels[lev].num_tiles =
+      ( height + VIEWER_TILE_ROWS - 1 ) / VIEWER_TILE_ROWS;
+
+    if( !mem_alloc((void **)&levels[lev].pixels,
+          (size_t)(width * height)) ||
+        !mem_alloc((void **)&levels[lev].tiles,
+          sizeof(viewer_tile_t) * (size_t)levels[lev].num_tiles) )
+    {
+      levels[lev].num_tiles = 0;
+      Free_Levels();
+      return( FALSE );
+    }
+    memset( levels[lev].tiles, 0,
+        sizeof(viewer_tile_t) * (size_t)levels[lev].num_tiles );
+
+    /* Next level is half size, rounded up */
+    width  = ( width  + 1 ) / 2;
+    height = ( height + 1 ) / 2;
+  }
+
+  Viewer_Clear();
+  Set_Viewer_Scale();
+
+  return( TRUE );
+} /* Viewer_Configure() */
+
+/*------------------------------------------------------------------------*/
+
+/* Viewer_Clear()
+ *
+ * Fills the mip pyramid with the background color
+ */
+  void
+Viewer_Clear( void )
+{
+  viewer_level_t *level;
+  int lev, idx;
+
+  for( lev = 0; lev < VIEWER_LEVELS; lev++ )
+  {
+    level = &levels[lev];
+    if( level->pixels == NULL ) continue;
+    memset( level->pixels, VIEWER_BACKGND,
+        (size_t)(level->width * level->height) );
+    for( idx = 0; idx < level->num_tiles; idx++ )
+    {
+      level->tiles[idx].dirty_from = 0;
+      level->tiles[idx].dirty_to   = VIEWER_TILE_ROWS - 1;
+    }
+  }
+  viewer_lines = 0;
+
+  if( viewer_zoom == ZOOM_FIT )
+    Set_Viewer_Scale();
+  else if( wefax_drawingarea != NULL )
+    gtk_widget_queue_draw( wefax_drawingarea );
+
+} /* Viewer_Clear() */
+
+/*------------------------------------------------------------------------*/
+
+/* Viewer_Add_Line()
+ *
+ * Enters a decoded image line into the mip pyramid,
+ * updating the lower resolution levels incrementally
+ */
+  void
+Viewer_Add_Line( const unsigned char *line, int line_idx )
+{
+  viewer_level_t *src, *dst;
+  unsigned char *row0, *row1, *out;
+  GtkAllocation alloc;
+  int lev, row, col, col1, last_row, y0, h, lines;
+
+  if( (levels[0].pixels == NULL) ||
+      (line_idx < 0) || (line_idx >= levels[0].height) )
+    return;
+
+  PERF_BEGIN( PERF_VIEWER );
+  PERF_LINE_ADDED( line_idx );
+
+  /* Full resolution level */
+  memcpy( levels[0].pixels + line_idx * levels[0].width,
+      line, (size_t)levels[0].width );
+  Mark_Dirty( &levels[0], line_idx );
+
+  /* Average 2x2 blocks of each level into the next */
+  last_row = line_idx;
+  for( lev = 1; lev < VIEWER_LEVELS; lev++ )
+  {
+    src = &levels[lev - 1];
+    dst = &levels[lev];
+    row = last_row / 2;
+
+    /* Repeat the last row if its pair is not yet decoded */
+    row0 = src->pixels + 2 * row * src->width;
+    if( 2 * row + 1 <= last_row )
+      row1 = row0 + src->width;
+    else
+      row1 = row0;
+
+    out = dst->pixels + row * dst->width;
+    for( col = 0; col < dst->width; col++ )
+    {
+      col1 = 2 * col + 1;
+      if( col1 >= src->width ) col1 = 2 * col;
+      out[col] = (unsigned char)(
+          (row0[2 * col] + row0[col1] + row1[2 * col] + row1[col1] + 2) / 4 );
+    }
+    Mark_Dirty( dst, row );
+    last_row = row;
+  }
+
+  if( viewer_lines < line_idx + 1 )
+    viewer_lines = line_idx + 1;
+
+  /* Redraw only the area of new line, unless
+   * the fit zoom has to scale the image again */
+  if( (viewer_zoom == ZOOM_FIT) && Fit_Changed(&alloc, &lines) )
+    Set_Viewer_Scale();
+  else
+  {
+    y0 = (int)( (double)line_idx * viewer_scale );
+    h  = (int)( viewer_scale + 0.999 ) + 1;
+    gtk_widget_queue_draw_area( wefax_drawingarea, 0, y0,
+        (int)((double)levels[0].width * viewer_scale) + 1, h );
+  }
+
+  PERF_END( PERF_VIEWER );
+
+} /* Viewer_Add_Line() */
+
+/*------------------------------------------------------------------------*/
+
+/* Render_Tile()
+ *
+ * Renders the dirty rows of a tile to its cairo surface
+ */
+  static gboolean
+Render_Tile( viewer_level_t *level, int tile_idx )
+{
+  viewer_tile_t *tile = &level->tiles[ tile_idx ];
+  unsigned char *data, *pix;
+  uint32_t *out;
+  int stride, row, col, rows, first;
+
+  /* Rows of this tile inside the level */
+  first = tile_idx * VIEWER_TILE_ROWS;
+  rows  = level->height - first;
+  if( rows > VIEWER_TILE_ROWS ) rows = VIEWER_TILE_ROWS;
+
+  if( tile->surface == NULL )
+  {
+    tile->surface = cairo_image_surface_create(
+        CAIRO_FORMAT_RGB24, level->width, rows );
+    if( cairo_surface_status(tile->surface) != CAIRO_STATUS_SUCCESS )
+    {
+      cairo_surface_destroy( tile->surface );
+      tile->surface = NULL;
+      return( FALSE );
+    }
+    tile->dirty_from = 0;
+    tile->dirty_to   = rows - 1;
+  }
+
+  if( tile->dirty_to < tile->dirty_from ) return( TRUE );
+  if( tile->dirty_to >= rows ) tile->dirty_to = rows - 1;
+
+  /* Copy greyscale pixels to RGB24 surface */
+  cairo_surface_flush( tile->surface );
+  data   = cairo_image_surface_get_data( tile->surface );
+  stride = cairo_image_surface_get_stride( tile->surface );
+  for( row = tile->dirty_from; row <= tile->dirty_to; row++ )
+  {
+    pix = level->pixels + ( first + row ) * level->width;
+    out = (uint32_t *)( data + row * stride );
+    for( col = 0; col < level->width; col++ )
+      out[col] = 0xff000000u |
+        ( (uint32_t)pix[col] << 16 ) |
+        ( (uint32_t)pix[col] << 8 )  |
+          (uint32_t)pix[col];
+  }
+  cairo_surface_mark_dirty_rectangle( tile->surface, 0, tile->dirty_from,
+      level->width, tile->dirty_to - tile->dirty_from + 1 );
+
+  tile->dirty_from = VIEWER_TILE_ROWS;
+  tile->dirty_to   = -1;
+
+  return( TRUE );
+} /* Render_Tile() */
+
+/*------------------------------------------------------------------------*/
+
+/* Viewer_Draw()
+ *
+ * Draws the tiles of the pyramid level in use
+ * that intersect the drawingarea's clip region
+ */
+  gboolean
+Viewer_Draw( cairo_t *cr )
+{
+  viewer_level_t *level = &levels[ viewer_level ];
+  double x1, y1, x2, y2, lscale;
+  int first, last, idx;
+
+  if( level->pixels == NULL ) return( FALSE );
+
+  /* Scale of level pixels to drawingarea pixels */
+  lscale = viewer_scale * (double)( 1 << viewer_level );
+
+  /* Range of tiles inside the clip region */
+  cairo_clip_extents( cr, &x1, &y1, &x2, &y2 );
+  first = (int)( y1 / lscale ) / VIEWER_TILE_ROWS;
+  last  = (int)( y2 / lscale ) / VIEWER_TILE_ROWS;
+  if( first < 0 ) first = 0;
+  if( last >= level->num_tiles ) last = level->num_tiles - 1;
+
+  cairo_save( cr );
+  cairo_scale( cr, lscale, lscale );
+  for( idx = first; idx <= last; idx++ )
+  {
+    if( !Render_Tile(level, idx) ) continue;
+
+    cairo_set_source_surface( cr, level->tiles[idx].surface,
+        0.0, (double)(idx * VIEWER_TILE_ROWS) );
+    cairo_pattern_set_filter( cairo_get_source(cr),
+        lscale >= 1.0 ? CAIRO_FILTER_NEAREST : CAIRO_FILTER_BILINEAR );
+    cairo_rectangle( cr, 0.0, (double)(idx * VIEWER_TILE_ROWS),
+        (double)level->width,
+        (double)cairo_image_surface_get_height(level->tiles[idx].surface) );
+    cairo_fill( cr );
+  }
+  cairo_restore( cr );
+
+  /* Lines entered so far are now on display */
+  PERF_DISPLAYED();
+
+  return( TRUE );
+} /* Viewer_Draw() */
+
+/*------------------------------------------------------------------------*/
+
+/* Viewer_Set_Zoom()
+ *
+ * Sets the zoom of the image viewer
+ */
+  void
+Viewer_Set_Zoom( int zoom )
+{
+  if( (zoom < ZOOM_1) || (zoom > ZOOM_FIT) ) return;
+  viewer_zoom = zoom;
+  if( levels[0].pixels != NULL ) Set_Viewer_Scale();
+
+} /* Viewer_Set_Zoom() */
+
+/*------------------------------------------------------------------------*/
+
+/* Viewer_Scroll()
+ *
+ * Steps the zoom on Ctrl + mouse wheel, otherwise
+ * leaves scrolling (panning) to the image scroller
+ */
+  gboolean
+Viewer_Scroll( GdkEventScroll *event )
+{
+  char name[8];
+  int zoom;
+
+  if( !(event->state & GDK_CONTROL_MASK) ) return( FALSE );
+
+  /* Zoom in or out from current zoom */
+  zoom = ( viewer_zoom == ZOOM_FIT ) ? viewer_level : viewer_zoom;
+  if( event->direction == GDK_SCROLL_UP )
+    zoom--;
+  else if( event->direction == GDK_SCROLL_DOWN )
+    zoom++;
+  if( zoom < ZOOM_1 ) zoom = ZOOM_1;
+  if( zoom > ZOOM_8 ) zoom = ZOOM_8;
+
+  /* Activating the menu item applies the zoom */
+  snprintf( name, sizeof(name), "zoom%d", 1 << zoom );
+  gtk_check_menu_item_set_active( GTK_CHECK_MENU_ITEM(
+        Builder_Get_Object(popup_menu_builder, name)), TRUE );
+
+  return( TRUE );
+} /* Viewer_Scroll() */
+
+/*------------------------------------------------------------------------*/
+
+/* Viewer_Image_X()
+ *
+ * Converts an x position in the drawingarea to an image column
+ */
+  double
+Viewer_Image_X( double x )
+{
+  return( x / viewer_scale );
+} /* Viewer_Image_X() */
+
+/*------------------------------------------------------------------------*/
+
@@ -0,0 +1,54 @@
+/*
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License as
+ *  published by the Free Software Foundation; either version 2 of
+ *  the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details:
+ *
+ *  http://www.gnu.org/copyleft/gpl.txt
+ */
+
+#ifndef VIEWER_H
+#define VIEWER_H    1
+
+#include "common.h"
+
+/* Levels of the mip pyramid, 1:1 1:2 1:4 1:8 */
+#define VIEWER_LEVELS       4
+
+/* Rows of pixels in each cached tile of a level */
+#define VIEWER_TILE_ROWS    256
+
+/* Step of decoded lines the fit zoom is rounded up to,
+ * so that the image is not scaled again on every line */
+#define VIEWER_FIT_STEP     64
+
+/* Greyscale value of image background */
+#define VIEWER_BACKGND      0xb0
+
+/* A cached rendering of a band of rows of a pyramid level */
+typedef struct
+{
+  cairo_surface_t *surface; /* RGB24 rendering of tile, NULL if none */
+  int
+    dirty_from, /* First row (in tile) to render again */
+    dirty_to;   /* Last row (in tile) to render again, < from if clean */
+} viewer_tile_t;
+
+/* A level of the mip pyramid */
+typedef struct
+{
+  unsigned char *pixels; /* Greyscale pixels of level */
+  int
+    width,     /* Width of level in pixels */
+    height,    /* Height of level in pixels */
+    num_tiles; /* Number of tiles in level */
+  viewer_tile_t *tiles;
+} viewer_level_t;
+
+#endif
+
@@ -15,6 +15,22 @@
 #include "wefax.h"
 #include "shared.h"
 
+/* Buffer for creating a PGM image file */
+static unsigned char *image_buffer = NULL;
+
+/* Sync pulse positions and their lines for auto deslant, the
+ * position the pulse is kept at, the shift pending to bring
+ * it back there and the sum of the shifts made so far */
+static struct
+{
+  int count;
+  int line[ DESLANT_FIT_LINES ];
+  int pos[ DESLANT_FIT_LINES ];
+  gboolean have_ref;
+  double ref_pos;
+  int shift, shifted;
+} deslant;
+
 /*------------------------------------------------------------------------*/
 
 /* Receive_Error()
@@ -33,6 +49,158 @@ Receive_Error( void )
 
 /*------------------------------------------------------------------------*/
 
+/* Enhanced_Lines()
+ *
+ * Enters lines returned by the adaptive enhancement
+ * worker to the image buffer and viewer. If flush is
+ * set, waits for all queued lines, before saving images
+ */
+  static void
+Enhanced_Lines( unsigned char *image_buffer, gboolean flush )
+{
+  int line_idx;
+
+  if( flush ) Enhance_Flush();
+  while( Enhance_Get_Line(image_buffer, rc_data.pixels_per_line, &line_idx) )
+    Viewer_Add_Line(
+        &image_buffer[line_idx * rc_data.pixels_per_line], line_idx );
+
+} /* Enhanced_Lines() */
+
+/*------------------------------------------------------------------------*/
+
+/* Sync_Pulse_Position()
+ *
+ * Finds the sync pulse in an image line as the darkest run
+ * of pixels of its length, wrapping around the line end.
+ * Returns its start and its mean level in sync_level
+ */
+  static int
+Sync_Pulse_Position( const unsigned char *line, int *sync_level )
+{
+  int idx, sum = 0, min_sum, min_idx = 0;
+
+  for( idx = 0; idx < PHASING_PULSE_LEN; idx++ )
+    sum += line[idx];
+  min_sum = sum;
+
+  /* Slide the run along the line by a pixel at a time */
+  for( idx = 1; idx < rc_data.pixels_per_line; idx++ )
+  {
+    sum -= line[ idx - 1 ];
+    sum += line[ (idx + PHASING_PULSE_LEN - 1) % rc_data.pixels_per_line ];
+    if( sum < min_sum )
+    {
+      min_sum = sum;
+      min_idx = idx;
+    }
+  }
+
+  *sync_level = min_sum / PHASING_PULSE_LEN;
+  return( min_idx );
+} /* Sync_Pulse_Position() */
+
+/*------------------------------------------------------------------------*/
+
+/* Auto_Deslant()
+ *
+ * Fits a line by least squares to the sync pulse position
+ * of image lines and takes its slope, the drift of the pulse
+ * in pixels per line, out of the sync slant correction. This
+ * tracks sound card clock errors. Positions far from their
+ * median, as of image content mistaken for the pulse, are left
+ * out, and fits that still deviate from a line too much ignored
+ */
+  static void
+Auto_Deslant( int line, int sync_pos )
+{
+  double n, x, y, sum_x, sum_y, sum_xx, sum_xy, sum_yy;
+  double sxx, sxy, syy, slope;
+  int idx, cnt, below, above, median = 0;
+
+  /* Keep positions that wrap around the line continuous */
+  if( deslant.count )
+  {
+    int prev = deslant.pos[ deslant.count - 1 ];
+    if( sync_pos - prev > rc_data.pixels_per_line / 2 )
+      sync_pos -= rc_data.pixels_per_line;
+    else if( prev - sync_pos > rc_data.pixels_per_line / 2 )
+      sync_pos += rc_data.pixels_per_line;
+  }
+
+  deslant.line[ deslant.count ] = line;
+  deslant.pos[ deslant.count ]  = sync_pos;
+  deslant.count++;
+  if( deslant.count < DESLANT_FIT_LINES ) return;
+  deslant.count = 0;
+
+  /* Median of positions, with half of the others below it */
+  for( idx = 0; idx < DESLANT_FIT_LINES; idx++ )
+  {
+    below = above = 0;
+    for( cnt = 0; cnt < DESLANT_FIT_LINES; cnt++ )
+    {
+      if( deslant.pos[cnt] < deslant.pos[idx] ) below++;
+      if( deslant.pos[cnt] > deslant.pos[idx] ) above++;
+    }
+    if( (below <= DESLANT_FIT_LINES / 2) &&
+        (above <= DESLANT_FIT_LINES / 2) )
+    {
+      median = deslant.pos[idx];
+      break;
+    }
+  }
+
+  /* Sums of positions near the median and of their lines */
+  sum_x = sum_y = sum_xx = sum_xy = sum_yy = 0.0;
+  cnt = 0;
+  for( idx = 0; idx < DESLANT_FIT_LINES; idx++ )
+  {
+    if( abs(deslant.pos[idx] - median) > DESLANT_INLIER_RANGE )
+      continue;
+    x = (double)deslant.line[idx];
+    y = (double)deslant.pos[idx];
+    sum_x  += x;
+    sum_y  += y;
+    sum_xx += x * x;
+    sum_xy += x * y;
+    sum_yy += y * y;
+    cnt++;
+  }
+  if( cnt < DESLANT_FIT_LINES / 2 ) return;
+
+  /* Centered sums of squares and products */
+  n   = (double)cnt;
+  sxx = sum_xx - sum_x * sum_x / n;
+  sxy = sum_xy - sum_x * sum_y / n;
+  syy = sum_yy - sum_y * sum_y / n;
+  if( sxx <= 0.0 ) return;
+
+  slope = sxy / sxx;
+  if( ((syy - slope * sxy) / n >
+        DESLANT_MAX_RESIDUAL * DESLANT_MAX_RESIDUAL) ||
+      (fabs(slope) > DESLANT_MAX_SLANT) )
+    return;
+
+  /* A pulse drifting later needs longer pixels */
+  rc_data.sync_slant -= slope;
+  Set_Pixel_Len();
+
+  /* The pulse is kept where the first fit found it, by
+   * shifting it back by the drift before the correction */
+  double x_mean = sum_x / n, y_mean = sum_y / n;
+  if( !deslant.have_ref )
+  {
+    deslant.ref_pos  = y_mean + slope * ( deslant.line[0] - x_mean );
+    deslant.have_ref = TRUE;
+  }
+  deslant.shift = (int)lround( y_mean +
+      slope * ((double)line - x_mean) - deslant.ref_pos ) + deslant.shifted;
+
+} /* Auto_Deslant() */
+
+/*------------------------------------------------------------------------*/
+
 /* Wefax_Decode()
  *
  * Function that decodes Wefax signals into images
@@ -43,12 +211,7 @@ Wefax_Decode( void )
   /* First call of function flag */
   static gboolean first_call = TRUE;
 
-  /* Pixbuf's pixel pointer */
-  guchar *pixel;
-
-  /* Buffer for creating a PGM image file */
-  static unsigned char *image_buffer = NULL;
-  int image_buffer_idx;  /* Index to above */
+  int image_buffer_idx;  /* Index to image buffer */
   size_t buf_size;
 
   unsigned char discr_op;     /* Detector output */
@@ -69,10 +232,14 @@ Wefax_Decode( void )
   /* Distance in pix of sync pulse from its required position */
   int sync_error;
 
+  /* Position and mean level of sync pulse for auto deslant */
+  int sync_pos, sync_level;
+
   /* File name string for saving images */
   static char
     file_name_jpg[ MAX_FILE_NAME ],
-    file_name_pgm[ MAX_FILE_NAME ];
+    file_name_pgm[ MAX_FILE_NAME ],
+    file_name_raw[ MAX_FILE_NAME ];
 
   /* File pointer for above */
   FILE *fp = NULL;
@@ -97,12 +264,29 @@ Wefax_Decode( void )
     /* Make a file name for the WEFAX image */
     File_Name( file_name_jpg, "jpg" );
     File_Name( file_name_pgm, "pgm" );
+    File_Name( file_name_raw, "raw" );
+
+    /* Record the discriminator output for re-rendering, with
+     * the pixels from its start to the image's first pixel.
+     * Only the zero crossing detector records its crossings */
+    if( isFlagSet(SAVE_IMAGE_RAW) && isFlagSet(SAVE_IMAGE) &&
+        (FM_Detector == FM_Detect_Bilevel) )
+      Show_Message( _("Raw file needs the zero crossing detector"), "red" );
+    else if( isFlagSet(SAVE_IMAGE_RAW) && isFlagSet(SAVE_IMAGE) )
+    {
+      int phase = linebuff_output - linebuff_input;
+      if( phase < 0 ) phase += rc_data.line_buffer_size;
+      if( phase >= rc_data.pixels_per_line )
+        phase -= rc_data.line_buffer_size;
+      Raw_Open( file_name_raw, (double)phase );
+    }
 
-    /* Fill pixbuf with background color */
-    gdk_pixbuf_fill( wefax_pixbuf, PIXBUF_BACKGND );
-    gtk_widget_queue_draw( wefax_drawingarea );
+    /* Clear image viewer to background color */
+    Viewer_Clear();
+    Enhance_Reset();
 
     /* Initialize statics */
+    bzero( &deslant, sizeof(deslant) );
     pixel_idx = 0;
     line_count = 0;
     discr_op_ave = 0.0;
@@ -125,6 +309,9 @@ Wefax_Decode( void )
   /* Stop on user request */
   if( isFlagSet(RECEIVE_STOP) && line_count )
   {
+    Enhanced_Lines( image_buffer, TRUE );
+    Raw_Close();
+
     /* Open file and save WEFAX PGM image */
     if( isFlagSet(SAVE_IMAGE_PGM) && isFlagSet(SAVE_IMAGE) )
     {
@@ -170,6 +357,10 @@ Wefax_Decode( void )
 
     if( line_count )
     {
+      Enhanced_Lines( image_buffer, TRUE );
+      Raw_Close();
+      Record_Chart();
+
       /* Open file and save WEFAX PGM image */
       if( isFlagSet(SAVE_IMAGE_PGM) && isFlagSet(SAVE_IMAGE) )
       {
@@ -267,9 +458,33 @@ Wefax_Decode( void )
       linebuff_output = 0;
   } /* for( pixel_idx = 0; pixel_idx < rc_data.pixels_per ... */
 
+  /* Line is complete with the last sample taken */
+  PERF_LINE( line_count );
+
   if( isFlagClear(INIMAGE_PHASING) )
     sync_correct = 0;
 
+  /* Track the drift of the sync pulse, its position
+   * is corrected for the in-image phasing shifts */
+  if( isFlagSet(AUTO_DESLANT) )
+  {
+    sync_pos = Sync_Pulse_Position(
+        &image_buffer[image_buffer_idx], &sync_level );
+    if( sync_level < DESLANT_PULSE_LEVEL )
+      Auto_Deslant( line_count, sync_pos - sync_pos_ref );
+
+    /* Shift the pulse back a pixel per line, unless
+     * in-image phasing keeps it in place instead */
+    if( isFlagClear(INIMAGE_PHASING) && deslant.shift )
+    {
+      int step = ( deslant.shift > 0 ) ? 1 : -1;
+      linebuff_input -= step;
+      sync_pos_ref   -= step;
+      deslant.shift  -= step;
+      deslant.shifted -= step;
+    }
+  }
+
   /* Correct sync error one pixel at a time if enabled */
   if( isFlagSet(INIMAGE_PHASING) &&
       (discr_op_max > INIMAGE_SYNC_THRESHOLD) )
@@ -313,21 +528,21 @@ Wefax_Decode( void )
     Normalize( &image_buffer[norm_idx], norm_len );
   }
 
-  /* Fill pixels of display buffer from the image line */
-  for( pixel_idx = 0; pixel_idx < rc_data.pixels_per_line; pixel_idx++ )
+  /* Enter image line to viewer, draws the (partial) image.
+   * Adaptive contrast lines are entered as the worker returns
+   * them. If its queue is full, it is drained as in Raw_Enhance()
+   * and the line queued again, else the line is entered as is */
+  if( rc_data.image_enhance != ENHANCE_ADAPTIVE )
+    Viewer_Add_Line( &image_buffer[image_buffer_idx], line_count );
+  else if( !Enhance_Put_Line(&image_buffer[image_buffer_idx],
+        rc_data.pixels_per_line, line_count) )
   {
-    pixel =
-      pixel_buf +
-      n_channels * pixel_idx +
-      line_count * rowstride;
-
-    pixel[0] = image_buffer[ image_buffer_idx + pixel_idx ];
-    pixel[1] = image_buffer[ image_buffer_idx + pixel_idx ];
-    pixel[2] = image_buffer[ image_buffer_idx + pixel_idx ];
-  } /* for( pixel_idx = 0; pixel_idx < rc_data.pixels_per ... */
-
-  /* Draw the (partial) image */
-  gtk_widget_queue_draw( wefax_drawingarea );
+    Enhanced_Lines( image_buffer, TRUE );
+    if( !Enhance_Put_Line(&image_buffer[image_buffer_idx],
+          rc_data.pixels_per_line, line_count) )
+      Viewer_Add_Line( &image_buffer[image_buffer_idx], line_count );
+  }
+  Enhanced_Lines( image_buffer, FALSE );
 
   /* Wait for GTK to complete its tasks */
   while( g_main_context_iteration(NULL, FALSE) );
@@ -365,6 +580,10 @@ Wefax_Decode( void )
   /* End image decode and save */
   if( stop && line_count )
   {
+    Enhanced_Lines( image_buffer, TRUE );
+    Raw_Close();
+    Record_Chart();
+
     /* Open file and save WEFAX JPEG image */
     if( isFlagSet(SAVE_IMAGE_JPG) && isFlagSet(SAVE_IMAGE) )
     {
@@ -412,6 +631,45 @@ Wefax_Decode( void )
 
 /*------------------------------------------------------------------------*/
 
+/* Wefax_Decode_Headless()
+ *
+ * Runs the start tone, phasing and image decoders without
+ * the GUI, until an image is decoded or the signal ends.
+ * The image is valid until the next call of the decoder
+ */
+  gboolean
+Wefax_Decode_Headless( unsigned char **image, int *lines )
+{
+  SetFlag( START_NEW_IMAGE );
+  wefax_action = ACTION_START;
+
+  while( TRUE )
+  {
+    switch( wefax_action )
+    {
+      case ACTION_START: /* Looking for WEFAX start tone */
+        if( !Start_Tone_Detect() ) return( FALSE );
+        break;
+
+      case ACTION_PHASING: /* Sync with WEFAX phasing pulses */
+        if( !Phasing_Detect() ) return( FALSE );
+        break;
+
+      case ACTION_DECODE: /* Decode WEFAX images */
+        if( !Wefax_Decode() ) return( FALSE );
+        break;
+
+      default: /* Image decoded and decoder reset */
+        *image = image_buffer;
+        *lines = line_count;
+        return( TRUE );
+    }
+  }
+
+} /* Wefax_Decode_Headless() */
+
+/*------------------------------------------------------------------------*/
+
 /* Wefax_Control()
  *
  * Central control function that
@@ -468,6 +726,10 @@ Wefax_Control( gpointer data )
   if( isFlagSet(SAVE_STATIONS) )
     Save_Stations_File( rc_data.stations_file );
 
+  /* Save spectrum settings if changed by user */
+  if( isFlagSet(SAVE_SPECTRUM) )
+    Save_Spectrum_Settings();
+
   /* Direct program flow according
    * to currently selected action */
   switch( wefax_action )
@@ -548,7 +810,7 @@ Wefax_Drawingarea_Button_Press( GdkEventButton  *event )
    * column of button press to the beginnig of line */
   if( event->button == 1 )
   {
-    linebuff_input -= (int)(event->x + 0.5);
+    linebuff_input -= (int)( Viewer_Image_X(event->x) + 0.5 );
     if( linebuff_input < 0 )
       linebuff_input += rc_data.line_buffer_size;
  }
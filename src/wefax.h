@@ -18,9 +18,6 @@
 #include "shared.h"
 #include "display.h"
 
-/* Pixel value threshold for bilevel (0/255) image */
-#define BILEVEL_THRESHOLD       160
-
 /* Minimum in-image sync pulse level
  * before correction is applied */
 #define INIMAGE_SYNC_THRESHOLD  -150
@@ -30,4 +27,15 @@
 
 #define INIMAGE_PHASING_RANGE   80
 
+/* Auto deslant: the largest mean level of a sync pulse,
+ * lines of sync pulse positions per regression fit, the
+ * distance of positions used from their median, pix, the
+ * largest RMS deviation of them from the fitted line, pix,
+ * and the largest slant corrected at once, pix/line */
+#define DESLANT_PULSE_LEVEL     64
+#define DESLANT_FIT_LINES       24
+#define DESLANT_INLIER_RANGE    16
+#define DESLANT_MAX_RESIDUAL    2.0
+#define DESLANT_MAX_SLANT       1.0
+
 #endif